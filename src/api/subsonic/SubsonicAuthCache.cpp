@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SubsonicAuthCache.hpp"
+
+#include <Wt/Utils.h>
+#include <Wt/WRandom.h>
+
+namespace API::Subsonic
+{
+
+AuthCache::AuthCache(std::size_t maxEntries, std::chrono::seconds ttl)
+: _maxEntries {maxEntries},
+_ttl {ttl},
+_key {Wt::WRandom::generateId(32)}
+{
+}
+
+bool
+AuthCache::isValid(const std::string& user, const std::string& password, const std::string& passwordHash)
+{
+	if (!isEnabled())
+		return false;
+
+	const std::string key {computeKey(user, password)};
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_entries.find(key)};
+	if (it == _entries.end())
+		return false;
+
+	if (it->second.expiry <= std::chrono::steady_clock::now() || it->second.passwordHash != passwordHash)
+	{
+		_entries.erase(it);
+		return false;
+	}
+
+	return true;
+}
+
+void
+AuthCache::add(const std::string& user, const std::string& password, const std::string& passwordHash)
+{
+	if (!isEnabled())
+		return;
+
+	const std::string key {computeKey(user, password)};
+	const auto now {std::chrono::steady_clock::now()};
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	if (_entries.size() >= _maxEntries && _entries.find(key) == _entries.end())
+	{
+		removeExpiredEntries(now);
+
+		// Still full: make room by dropping any entry
+		if (_entries.size() >= _maxEntries)
+			_entries.erase(_entries.begin());
+	}
+
+	_entries[key] = Entry {passwordHash, now + _ttl};
+}
+
+std::string
+AuthCache::computeKey(const std::string& user, const std::string& password) const
+{
+	return Wt::Utils::sha1(_key + user + '\0' + password);
+}
+
+void
+AuthCache::removeExpiredEntries(std::chrono::steady_clock::time_point now)
+{
+	for (auto it {_entries.begin()}; it != _entries.end();)
+	{
+		if (it->second.expiry <= now)
+			it = _entries.erase(it);
+		else
+			++it;
+	}
+}
+
+} // namespace API::Subsonic
+
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace API::Subsonic
+{
+
+// Successful password verifications, to avoid hashing the password on each request
+// Entries are keyed by a keyed hash of the credentials: passwords are never kept in memory
+// An entry is only valid as long as the stored password hash of the user is unchanged,
+// so that changing a password invalidates the cached verifications of this user
+class AuthCache
+{
+	public:
+		AuthCache(std::size_t maxEntries, std::chrono::seconds ttl);
+
+		bool isEnabled() const { return _maxEntries > 0 && _ttl.count() > 0; }
+
+		bool isValid(const std::string& user, const std::string& password, const std::string& passwordHash);
+		void add(const std::string& user, const std::string& password, const std::string& passwordHash);
+
+	private:
+		std::string computeKey(const std::string& user, const std::string& password) const;
+		void removeExpiredEntries(std::chrono::steady_clock::time_point now);
+
+		struct Entry
+		{
+			std::string				passwordHash;
+			std::chrono::steady_clock::time_point	expiry;
+		};
+
+		const std::size_t		_maxEntries;
+		const std::chrono::seconds	_ttl;
+		const std::string		_key;	// random, generated at startup
+
+		std::mutex					_mutex;
+		std::unordered_map<std::string, Entry>		_entries;
+};
+
+} // namespace API::Subsonic
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SubsonicLoginThrottle.hpp"
+
+namespace API::Subsonic
+{
+
+LoginThrottle::LoginThrottle(std::size_t maxFailures, std::chrono::seconds window)
+: _maxFailures {maxFailures},
+_window {window}
+{
+}
+
+bool
+LoginThrottle::isThrottled(const std::string& user)
+{
+	if (!isEnabled())
+		return false;
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_failures.find(user)};
+	if (it == _failures.end())
+		return false;
+
+	removeExpiredFailures(it->second, std::chrono::steady_clock::now());
+	if (it->second.empty())
+	{
+		_failures.erase(it);
+		return false;
+	}
+
+	return it->second.size() >= _maxFailures;
+}
+
+void
+LoginThrottle::addFailure(const std::string& user)
+{
+	if (!isEnabled())
+		return;
+
+	const auto now {std::chrono::steady_clock::now()};
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	Failures& failures {_failures[user]};
+	removeExpiredFailures(failures, now);
+
+	failures.push_back(now);
+	if (failures.size() > _maxFailures)
+		failures.pop_front();
+}
+
+void
+LoginThrottle::addSuccess(const std::string& user)
+{
+	if (!isEnabled())
+		return;
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	_failures.erase(user);
+}
+
+void
+LoginThrottle::removeExpiredFailures(Failures& failures, std::chrono::steady_clock::time_point now) const
+{
+	while (!failures.empty() && failures.front() + _window <= now)
+		failures.pop_front();
+}
+
+} // namespace API::Subsonic
+
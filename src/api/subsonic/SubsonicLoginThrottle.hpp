@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace API::Subsonic
+{
+
+// Failed password verifications of each user, kept in memory for the read replicas,
+// since they cannot record the login attempts in the database as the primary does
+// A user is refused once maxFailures verifications failed within the window
+class LoginThrottle
+{
+	public:
+		LoginThrottle(std::size_t maxFailures, std::chrono::seconds window);
+
+		bool isEnabled() const { return _maxFailures > 0 && _window.count() > 0; }
+
+		bool isThrottled(const std::string& user);
+		void addFailure(const std::string& user);
+		void addSuccess(const std::string& user);
+
+	private:
+		using Failures = std::deque<std::chrono::steady_clock::time_point>;
+
+		void removeExpiredFailures(Failures& failures, std::chrono::steady_clock::time_point now) const;
+
+		const std::size_t		_maxFailures;
+		const std::chrono::seconds	_window;
+
+		std::mutex					_mutex;
+		std::unordered_map<std::string, Failures>	_failures;	// only existing users
+};
+
+} // namespace API::Subsonic
+
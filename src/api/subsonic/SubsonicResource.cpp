@@ -19,25 +19,37 @@
 #include "SubsonicResource.hpp"
 
 #include <mutex>
-#include <numeric>
 #include <random>
+#include <set>
+#include <sstream>
+
+#include <boost/algorithm/string/case_conv.hpp>
 
 #include <Wt/Auth/Identity.h>
+#include <Wt/Utils.h>
 #include <Wt/WLocalDateTime.h>
 
-#include "av/AvTranscoder.hpp"
+#include "av/AvTranscodeCache.hpp"
+#include "av/AvTranscodeRegistry.hpp"
+#include "av/AvTranscodeResourceHandler.hpp"
+#include "catalog/CatalogScannerAddon.hpp"
 #include "cover/CoverArtGrabber.hpp"
 #include "database/Artist.hpp"
 #include "database/Cluster.hpp"
 #include "database/Release.hpp"
 #include "database/Track.hpp"
 #include "database/TrackList.hpp"
+#include "database/WriteTransaction.hpp"
 #include "main/Service.hpp"
+#include "random/RandomSampler.hpp"
 #include "similarity/SimilaritySearcher.hpp"
+#include "utils/Config.hpp"
+#include "utils/FileResourceHandler.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Utils.hpp"
 #include "SubsonicId.hpp"
 #include "SubsonicResponse.hpp"
+#include "SubsonicResponseCache.hpp"
 
 static const std::string	genreClusterName {"GENRE"};
 // Files are always reported to be in the same format
@@ -76,6 +88,7 @@ static const Av::Encoding	transcodeEncoding {Av::Encoding::MP3};
 #define UPDATE_PLAYLIST_URL	"/rest/updatePlaylist.view"
 
 // MediaRetrievals
+#define DOWNLOAD_URL		"/rest/download.view"
 #define STREAM_URL		"/rest/stream.view"
 #define GET_COVER_ART_URL	"/rest/getCoverArt.view"
 
@@ -104,7 +117,9 @@ struct ClientInfo
 {
 	std::string name;
 	std::string user;
-	std::string password;
+	boost::optional<std::string> password;
+	boost::optional<std::string> token;	// hex encoded md5(secret + salt)
+	std::string salt;
 };
 
 struct RequestContext
@@ -127,11 +142,8 @@ static Response handleGetAlbumRequest(RequestContext& context);
 static Response handleGetArtistRequest(RequestContext& context);
 static Response handleGetArtistInfoRequest(RequestContext& context);
 static Response handleGetArtistInfo2Request(RequestContext& context);
-static Response handleGetArtistsRequest(RequestContext& context);
-static Response handleGetMusicDirectoryRequest(RequestContext& context);
 static Response handleGetMusicFoldersRequest(RequestContext& context);
 static Response handleGetGenresRequest(RequestContext& context);
-static Response handleGetIndexesRequest(RequestContext& context);
 static Response handleGetSimilarSongsRequest(RequestContext& context);
 static Response handleGetSimilarSongs2Request(RequestContext& context);
 static Response handleGetStarredRequest(RequestContext& context);
@@ -143,16 +155,27 @@ static Response handleSearch2Request(RequestContext& context);
 static Response handleSearch3Request(RequestContext& context);
 static Response handleUpdatePlaylistRequest(RequestContext& context);
 
+// Requests with large responses, written as they are built
+// Errors must be thrown before the first node is created
+using StreamingRequestHandlerFunc = std::function<void(RequestContext& context, ResponseWriter& writer)>;
+static void handleGetArtistsRequest(RequestContext& context, ResponseWriter& writer);
+static void handleGetIndexesRequest(RequestContext& context, ResponseWriter& writer);
+static void handleGetMusicDirectoryRequest(RequestContext& context, ResponseWriter& writer);
+
 // MediaRetrievals
 struct MediaRetrievalResult
 {
 	std::string mimeType;
 	std::vector<uint8_t> data;
-	Wt::cpp17::any continuationData;
+
+	// If set, the response is produced by the handler, with the given extra headers
+	std::shared_ptr<ResourceHandler> resourceHandler;
+	std::vector<std::pair<std::string, std::string>> headers;
 };
-using MediaRetrievalHandlerFunc = std::function<MediaRetrievalResult(RequestContext&, Wt::Http::ResponseContinuation*)>;
-MediaRetrievalResult handleStream(RequestContext& context, Wt::Http::ResponseContinuation* continuation);
-MediaRetrievalResult handleGetCoverArt(RequestContext& context, Wt::Http::ResponseContinuation* continuation);
+using MediaRetrievalHandlerFunc = std::function<MediaRetrievalResult(RequestContext&)>;
+MediaRetrievalResult handleDownload(RequestContext& context);
+MediaRetrievalResult handleStream(RequestContext& context);
+MediaRetrievalResult handleGetCoverArt(RequestContext& context);
 
 static std::map<std::string, RequestHandlerFunc> requestHandlers
 {
@@ -167,11 +190,8 @@ static std::map<std::string, RequestHandlerFunc> requestHandlers
 	{GET_ARTIST_URL,		handleGetArtistRequest},
 	{GET_ARTIST_INFO_URL,		handleGetArtistInfoRequest},
 	{GET_ARTIST_INFO2_URL,		handleGetArtistInfo2Request},
-	{GET_ARTISTS_URL,		handleGetArtistsRequest},
-	{GET_MUSIC_DIRECTORY_URL,	handleGetMusicDirectoryRequest},
 	{GET_MUSIC_FOLDERS_URL,		handleGetMusicFoldersRequest},
 	{GET_GENRES_URL,		handleGetGenresRequest},
-	{GET_INDEXES_URL,		handleGetIndexesRequest},
 	{GET_SIMILAR_SONGS_URL,		handleGetSimilarSongsRequest},
 	{GET_SIMILAR_SONGS2_URL,	handleGetSimilarSongs2Request},
 	{GET_STARRED_URL,		handleGetStarredRequest},
@@ -184,8 +204,16 @@ static std::map<std::string, RequestHandlerFunc> requestHandlers
 	{UPDATE_PLAYLIST_URL,		handleUpdatePlaylistRequest},
 };
 
+static std::map<std::string, StreamingRequestHandlerFunc> streamingRequestHandlers
+{
+	{GET_ARTISTS_URL,		handleGetArtistsRequest},
+	{GET_INDEXES_URL,		handleGetIndexesRequest},
+	{GET_MUSIC_DIRECTORY_URL,	handleGetMusicDirectoryRequest},
+};
+
 static std::map<std::string, MediaRetrievalHandlerFunc> mediaRetrievalHandlers
 {
+	{DOWNLOAD_URL,			handleDownload},
 	{STREAM_URL,			handleStream},
 	{GET_COVER_ART_URL,		handleGetCoverArt},
 };
@@ -265,6 +293,14 @@ getClientInfo(const Wt::Http::ParameterMap& parameters)
 	res.name = getMandatoryParameterAs<std::string>(parameters, "c");
 	res.user = getMandatoryParameterAs<std::string>(parameters, "u");
 
+	// Token authentication takes precedence
+	res.token = getParameterAs<std::string>(parameters, "t");
+	if (res.token)
+	{
+		res.salt = getMandatoryParameterAs<std::string>(parameters, "s");
+		return res;
+	}
+
 	{
 		std::string password {getMandatoryParameterAs<std::string>(parameters, "p")};
 		if (password.find("enc:") == 0)
@@ -282,9 +318,37 @@ getClientInfo(const Wt::Http::ParameterMap& parameters)
 	return res;
 }
 
+// Does not stop at the first difference, not to leak the secrets through timings
+static
+bool
+secretEquals(const std::string& a, const std::string& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	unsigned char diff {};
+	for (std::size_t i {}; i < a.size(); ++i)
+		diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+
+	return diff == 0;
+}
+
+static
+std::string
+getSubsonicApiSecret(Database::Handler& db, const Wt::Auth::User& authUser)
+{
+	Wt::Dbo::Transaction transaction {db.getSession()};
+
+	Database::User::pointer user {db.getUser(authUser)};
+	return user ? user->getSubsonicApiSecret() : "";
+}
+
+// Clients either use the API secret of the user, in a salted token or as a password, or the account password
+// Verified account passwords are cached, to avoid hashing them again on each request
+// If readOnly is set, the login attempts are not recorded: no throttling
 static
 bool
-checkPassword(Database::Handler& db, const ClientInfo& clientInfo)
+checkPassword(Database::Handler& db, AuthCache& authCache, LoginThrottle& loginThrottle, const ClientInfo& clientInfo, bool readOnly)
 {
 	auto authUser {db.getUserDatabase().findWithIdentity(Wt::Auth::Identity::LoginName, clientInfo.user)};
 	if (!authUser.isValid())
@@ -293,12 +357,88 @@ checkPassword(Database::Handler& db, const ClientInfo& clientInfo)
 		return false;
 	}
 
-	return db.getPasswordService().verifyPassword(authUser, clientInfo.password) == Wt::Auth::PasswordResult::PasswordValid;
+	const std::string secret {getSubsonicApiSecret(db, authUser)};
+
+	if (clientInfo.token)
+	{
+		if (secret.empty())
+		{
+			LMS_LOG(API_SUBSONIC, ERROR) << "Token authentication requested but user '" << clientInfo.user << "' has no API secret";
+			return false;
+		}
+
+		return secretEquals(Wt::Utils::hexEncode(Wt::Utils::md5(secret + clientInfo.salt)), boost::algorithm::to_lower_copy(*clientInfo.token));
+	}
+
+	const std::string& password {*clientInfo.password};
+
+	// Read replicas cannot record the login attempts in the database, the failures are throttled in memory instead
+	if (readOnly && loginThrottle.isThrottled(clientInfo.user))
+	{
+		LMS_LOG(API_SUBSONIC, ERROR) << "Too many failed login attempts for user '" << clientInfo.user << "'";
+		return false;
+	}
+
+	if (!secret.empty() && secretEquals(password, secret))
+		return true;
+
+	const std::string passwordHash {authUser.password().value()};
+	if (authCache.isValid(clientInfo.user, password, passwordHash))
+		return true;
+
+	bool valid;
+	if (readOnly)
+	{
+		valid = db.getPasswordService().verifier()->verify(password, authUser.password());
+		if (valid)
+			loginThrottle.addSuccess(clientInfo.user);
+		else
+			loginThrottle.addFailure(clientInfo.user);
+	}
+	else
+	{
+		// The login attempt is recorded
+		Database::WriteTransaction transaction {db.getSession()};
+		valid = db.getPasswordService().verifyPassword(authUser, password) == Wt::Auth::PasswordResult::PasswordValid;
+	}
+
+	if (valid)
+		authCache.add(clientInfo.user, password, passwordHash);
+
+	return valid;
 }
 
 SubsonicResource::SubsonicResource(Wt::Dbo::SqlConnectionPool& connectionPool)
-: _db {connectionPool}
+: _connectionPool {connectionPool},
+_readOnly {Config::instance().getBool("read-replica", false)},
+_authCache {Config::instance().getULong("api-subsonic-auth-cache-size", 1000), std::chrono::seconds {Config::instance().getULong("api-subsonic-auth-cache-ttl", 600)}},
+_loginThrottle {Config::instance().getULong("read-replica-login-max-failures", 5), std::chrono::seconds {Config::instance().getULong("read-replica-login-throttle-window", 300)}}
+{
+}
+
+std::unique_ptr<Database::Handler>
+SubsonicResource::acquireDbHandler()
 {
+	{
+		std::unique_lock<std::mutex> lock {_dbHandlersMutex};
+
+		if (!_dbHandlers.empty())
+		{
+			std::unique_ptr<Database::Handler> db {std::move(_dbHandlers.back())};
+			_dbHandlers.pop_back();
+			return db;
+		}
+	}
+
+	return std::make_unique<Database::Handler>(_connectionPool);
+}
+
+void
+SubsonicResource::releaseDbHandler(std::unique_ptr<Database::Handler> db)
+{
+	std::unique_lock<std::mutex> lock {_dbHandlersMutex};
+
+	_dbHandlers.push_back(std::move(db));
 }
 
 std::vector<std::string>
@@ -309,6 +449,9 @@ SubsonicResource::getPaths()
 	for (auto it : requestHandlers)
 		paths.emplace_back(it.first);
 
+	for (auto it : streamingRequestHandlers)
+		paths.emplace_back(it.first);
+
 	for (auto it : mediaRetrievalHandlers)
 		paths.emplace_back(it.first);
 
@@ -348,6 +491,58 @@ std::string parameterMapToDebugString(const Wt::Http::ParameterMap& parameterMap
 	return res;
 }
 
+// Responses of these requests only change when the database does
+static
+bool
+isCacheable(const std::string& path, const Wt::Http::ParameterMap& parameters)
+{
+	if (path == GET_INDEXES_URL
+		|| path == GET_ARTISTS_URL
+		|| path == GET_GENRES_URL
+		|| path == GET_MUSIC_FOLDERS_URL)
+		return true;
+
+	if (path == GET_ALBUM_LIST_URL || path == GET_ALBUM_LIST2_URL)
+		return getParameterAs<std::string>(parameters, "type") == std::string {"alphabeticalByName"};
+
+	return false;
+}
+
+// The request without the authentication and client parameters
+static
+std::string
+getCacheKey(const std::string& path, const Wt::Http::ParameterMap& parameters)
+{
+	static const std::set<std::string> ignoredParameters {"c", "p", "s", "t", "u", "v"};
+
+	std::string res {path};
+	for (const auto& itParameter : parameters)
+	{
+		if (ignoredParameters.find(itParameter.first) != ignoredParameters.end())
+			continue;
+
+		for (const std::string& value : itParameter.second)
+			res += "&" + itParameter.first + "=" + value;
+	}
+
+	return res;
+}
+
+static
+long long
+toMilliseconds(std::chrono::system_clock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+static
+std::string
+computeETag(const ResponseCache::Version& version, const std::string& userName, const std::string& cacheKey)
+{
+	return "\"" + std::to_string(toMilliseconds(version.lastModified)) + "." + std::to_string(version.generation)
+		+ "-" + Wt::Utils::hexEncode(Wt::Utils::md5(userName + '\0' + cacheKey)) + "\"";
+}
+
 void
 SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Response &response)
 {
@@ -358,37 +553,135 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 	// Optional parameters
 	ResponseFormat format {getParameterAs<std::string>(parameters, "f").get_value_or("xml") == "json" ? ResponseFormat::json : ResponseFormat::xml};
 
-	try
+	// Media being served are continued directly
+	if (Wt::Http::ResponseContinuation* continuation {request.continuation()})
 	{
-		static std::mutex mutex;
+		Wt::cpp17::any_cast<std::shared_ptr<ResourceHandler>>(continuation->data())->processRequest(request, response);
+		return;
+	}
 
-		ClientInfo clientInfo {getClientInfo(parameters)};
+	// Released as soon as the database is no longer needed, before writing the response
+	std::unique_ptr<Database::Handler> db {acquireDbHandler()};
+	const auto releaseDb {[&]
+	{
+		if (db)
+			releaseDbHandler(std::move(db));
+	}};
 
-		std::unique_lock<std::mutex> lock{mutex}; // For now just handle request s one by one
+	// Streamed responses cannot be replaced by an error once their first bytes are sent
+	std::unique_ptr<ResponseWriter> writer;
+	const auto writeFailedResponse {[&](const Error& error)
+	{
+		if (writer && writer->isStarted())
+		{
+			LMS_LOG(API_SUBSONIC, ERROR) << "Response truncated";
+			return;
+		}
+
+		Response resp {Response::createFailedResponse(error)};
+		resp.write(response.out(), format);
+		response.setMimeType(ResponseFormatToMimeType(format));
+	}};
+
+	try
+	{
+		ClientInfo clientInfo {getClientInfo(parameters)};
 
-		if (!checkPassword(_db, clientInfo))
+		if (!checkPassword(*db, _authCache, _loginThrottle, clientInfo, _readOnly))
 			throw Error {Error::Code::WrongUsernameOrPassword};
 
-		RequestContext requestContext {.parameters = parameters, .db = _db, .userName = clientInfo.user};
+		RequestContext requestContext {.parameters = parameters, .db = *db, .userName = clientInfo.user};
 
 		auto itHandler {requestHandlers.find(request.path())};
+		auto itStreamingHandler {streamingRequestHandlers.find(request.path())};
+		const bool hasResponseHandler {itHandler != requestHandlers.end() || itStreamingHandler != streamingRequestHandlers.end()};
+		ResponseCache* responseCache {getService<ResponseCache>()};
+		if (hasResponseHandler && responseCache && isCacheable(request.path(), parameters))
+		{
+			const ResponseCache::Version version {responseCache->getVersion()};
+			const std::string cacheKey {getCacheKey(request.path(), parameters)};
+			const std::string etag {computeETag(version, clientInfo.user, cacheKey)};
+
+			if (matchesETag(request.headerValue("If-None-Match"), etag))
+			{
+				releaseDb();
+				response.setStatus(304);
+				return;
+			}
+
+			boost::optional<std::string> body {responseCache->get(cacheKey)};
+			if (!body)
+			{
+				std::ostringstream oss;
+				if (itHandler != requestHandlers.end())
+				{
+					Response resp {(itHandler->second)(requestContext)};
+
+					releaseDb();
+
+					resp.write(oss, format);
+				}
+				else
+				{
+					ResponseWriter bodyWriter {oss, format};
+					(itStreamingHandler->second)(requestContext, bodyWriter);
+
+					releaseDb();
+
+					bodyWriter.finish();
+				}
+				body = oss.str();
+				responseCache->add(cacheKey, *body, version);
+			}
+
+			releaseDb();
+
+			response.addHeader("ETag", etag);
+			response.addHeader("Cache-Control", "private, no-cache");
+			response.setMimeType(ResponseFormatToMimeType(format));
+			response.out() << *body;
+			return;
+		}
+
 		if (itHandler != requestHandlers.end())
 		{
 			Response resp {(itHandler->second)(requestContext)};
 
-			lock.unlock();
+			releaseDb();
 
 			resp.write(response.out(), format);
 			response.setMimeType(ResponseFormatToMimeType(format));
 			return;
 		}
 
+		if (itStreamingHandler != streamingRequestHandlers.end())
+		{
+			response.setMimeType(ResponseFormatToMimeType(format));
+
+			writer = std::make_unique<ResponseWriter>(response.out(), format);
+			(itStreamingHandler->second)(requestContext, *writer);
+
+			releaseDb();
+
+			writer->finish();
+			return;
+		}
+
 		auto itStreamHandler {mediaRetrievalHandlers.find(request.path())};
 		if (itStreamHandler != mediaRetrievalHandlers.end())
 		{
-			MediaRetrievalResult res {itStreamHandler->second(requestContext, request.continuation())};
+			MediaRetrievalResult res {itStreamHandler->second(requestContext)};
+
+			releaseDb();
 
-			lock.unlock();
+			if (res.resourceHandler)
+			{
+				for (const auto& header : res.headers)
+					response.addHeader(header.first, header.second);
+
+				res.resourceHandler->processRequest(request, response);
+				return;
+			}
 
 			if (!res.mimeType.empty())
 				response.setMimeType(res.mimeType);
@@ -402,12 +695,7 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 				}
 			}
 
-			if (res.continuationData.has_value())
-			{
-				auto continuation {response.createContinuation()};
-				continuation->setData(std::move(res.continuationData));
-				return;
-			}
+			return;
 		}
 
 		LMS_LOG(API_SUBSONIC, ERROR) << "Unhandled command '" << request.path() << "'";
@@ -415,10 +703,20 @@ SubsonicResource::handleRequest(const Wt::Http::Request &request, Wt::Http::Resp
 	catch (const Error& e)
 	{
 		LMS_LOG(API_SUBSONIC, ERROR) << "Error while processing command. code = " << static_cast<int>(e.getCode()) << ", msg = '" << e.getMessage() << "'";
-		Response resp {Response::createFailedResponse(e)};
-		resp.write(response.out(), format);
-		response.setMimeType(ResponseFormatToMimeType(format));
+		writeFailedResponse(e);
+	}
+	catch (const Wt::Dbo::Exception& e)
+	{
+		LMS_LOG(API_SUBSONIC, ERROR) << "Database error while processing command: " << e.what();
+
+		// The session may hold objects out of sync with the database
+		db.reset();
+
+		writeFailedResponse(Error {Error::CustomType::InternalError});
 	}
+
+	// Handlers interrupted by other exceptions are not reused
+	releaseDb();
 }
 
 static
@@ -606,17 +904,50 @@ artistToResponseNode(const Database::Artist::pointer& artist, bool id3)
 
 static
 Response::Node
-clusterToResponseNode(const Database::Cluster::pointer& cluster)
+artistToResponseNode(const Catalog::Snapshot& snapshot, const Catalog::Snapshot::Artist& artist, bool id3)
 {
-	Response::Node clusterNode;
+	Response::Node artistNode;
 
-	clusterNode.setValue(cluster->getName());
-	clusterNode.setAttribute("songCount", std::to_string(cluster->getTrackIds().size()));
+	artistNode.setAttribute("id", IdToString({Id::Type::Artist, artist.id}));
+	artistNode.setAttribute("name", snapshot.getString(artist.name));
+
+	if (id3)
+		artistNode.setAttribute("albumCount", std::to_string(snapshot.getReleaseIds(artist).size()));
+
+	return artistNode;
+}
+
+// Add all the artists, ordered by name
+static
+void
+addArtistNodes(RequestContext& context, ResponseWriter::Node& node, const std::string& childName, bool id3)
+{
+	Catalog::ScannerAddon* catalog {getService<Catalog::ScannerAddon>()};
+	if (std::shared_ptr<const Catalog::Snapshot> snapshot {catalog ? catalog->getSnapshot() : nullptr})
 	{
-		auto releases {Database::Release::getByFilter(*cluster.session(), {cluster.id()})};
-		clusterNode.setAttribute("albumCount", std::to_string(releases.size()));
+		for (const Catalog::Snapshot::Artist* artist : snapshot->getArtistsByName())
+			node.addArrayChild(childName, artistToResponseNode(*snapshot, *artist, id3));
+
+		return;
 	}
 
+	Wt::Dbo::Transaction transaction {context.db.getSession()};
+
+	auto artists {Database::Artist::getAll(context.db.getSession())};
+	for (const Database::Artist::pointer& artist : artists)
+		node.addArrayChild(childName, artistToResponseNode(artist, id3));
+}
+
+static
+Response::Node
+clusterToResponseNode(const Database::ClusterType::ClusterStats& clusterStats)
+{
+	Response::Node clusterNode;
+
+	clusterNode.setValue(clusterStats.name);
+	clusterNode.setAttribute("songCount", std::to_string(clusterStats.trackCount));
+	clusterNode.setAttribute("albumCount", std::to_string(clusterStats.releaseCount));
+
 	return clusterNode;
 }
 
@@ -644,7 +975,7 @@ handleCreatePlaylistRequest(RequestContext& context)
 	if (!name && !id)
 		throw Error {Error::Code::RequiredParameterMissing};
 
-	Wt::Dbo::Transaction transaction {context.db.getSession()};
+	Database::WriteTransaction transaction {context.db.getSession()};
 
 	Database::User::pointer user {context.db.getUser(context.userName)};
 	if (!user)
@@ -669,14 +1000,10 @@ handleCreatePlaylistRequest(RequestContext& context)
 		tracklist = Database::TrackList::create(context.db.getSession(), *name, Database::TrackList::Type::Playlist, false, user);
 	}
 
-	for (const Id& trackId : trackIds)
-	{
-		Database::Track::pointer track {Database::Track::getById(context.db.getSession(), trackId.value)};
-		if (!track)
-			continue;
+	std::vector<Database::IdType> trackIdsToAdd;
+	std::transform(std::cbegin(trackIds), std::cend(trackIds), std::back_inserter(trackIdsToAdd), [](const Id& trackId) { return trackId.value; });
 
-		Database::TrackListEntry::create(context.db.getSession(), track, tracklist );
-	}
+	tracklist.modify()->add(trackIdsToAdd);
 
 	return Response::createOkResponse();
 }
@@ -689,7 +1016,7 @@ handleDeletePlaylistRequest(RequestContext& context)
 	if (id.type != Id::Type::Playlist)
 		throw Error {Error::CustomType::BadId};
 
-	Wt::Dbo::Transaction transaction {context.db.getSession()};
+	Database::WriteTransaction transaction {context.db.getSession()};
 
 	Database::User::pointer user {context.db.getUser(context.userName)};
 	if (!user)
@@ -730,7 +1057,18 @@ handleGetRandomSongsRequest(RequestContext& context)
 
 	Wt::Dbo::Transaction transaction {context.db.getSession()};
 
-	auto tracks {Database::Track::getAllRandom(context.db.getSession(), size)};
+	std::vector<Database::Track::pointer> tracks;
+	if (const Random::Sampler* sampler {getService<Random::Sampler>()})
+	{
+		for (Database::IdType trackId : sampler->getTrackIds(std::random_device {}(), 0, size))
+		{
+			Database::Track::pointer track {Database::Track::getById(context.db.getSession(), trackId)};
+			if (track)
+				tracks.emplace_back(std::move(track));
+		}
+	}
+	else
+		tracks = Database::Track::getAllRandom(context.db.getSession(), size);
 
 	Response response {Response::createOkResponse()};
 
@@ -744,31 +1082,18 @@ handleGetRandomSongsRequest(RequestContext& context)
 static
 std::vector<Database::Release::pointer> getRandomAlbums(Wt::Dbo::Session& session, std::size_t offset, std::size_t size)
 {
-	std::vector<Database::Release::pointer> res;
-
-	std::size_t nbReleases {Database::Release::getCount(session)};
-	if (offset > nbReleases)
-		return res;
-
-	if (offset + size > nbReleases)
-		size = nbReleases - offset;
-
-	std::vector<size_t> indexes;
-	indexes.resize(nbReleases);
-	std::iota(std::begin(indexes), std::end(indexes), 1);
+	const Random::Sampler* sampler {getService<Random::Sampler>()};
+	if (!sampler)
+		return offset == 0 ? Database::Release::getAllRandom(session, size) : std::vector<Database::Release::pointer> {};
 
-	// As random results are paginated, we need to set a seed for it
-	std::seed_seq seed {1337};
-	std::mt19937 generator{seed};
-
-	std::shuffle(std::begin(indexes), std::end(indexes), generator);
-	std::for_each(std::next(std::begin(indexes), offset), std::next(std::begin(indexes), offset + size),
-		[&](std::size_t offset)
-		{
-			auto release {Database::Release::getAll(session, offset, 1)};
-			if (!release.empty())
-				res.emplace_back(release.front());
-		});
+	// As random results are paginated, use the same seed until the next scan
+	std::vector<Database::Release::pointer> res;
+	for (Database::IdType releaseId : sampler->getReleaseIds(sampler->getSeed(), offset, size))
+	{
+		Database::Release::pointer release {Database::Release::getById(session, releaseId)};
+		if (release)
+			res.emplace_back(std::move(release));
+	}
 
 	return res;
 }
@@ -940,47 +1265,32 @@ static Response handleGetArtistInfo2Request(RequestContext& context)
 	return handleGetArtistInfoRequestCommon(context, true /* id3 */);
 }
 
-Response
-handleGetArtistsRequest(RequestContext& context)
+void
+handleGetArtistsRequest(RequestContext& context, ResponseWriter& writer)
 {
-	Response response {Response::createOkResponse()};
-	Response::Node& artistsNode {response.createNode("artists")};
+	ResponseWriter::Node artistsNode {writer.createNode("artists")};
 
-	Response::Node& indexNode {artistsNode.createArrayChild("index")};
+	ResponseWriter::Node indexNode {artistsNode.createArrayChild("index")};
 	indexNode.setAttribute("name", "?");
 
-	Wt::Dbo::Transaction transaction {context.db.getSession()};
-
-	auto artists {Database::Artist::getAll(context.db.getSession())};
-	for (const Database::Artist::pointer& artist : artists)
-		indexNode.addArrayChild("artist", artistToResponseNode(artist, true /* id3 */));
-
-	return response;
+	addArtistNodes(context, indexNode, "artist", true /* id3 */);
 }
 
-
-Response
-handleGetMusicDirectoryRequest(RequestContext& context)
+void
+handleGetMusicDirectoryRequest(RequestContext& context, ResponseWriter& writer)
 {
 	// Mandatory params
 	Id id {getMandatoryParameterAs<Id>(context.parameters, "id")};
 
-	Response response {Response::createOkResponse()};
-	Response::Node& directoryNode {response.createNode("directory")};
-
-	directoryNode.setAttribute("id", IdToString(id));
-
 	switch (id.type)
 	{
 		case Id::Type::Root:
 		{
-			Wt::Dbo::Transaction transaction {context.db.getSession()};
-
+			ResponseWriter::Node directoryNode {writer.createNode("directory")};
+			directoryNode.setAttribute("id", IdToString(id));
 			directoryNode.setAttribute("name", "Music");
 
-			auto artists {Database::Artist::getAll(context.db.getSession())};
-			for (const Database::Artist::pointer& artist : artists)
-				directoryNode.addArrayChild("child", artistToResponseNode(artist, false /* no id3 */));
+			addArtistNodes(context, directoryNode, "child", false /* no id3 */);
 
 			break;
 		}
@@ -993,6 +1303,8 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 			if (!artist)
 				throw Error {Error::Code::RequestedDataNotFound};
 
+			ResponseWriter::Node directoryNode {writer.createNode("directory")};
+			directoryNode.setAttribute("id", IdToString(id));
 			directoryNode.setAttribute("name", makeNameFilesystemCompatible(artist->getName()));
 
 			auto releases {artist->getReleases()};
@@ -1010,6 +1322,8 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 			if (!release)
 				throw Error {Error::Code::RequestedDataNotFound};
 
+			ResponseWriter::Node directoryNode {writer.createNode("directory")};
+			directoryNode.setAttribute("id", IdToString(id));
 			directoryNode.setAttribute("name", makeNameFilesystemCompatible(release->getName()));
 
 			auto tracks {release->getTracks()};
@@ -1022,8 +1336,6 @@ handleGetMusicDirectoryRequest(RequestContext& context)
 		default:
 			throw Error {Error::CustomType::BadId};
 	}
-
-	return response;
 }
 
 Response
@@ -1051,31 +1363,33 @@ handleGetGenresRequest(RequestContext& context)
 	auto clusterType {Database::ClusterType::getByName(context.db.getSession(), genreClusterName)};
 	if (clusterType)
 	{
-		auto clusters {clusterType->getClusters()};
-
-		for (const Database::Cluster::pointer& cluster : clusters)
-			genresNode.addArrayChild("genre", clusterToResponseNode(cluster));
+		for (const Database::ClusterType::ClusterStats& clusterStats : clusterType->getClustersStats())
+			genresNode.addArrayChild("genre", clusterToResponseNode(clusterStats));
 	}
 
 	return response;
 }
 
-Response
-handleGetIndexesRequest(RequestContext& context)
+void
+handleGetIndexesRequest(RequestContext& context, ResponseWriter& writer)
 {
-	Response response {Response::createOkResponse()};
-	Response::Node& artistsNode {response.createNode("indexes")};
+	ResponseWriter::Node artistsNode {writer.createNode("indexes")};
 
-	Response::Node& indexNode {artistsNode.createArrayChild("index")};
-	indexNode.setAttribute("name", "?");
+	if (ResponseCache* responseCache {getService<ResponseCache>()})
+	{
+		const long long lastModified {toMilliseconds(responseCache->getVersion().lastModified)};
+		artistsNode.setAttribute("lastModified", std::to_string(lastModified));
 
-	Wt::Dbo::Transaction transaction {context.db.getSession()};
+		// Nothing to return if the collection has not changed since the client's last call
+		boost::optional<long long> ifModifiedSince {getParameterAs<long long>(context.parameters, "ifModifiedSince")};
+		if (ifModifiedSince && lastModified <= *ifModifiedSince)
+			return;
+	}
 
-	auto artists {Database::Artist::getAll(context.db.getSession())};
-	for (const Database::Artist::pointer& artist : artists)
-		indexNode.addArrayChild("artist", artistToResponseNode(artist, false /* no id3 */));
+	ResponseWriter::Node indexNode {artistsNode.createArrayChild("index")};
+	indexNode.setAttribute("name", "?");
 
-	return response;
+	addArtistNodes(context, indexNode, "artist", false /* no id3 */);
 }
 
 Response
@@ -1328,7 +1642,7 @@ handleUpdatePlaylistRequest(RequestContext& context)
 
 	std::vector<std::size_t> trackPositionsToRemove {getMultiParametersAs<std::size_t>(context.parameters, "songIndexToRemove")};
 
-	Wt::Dbo::Transaction transaction {context.db.getSession()};
+	Database::WriteTransaction transaction {context.db.getSession()};
 
 	Database::User::pointer user {context.db.getUser(context.userName)};
 	if (!user)
@@ -1348,42 +1662,65 @@ handleUpdatePlaylistRequest(RequestContext& context)
 	if (isPublic)
 		tracklist.modify()->setIsPublic(*isPublic);
 
-	{
-		// Remove from end to make indexes stable
-		std::sort(std::begin(trackPositionsToRemove), std::end(trackPositionsToRemove), std::greater<std::size_t>());
-
-		for (std::size_t trackPositionToRemove : trackPositionsToRemove)
-		{
-			auto entry {tracklist->getEntry(trackPositionToRemove)};
-			if (entry)
-				entry.remove();
-		}
-	}
+	tracklist.modify()->remove(trackPositionsToRemove);
 
 	// Add tracks
-	for (const Id& trackIdToAdd : trackIdsToAdd)
 	{
-		Database::Track::pointer track {Database::Track::getById(context.db.getSession(), trackIdToAdd.value)};
-		if (!track)
-			continue;
+		std::vector<Database::IdType> trackIds;
+		std::transform(std::cbegin(trackIdsToAdd), std::cend(trackIdsToAdd), std::back_inserter(trackIds), [](const Id& trackId) { return trackId.value; });
 
-		Database::TrackListEntry::create(context.db.getSession(), track, tracklist );
+		tracklist.modify()->add(trackIds);
 	}
 
 	return Response::createOkResponse();
 }
 
+// Served as is, for the extensions the clients are likely to play
+static
+std::string
+getMimeType(const boost::filesystem::path& path)
+{
+	static const std::map<std::string, std::string> mimeTypes
+	{
+		{".aac",	"audio/aac"},
+		{".flac",	"audio/flac"},
+		{".m4a",	"audio/mp4"},
+		{".mp3",	"audio/mpeg"},
+		{".oga",	"audio/ogg"},
+		{".ogg",	"audio/ogg"},
+		{".opus",	"audio/ogg"},
+		{".wav",	"audio/wav"},
+		{".webm",	"audio/webm"},
+		{".wma",	"audio/x-ms-wma"},
+	};
+
+	auto it {mimeTypes.find(boost::algorithm::to_lower_copy(path.extension().string()))};
+	return it != mimeTypes.end() ? it->second : "application/octet-stream";
+}
+
+struct StreamParameters
+{
+	boost::filesystem::path		trackPath;
+	std::vector<unsigned char>	trackChecksum;
+	std::chrono::milliseconds	duration;
+	std::size_t			maxBitRate;	// kbps
+	bool				raw;		// no transcoding requested
+};
+
 static
-std::shared_ptr<Av::Transcoder>
-createTranscoder(RequestContext& context)
+StreamParameters
+getStreamParameters(RequestContext& context)
 {
 	// Mandatory params
 	Id id {getMandatoryParameterAs<Id>(context.parameters, "id")};
 
 	// Optional params
 	boost::optional<std::size_t> maxBitRate {getParameterAs<std::size_t>(context.parameters, "maxBitRate")};
+	const bool raw {getParameterAs<std::string>(context.parameters, "format") == std::string {"raw"}};
+
+	StreamParameters res;
+	res.raw = raw;
 
-	boost::filesystem::path trackPath;
 	{
 		Wt::Dbo::Transaction transaction {context.db.getSession()};
 
@@ -1395,65 +1732,122 @@ createTranscoder(RequestContext& context)
 		if (!maxBitRate || *maxBitRate == 0)
 			maxBitRate = user->getAudioTranscodeBitrate() / 1000;
 
-		*maxBitRate = clamp(*maxBitRate, std::size_t {48}, user->getMaxAudioTranscodeBitrate() / 1000);
+		res.maxBitRate = clamp(*maxBitRate, std::size_t {48}, user->getMaxAudioTranscodeBitrate() / 1000);
 
 		auto track {Database::Track::getById(context.db.getSession(), id.value)};
 		if (!track)
 			throw Error {Error::Code::RequestedDataNotFound};
 
-		trackPath = track->getPath();
+		res.trackPath = track->getPath();
+		res.trackChecksum = track->getChecksum();
+		res.duration = track->getDuration();
 	}
 
+	return res;
+}
+
+// Files already in the reported format are sent as is if their average bitrate fits
+static
+bool
+canServeOriginalFile(const StreamParameters& parameters)
+{
+	if (parameters.raw)
+		return true;
+
+	if (getMimeType(parameters.trackPath) != Av::encodingToMimetype(reportedEncoding))
+		return false;
+
+	const auto durationSecs {std::chrono::duration_cast<std::chrono::seconds>(parameters.duration).count()};
+	if (durationSecs <= 0)
+		return false;
+
+	boost::system::error_code ec;
+	const std::uintmax_t fileSize {boost::filesystem::file_size(parameters.trackPath, ec)};
+	if (ec)
+		return false;
+
+	return (fileSize * 8 / 1000) / static_cast<std::uintmax_t>(durationSecs) <= parameters.maxBitRate;
+}
+
+static
+Av::TranscodeParameters
+getTranscodeParameters(const StreamParameters& streamParameters)
+{
 	Av::TranscodeParameters parameters {};
 
 	parameters.stripMetadata = false; // Since it can be cached and some players read the metadata from the downloaded file
-	parameters.bitrate = *maxBitRate * 1000;
+	parameters.bitrate = streamParameters.maxBitRate * 1000;
 	parameters.encoding = transcodeEncoding;
 
-	return std::make_shared<Av::Transcoder>(trackPath, parameters);
+	return parameters;
 }
 
 MediaRetrievalResult
-handleStream(RequestContext& context, Wt::Http::ResponseContinuation* continuation)
+handleDownload(RequestContext& context)
 {
-	MediaRetrievalResult res;
-
-	// TODO store only weak ptrs and use a ring container to store shared_ptr?
-	std::shared_ptr<Av::Transcoder> transcoder;
+	// Mandatory params
+	Id id {getMandatoryParameterAs<Id>(context.parameters, "id")};
+	if (id.type != Id::Type::Track)
+		throw Error {Error::CustomType::BadId};
 
-	if (!continuation)
+	boost::filesystem::path trackPath;
 	{
-		transcoder = createTranscoder(context);
-		transcoder->start();
+		Wt::Dbo::Transaction transaction {context.db.getSession()};
 
-		res.mimeType = transcoder->getOutputMimeType();
-		LMS_LOG(API_SUBSONIC, DEBUG) << "Mime type set to '" << transcoder->getOutputMimeType() << "'";
+		auto track {Database::Track::getById(context.db.getSession(), id.value)};
+		if (!track)
+			throw Error {Error::Code::RequestedDataNotFound};
+
+		trackPath = track->getPath();
 	}
-	else
+
+	MediaRetrievalResult res;
+	res.resourceHandler = FileResourceHandler::create(trackPath, getMimeType(trackPath));
+	res.headers.emplace_back("Content-Disposition", "attachment; filename=\"" + replaceInString(trackPath.filename().string(), "\"", "_") + "\"");
+
+	return res;
+}
+
+MediaRetrievalResult
+handleStream(RequestContext& context)
+{
+	MediaRetrievalResult res;
+
+	const StreamParameters streamParameters {getStreamParameters(context)};
+	if (canServeOriginalFile(streamParameters))
 	{
-		transcoder = Wt::cpp17::any_cast<std::shared_ptr<Av::Transcoder>>(continuation->data());
+		LMS_LOG(API_SUBSONIC, DEBUG) << "Serving original file '" << streamParameters.trackPath.string() << "'";
+		res.resourceHandler = FileResourceHandler::create(streamParameters.trackPath, getMimeType(streamParameters.trackPath));
+		return res;
 	}
 
-	if (!transcoder)
+	Av::TranscodeRegistry* registry {getService<Av::TranscodeRegistry>()};
+	if (!registry)
 		throw Error {Error::CustomType::InternalError};
 
-	if (!transcoder->isComplete())
+	// Clients usually prefetch the next tracks while the current one is still being transcoded
+	Av::TranscodeScheduler::Priority priority {Av::TranscodeScheduler::Priority::Playing};
+	if (Av::TranscodeScheduler* scheduler {getService<Av::TranscodeScheduler>()})
 	{
-		static constexpr std::size_t chunkSize {65536*4};
-		res.data.reserve(chunkSize);
-
-		transcoder->process(res.data, chunkSize);
-
+		if (scheduler->getUserLoad(context.userName) > 0)
+			priority = Av::TranscodeScheduler::Priority::Prefetch;
 	}
 
-	if (!transcoder->isComplete())
-		res.continuationData = std::move(transcoder);
+	res.resourceHandler = Av::createTranscodeResourceHandler(*registry,
+			getService<Av::TranscodeCache>(),
+			streamParameters.trackPath,
+			streamParameters.trackChecksum,
+			getTranscodeParameters(streamParameters),
+			context.userName,
+			priority);
+	if (!res.resourceHandler)
+		throw Error {Error::CustomType::ServerBusy};
 
 	return res;
 }
 
 MediaRetrievalResult
-handleGetCoverArt(RequestContext& context, Wt::Http::ResponseContinuation*)
+handleGetCoverArt(RequestContext& context)
 {
 	// Mandatory params
 	Id id {getMandatoryParameterAs<Id>(context.parameters, "id")};
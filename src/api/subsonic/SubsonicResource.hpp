@@ -18,12 +18,18 @@
  */
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <boost/optional.hpp>
 
 #include <Wt/WResource.h>
 #include <Wt/Http/Response.h>
 
 #include "database/DatabaseHandler.hpp"
+#include "SubsonicAuthCache.hpp"
+#include "SubsonicLoginThrottle.hpp"
 
 namespace API::Subsonic
 {
@@ -39,7 +45,18 @@ class SubsonicResource final : public Wt::WResource
 
 		void handleRequest(const Wt::Http::Request &request, Wt::Http::Response &response) override;
 
-		Database::Handler	_db;
+		// Requests are handled concurrently, each of them using its own handler
+		// Handlers are kept for later requests once done
+		std::unique_ptr<Database::Handler> acquireDbHandler();
+		void releaseDbHandler(std::unique_ptr<Database::Handler> db);
+
+		Wt::Dbo::SqlConnectionPool&			_connectionPool;
+		const bool					_readOnly;	// read replica
+		AuthCache					_authCache;
+		LoginThrottle					_loginThrottle;	// only used on read replicas
+
+		std::mutex					_dbHandlersMutex;
+		std::vector<std::unique_ptr<Database::Handler>>	_dbHandlers;
 };
 
 } // namespace
@@ -19,17 +19,12 @@
 
 #include "SubsonicResponse.hpp"
 
-#include <Wt/Json/Array.h>
-#include <Wt/Json/Object.h>
-#include <Wt/Json/Value.h>
-#include <Wt/Json/Serializer.h>
-
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <algorithm>
+#include <ostream>
 
 #include "utils/Exception.hpp"
 
-#define API_VERSION	"1.12.0"
+#define API_VERSION	"1.13.0"
 
 namespace API::Subsonic
 {
@@ -81,6 +76,8 @@ CustomTypeToString(Error::CustomType type)
 			return "Not implemented";
 		case Error::CustomType::InternalError:
 			return "Internal error";
+		case Error::CustomType::ServerBusy:
+			return "Server busy, try again later";
 		default:
 			return "Unknown custom error";
 	}
@@ -110,7 +107,11 @@ Response::Node::setValue(const std::string& value)
 void
 Response::Node::setAttribute(const std::string& key, const std::string& value)
 {
-	_attributes[key] = value;
+	auto it {std::find_if(std::begin(_attributes), std::end(_attributes), [&](const auto& attribute) { return attribute.first == key; })};
+	if (it != std::end(_attributes))
+		it->second = value;
+	else
+		_attributes.emplace_back(key, value);
 }
 
 void
@@ -195,96 +196,401 @@ Response::createArrayNode(const std::string& key)
 void
 Response::write(std::ostream& os, ResponseFormat format)
 {
-	switch (format)
+	ResponseWriter writer {os, format};
+	writer.writeDocument(_root);
+}
+
+// Unescaped runs of characters are written at once
+static
+void
+writeXMLEscaped(std::ostream& os, const std::string& str)
+{
+	std::size_t begin {};
+	for (std::size_t i {}; i < str.size(); ++i)
+	{
+		const char* replacement {};
+		switch (str[i])
+		{
+			case '&': replacement = "&amp;"; break;
+			case '<': replacement = "&lt;"; break;
+			case '>': replacement = "&gt;"; break;
+			case '"': replacement = "&quot;"; break;
+			case '\'': replacement = "&apos;"; break;
+			case '\t': replacement = "&#9;"; break;
+			case '\n': replacement = "&#10;"; break;
+			case '\r': replacement = "&#13;"; break;
+			default:
+				// Other control characters are not allowed in XML documents
+				if (static_cast<unsigned char>(str[i]) >= 0x20)
+					continue;
+				replacement = "";
+		}
+
+		os.write(str.data() + begin, i - begin);
+		os << replacement;
+		begin = i + 1;
+	}
+	os.write(str.data() + begin, str.size() - begin);
+}
+
+static
+void
+writeJSONString(std::ostream& os, const std::string& str)
+{
+	os << '"';
+
+	std::size_t begin {};
+	for (std::size_t i {}; i < str.size(); ++i)
+	{
+		const unsigned char c {static_cast<unsigned char>(str[i])};
+		if (c >= 0x20 && c != '"' && c != '\\')
+			continue;
+
+		os.write(str.data() + begin, i - begin);
+		switch (c)
+		{
+			case '"': os << "\\\""; break;
+			case '\\': os << "\\\\"; break;
+			case '\b': os << "\\b"; break;
+			case '\f': os << "\\f"; break;
+			case '\n': os << "\\n"; break;
+			case '\r': os << "\\r"; break;
+			case '\t': os << "\\t"; break;
+			default:
+			{
+				static const char hexDigits[] {"0123456789abcdef"};
+				os << "\\u00" << hexDigits[c >> 4] << hexDigits[c & 0xF];
+			}
+		}
+		begin = i + 1;
+	}
+	os.write(str.data() + begin, str.size() - begin);
+
+	os << '"';
+}
+
+ResponseWriter::Node::Node(ResponseWriter& writer, std::size_t depth, std::size_t id)
+: _writer {&writer},
+_depth {depth},
+_id {id}
+{
+}
+
+void
+ResponseWriter::Node::setAttribute(const std::string& key, const std::string& value)
+{
+	_writer->setAttribute(_depth, _id, key, value);
+}
+
+void
+ResponseWriter::Node::setValue(const std::string& value)
+{
+	_writer->setValue(_depth, _id, value);
+}
+
+ResponseWriter::Node
+ResponseWriter::Node::createChild(const std::string& key)
+{
+	return _writer->openChild(_depth, _id, key, false);
+}
+
+ResponseWriter::Node
+ResponseWriter::Node::createArrayChild(const std::string& key)
+{
+	return _writer->openChild(_depth, _id, key, true);
+}
+
+void
+ResponseWriter::Node::addChild(const std::string& key, const Response::Node& node)
+{
+	_writer->writeNode(createChild(key), node);
+}
+
+void
+ResponseWriter::Node::addArrayChild(const std::string& key, const Response::Node& node)
+{
+	_writer->writeNode(createArrayChild(key), node);
+}
+
+ResponseWriter::ResponseWriter(std::ostream& os, ResponseFormat format)
+: _os {os},
+_format {format}
+{
+}
+
+ResponseWriter::Node
+ResponseWriter::createNode(const std::string& key)
+{
+	return getResponseNode().createChild(key);
+}
+
+ResponseWriter::Node
+ResponseWriter::createArrayNode(const std::string& key)
+{
+	return getResponseNode().createArrayChild(key);
+}
+
+void
+ResponseWriter::addNode(const std::string& key, const Response::Node& node)
+{
+	getResponseNode().addChild(key, node);
+}
+
+void
+ResponseWriter::finish()
+{
+	if (_finished)
+		return;
+
+	if (!_started)
+		start();
+
+	while (!_frames.empty())
+		closeFrame();
+
+	_finished = true;
+}
+
+void
+ResponseWriter::openDocument()
+{
+	_started = true;
+
+	switch (_format)
 	{
 		case ResponseFormat::xml:
-			writeXML(os);
+			_os << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
 			break;
 		case ResponseFormat::json:
-			writeJSON(os);
+			_os << '{';
 			break;
 	}
+
+	_frames.push_back({"", _nextId++});
 }
 
 void
-Response::writeXML(std::ostream& os)
+ResponseWriter::start()
 {
-	std::function<boost::property_tree::ptree(const Response::Node&)> nodeToPropertyTree = [&] (const Response::Node& node)
-	{
-		boost::property_tree::ptree res;
+	openDocument();
 
-		for (auto itAttribute : node._attributes)
-			res.put("<xmlattr>." + itAttribute.first, itAttribute.second);
+	Node responseNode {openChild(0, _frames.front().id, "subsonic-response", false)};
+	responseNode.setAttribute("status", "ok");
+	responseNode.setAttribute("version", API_VERSION);
+}
 
-		if (!node._value.empty())
-		{
-			res.put_value(node._value);
-		}
-		else
-		{
-			for (auto itChildNode : node._children)
+void
+ResponseWriter::writeDocument(const Response::Node& root)
+{
+	openDocument();
+	writeNode(Node {*this, 0, _frames.front().id}, root);
+	finish();
+}
+
+ResponseWriter::Node
+ResponseWriter::getResponseNode()
+{
+	if (!_started)
+		start();
+
+	if (_finished)
+		throw LmsException {"Response already finished"};
+
+	return Node {*this, 1, _frames[1].id};
+}
+
+ResponseWriter::Frame&
+ResponseWriter::getFrame(std::size_t depth, std::size_t id)
+{
+	if (depth >= _frames.size() || _frames[depth].id != id)
+		throw LmsException {"Node already written"};
+
+	return _frames[depth];
+}
+
+ResponseWriter::Node
+ResponseWriter::openChild(std::size_t depth, std::size_t id, const std::string& key, bool array)
+{
+	getFrame(depth, id);
+
+	// Deeper nodes are complete
+	while (_frames.size() > depth + 1)
+		closeFrame();
+
+	Frame& parent {_frames.back()};
+	if (parent.hasValue)
+		throw LmsException {"Node already has a value"};
+
+	switch (_format)
+	{
+		case ResponseFormat::xml:
+			if (depth > 0 && !parent.hasContent)
+				_os << '>';
+			_os << '<' << key;
+			break;
+
+		case ResponseFormat::json:
+			if (array && parent.arrayKey == key)
+				_os << ',';
+			else
 			{
-				for (const Response::Node& childNode : itChildNode.second)
-					res.add_child(itChildNode.first, nodeToPropertyTree(childNode));
+				writeJSONKey(parent, key);
+				if (array)
+				{
+					_os << '[';
+					parent.arrayKey = key;
+				}
 			}
+			_os << '{';
+			break;
+	}
 
-			for (auto itChildArrayNode : node._childrenArrays)
-			{
-				const std::vector<Response::Node>& childArrayNodes {itChildArrayNode .second};
+	parent.hasContent = true;
+	_frames.push_back({key, _nextId++});
 
-				for (const Response::Node& childNode : childArrayNodes )
-					res.add_child(itChildArrayNode.first, nodeToPropertyTree(childNode));
-			}
-		}
+	return Node {*this, _frames.size() - 1, _frames.back().id};
+}
 
-		return res;
-	};
+void
+ResponseWriter::setAttribute(std::size_t depth, std::size_t id, const std::string& key, const std::string& value)
+{
+	Frame& frame {getFrame(depth, id)};
+	if (frame.hasContent)
+		throw LmsException {"Node already has children or a value"};
+
+	switch (_format)
+	{
+		case ResponseFormat::xml:
+			addKey(frame, key);
+			_os << ' ' << key << "=\"";
+			writeXMLEscaped(_os, value);
+			_os << '"';
+			break;
 
-	boost::property_tree::ptree root {nodeToPropertyTree(_root)};
-	boost::property_tree::write_xml(os, root);
+		case ResponseFormat::json:
+			writeJSONKey(frame, key);
+			writeJSONString(_os, value);
+			break;
+	}
 }
 
 void
-Response::writeJSON(std::ostream& os)
+ResponseWriter::setValue(std::size_t depth, std::size_t id, const std::string& value)
 {
-	namespace Json = Wt::Json;
+	Frame& frame {getFrame(depth, id)};
+	if (frame.hasContent)
+		throw LmsException {"Node already has children or a value"};
 
-	std::function<Json::Object(const Response::Node&)> nodeToJsonObject = [&] (const Response::Node& node)
+	// Same as no value
+	if (value.empty())
+		return;
+
+	switch (_format)
 	{
-		Json::Object res;
+		case ResponseFormat::xml:
+			_os << '>';
+			writeXMLEscaped(_os, value);
+			break;
 
-		for (auto itAttribute : node._attributes)
-			res[itAttribute.first] = Json::Value {itAttribute.second};
+		case ResponseFormat::json:
+			writeJSONKey(frame, "value");
+			writeJSONString(_os, value);
+			break;
+	}
 
-		if (!node._value.empty())
+	frame.hasContent = true;
+	frame.hasValue = true;
+}
+
+void
+ResponseWriter::writeNode(Node node, const Response::Node& content)
+{
+	for (const auto& attribute : content._attributes)
+		node.setAttribute(attribute.first, attribute.second);
+
+	if (!content._value.empty())
+	{
+		node.setValue(content._value);
+		return;
+	}
+
+	for (const auto& itChildNodes : content._children)
+	{
+		if (itChildNodes.second.empty())
+			continue;
+
+		// Only one object per key in JSON: the last one wins
+		if (_format == ResponseFormat::json)
 		{
-			res["value"] = Json::Value {node._value};
+			writeNode(node.createChild(itChildNodes.first), itChildNodes.second.back());
+			continue;
 		}
-		else
-		{
-			for (auto itChildNode : node._children)
-			{
-				for (const Response::Node& childNode : itChildNode.second)
-					res[itChildNode.first] = nodeToJsonObject(childNode);
-			}
 
-			for (auto itChildArrayNode : node._childrenArrays)
-			{
-				const std::vector<Response::Node>& childArrayNodes {itChildArrayNode .second};
+		for (const Response::Node& childNode : itChildNodes.second)
+			writeNode(node.createChild(itChildNodes.first), childNode);
+	}
+
+	for (const auto& itChildArrayNodes : content._childrenArrays)
+	{
+		for (const Response::Node& childNode : itChildArrayNodes.second)
+			writeNode(node.createArrayChild(itChildArrayNodes.first), childNode);
+	}
+}
+
+// Keys must be unique within a node
+void
+ResponseWriter::addKey(Frame& frame, const std::string& key)
+{
+	if (std::find(std::cbegin(frame.keys), std::cend(frame.keys), key) != std::cend(frame.keys))
+		throw LmsException {"Key '" + key + "' already written"};
 
-				Json::Array array;
-				for (const Response::Node& childNode : childArrayNodes )
-					array.emplace_back(nodeToJsonObject(childNode));
+	frame.keys.push_back(key);
+}
+
+void
+ResponseWriter::writeJSONKey(Frame& frame, const std::string& key)
+{
+	if (!frame.arrayKey.empty())
+	{
+		_os << ']';
+		frame.arrayKey.clear();
+	}
 
-				res[itChildArrayNode.first] = std::move(array);
+	if (!frame.keys.empty())
+		_os << ',';
+
+	addKey(frame, key);
+
+	writeJSONString(_os, key);
+	_os << ':';
+}
+
+void
+ResponseWriter::closeFrame()
+{
+	const Frame& frame {_frames.back()};
+
+	switch (_format)
+	{
+		case ResponseFormat::xml:
+			// The document itself has no tag
+			if (_frames.size() > 1)
+			{
+				if (frame.hasContent)
+					_os << "</" << frame.key << '>';
+				else
+					_os << "/>";
 			}
-		}
+			break;
 
-		return res;
-	};
+		case ResponseFormat::json:
+			if (!frame.arrayKey.empty())
+				_os << ']';
+			_os << '}';
+			break;
+	}
 
-	Json::Object root {nodeToJsonObject(_root)};
-	os << Json::serialize(root);
+	_frames.pop_back();
 }
 
 } // namespace
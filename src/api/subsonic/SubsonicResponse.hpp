@@ -17,8 +17,11 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstddef>
 #include <map>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace API::Subsonic
@@ -51,6 +54,7 @@ class Error
 			BadId,
 			NotImplemented,
 			InternalError,
+			ServerBusy,
 		};
 
 		Error(Code code);
@@ -64,6 +68,10 @@ class Error
 		std::string _message;
 };
 
+class ResponseWriter;
+
+// Response built in memory and then written
+// Large responses should rather be written as they are built, using a ResponseWriter
 class Response
 {
 	public:
@@ -82,7 +90,9 @@ class Response
 
 			private:
 				friend class Response;
-				std::map<std::string, std::string> _attributes;
+				friend class ResponseWriter;
+				// Few attributes per node, kept in insertion order
+				std::vector<std::pair<std::string, std::string>> _attributes;
 				std::string _value;
 				std::map<std::string, std::vector<Node>> _children;
 				std::map<std::string, std::vector<Node>> _childrenArrays;
@@ -104,12 +114,90 @@ class Response
 		void write(std::ostream& os, ResponseFormat format);
 	private:
 
-		void writeJSON(std::ostream& os);
-		void writeXML(std::ostream& os);
-
 		Response() = default;
 		Node _root;
 };
 
+// Writes an ok response while it is being built, without keeping it in memory
+// Nodes are written in creation order:
+// - attributes and value must be set before any child is created, the value last
+// - a node can no longer be used once a sibling of it or of one of its parents has been created
+// - in JSON, the array children sharing the same key must be created one after the other
+// Nothing is written until the first node is created, so that errors can still be reported until then
+// Throws LmsException on misuse
+class ResponseWriter
+{
+	public:
+		class Node
+		{
+			public:
+				void setAttribute(const std::string& key, const std::string& value);
+				void setValue(const std::string& value);
+				Node createChild(const std::string& key);
+				Node createArrayChild(const std::string& key);
+
+				// Nodes built beforehand
+				void addChild(const std::string& key, const Response::Node& node);
+				void addArrayChild(const std::string& key, const Response::Node& node);
+
+			private:
+				friend class ResponseWriter;
+				Node(ResponseWriter& writer, std::size_t depth, std::size_t id);
+
+				ResponseWriter*	_writer;
+				std::size_t	_depth;
+				std::size_t	_id;
+		};
+
+		ResponseWriter(std::ostream& os, ResponseFormat format);
+
+		ResponseWriter(const ResponseWriter&) = delete;
+		ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+		Node createNode(const std::string& key);
+		Node createArrayNode(const std::string& key);
+		void addNode(const std::string& key, const Response::Node& node);
+
+		// Completes the document, written as an empty ok response if no node has been created
+		void finish();
+
+		bool isStarted() const { return _started; }
+
+	private:
+		friend class Response;
+
+		// Open nodes, from the document root to the last created node
+		struct Frame
+		{
+			std::string			key;
+			std::size_t			id;
+			bool				hasContent {};	// value or children written, no more attributes
+			bool				hasValue {};
+			std::string			arrayKey;	// JSON: array being written
+			std::vector<std::string>	keys;		// written attributes, and JSON members
+		};
+
+		void openDocument();
+		void start();
+		void writeDocument(const Response::Node& root);
+
+		Node getResponseNode();
+		Frame& getFrame(std::size_t depth, std::size_t id);
+		Node openChild(std::size_t depth, std::size_t id, const std::string& key, bool array);
+		void setAttribute(std::size_t depth, std::size_t id, const std::string& key, const std::string& value);
+		void setValue(std::size_t depth, std::size_t id, const std::string& value);
+		void writeNode(Node node, const Response::Node& content);
+		void addKey(Frame& frame, const std::string& key);
+		void writeJSONKey(Frame& frame, const std::string& key);
+		void closeFrame();
+
+		std::ostream&		_os;
+		const ResponseFormat	_format;
+		std::vector<Frame>	_frames;
+		std::size_t		_nextId {};
+		bool			_started {};
+		bool			_finished {};
+};
+
 } // namespace
 
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SubsonicResponseCache.hpp"
+
+#include "utils/Logger.hpp"
+
+namespace API::Subsonic
+{
+
+ResponseCache::ResponseCache(std::size_t maxEntries)
+: _maxEntries {maxEntries},
+_version {0, std::chrono::system_clock::now()}
+{
+}
+
+ResponseCache::Version
+ResponseCache::getVersion() const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	return _version;
+}
+
+boost::optional<std::string>
+ResponseCache::get(const std::string& key) const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_bodies.find(key)};
+	if (it == _bodies.end())
+		return boost::none;
+
+	return it->second;
+}
+
+void
+ResponseCache::add(const std::string& key, std::string body, const Version& version)
+{
+	if (_maxEntries == 0)
+		return;
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	if (version.generation != _version.generation)
+		return;
+
+	// Paginated requests may fill the cache: just start over
+	if (_bodies.size() >= _maxEntries && _bodies.find(key) == _bodies.end())
+		_bodies.clear();
+
+	_bodies[key] = std::move(body);
+}
+
+void
+ResponseCache::preScanComplete()
+{
+	invalidate();
+}
+
+void
+ResponseCache::databaseReplaced()
+{
+	invalidate();
+}
+
+void
+ResponseCache::invalidate()
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	LMS_LOG(API_SUBSONIC, DEBUG) << "Invalidating " << _bodies.size() << " cached responses";
+
+	_bodies.clear();
+	_version.generation++;
+	_version.lastModified = std::chrono::system_clock::now();
+}
+
+} // namespace API::Subsonic
+
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include "scanner/MediaScannerAddon.hpp"
+
+namespace API::Subsonic
+{
+
+// Serialized bodies of the responses that only change when the database does
+// Everything is invalidated each time a scan completes or the database is replaced
+// To be registered after the other addons, so that their data is up to date once invalidated
+class ResponseCache final : public Scanner::MediaScannerAddon
+{
+	public:
+		// maxEntries = 0 to only track the modification time
+		ResponseCache(std::size_t maxEntries);
+
+		struct Version
+		{
+			std::uint64_t				generation;
+			std::chrono::system_clock::time_point	lastModified;
+		};
+
+		Version getVersion() const;
+
+		boost::optional<std::string> get(const std::string& key) const;
+
+		// Not cached if the database has changed since version
+		void add(const std::string& key, std::string body, const Version& version);
+
+	private:
+
+		void refreshSettings() override {}
+		void requestStop() override {}
+		void trackAdded(Database::IdType trackId) override {}
+		void trackToRemove(Database::IdType trackId) override {}
+		void trackUpdated(Database::IdType trackId) override {}
+		void preScanComplete() override;
+		void databaseReplaced() override;
+
+		void invalidate();
+
+		const std::size_t				_maxEntries;
+
+		mutable std::mutex				_mutex;
+		Version						_version;
+		std::unordered_map<std::string, std::string>	_bodies;
+};
+
+} // namespace API::Subsonic
+
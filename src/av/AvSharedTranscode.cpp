@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvSharedTranscode.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "utils/Logger.hpp"
+
+namespace Av {
+
+// Kept alive by the pending reads, so that the transcoder outlives them
+class SharedTranscode::State : public std::enable_shared_from_this<State>
+{
+	public:
+		State(const boost::filesystem::path& file, const TranscodeParameters& parameters, std::unique_ptr<TranscodeScheduler::Ticket> ticket, std::unique_ptr<TranscodeCache::Writer> cacheWriter)
+		: _transcoder {file, parameters},
+		_ticket {std::move(ticket)},
+		_cacheWriter {std::move(cacheWriter)}
+		{}
+
+		void schedule();
+		void abort();
+
+		Data getData(std::size_t offset) const;
+		bool isComplete(std::size_t offset) const;
+		void waitForData(std::size_t offset, std::function<void()> callback);
+
+		const std::string& getOutputMimeType() const { return _transcoder.getOutputMimeType(); }
+
+	private:
+		using Callbacks = std::vector<std::function<void()>>;
+
+		void start();
+		void readNext();
+		void onRead(std::size_t nbReadBytes);
+		void complete(Callbacks& callbacks, std::unique_ptr<TranscodeScheduler::Ticket>& ticket);
+
+		// All the blocks are full, except the last one
+		static constexpr std::size_t	blockSize {65536 * 4};
+
+		mutable std::mutex					_mutex;
+		Transcoder						_transcoder;
+		std::unique_ptr<TranscodeScheduler::Ticket>		_ticket;
+		std::unique_ptr<TranscodeCache::Writer>			_cacheWriter;	// only used by the reads
+		bool							_started {};
+		bool							_aborted {};
+		bool							_complete {};
+
+		std::deque<std::vector<unsigned char>>			_blocks;	// never modified once added
+		std::size_t						_size {};
+		std::vector<unsigned char>				_readBuffer;
+		std::vector<std::pair<std::size_t, std::function<void()>>>	_waiters;
+};
+
+void
+SharedTranscode::State::schedule()
+{
+	if (!_ticket)
+	{
+		start();
+		return;
+	}
+
+	// Not keeping the state alive, so that an abandoned transcode leaves the queue
+	_ticket->setAdmittedCallback([state = std::weak_ptr<State> {shared_from_this()}]
+	{
+		if (auto admittedState {state.lock()})
+			admittedState->start();
+	});
+}
+
+void
+SharedTranscode::State::start()
+{
+	Callbacks callbacks;
+	std::unique_ptr<TranscodeScheduler::Ticket> ticket;
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		if (_aborted || _started)
+			return;
+
+		_started = _transcoder.start();
+		if (!_started)
+		{
+			LMS_LOG(TRANSCODE, ERROR) << "Cannot start transcoder";
+			complete(callbacks, ticket);
+		}
+	}
+
+	// Outside of the lock, since releasing the ticket may start other transcodes
+	ticket.reset();
+	for (auto& callback : callbacks)
+		callback();
+
+	if (_started)
+		readNext();
+}
+
+void
+SharedTranscode::State::abort()
+{
+	std::unique_ptr<TranscodeScheduler::Ticket> ticket;
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		_aborted = true;
+
+		// The pending read completes once the child is killed
+		if (_started)
+			_transcoder.abort();
+		else
+			ticket = std::move(_ticket);
+	}
+}
+
+void
+SharedTranscode::State::readNext()
+{
+	_readBuffer.resize(blockSize);
+	_transcoder.asyncRead(_readBuffer.data(), _readBuffer.size(), [self = shared_from_this()](std::size_t nbReadBytes)
+	{
+		self->onRead(nbReadBytes);
+	});
+}
+
+void
+SharedTranscode::State::onRead(std::size_t nbReadBytes)
+{
+	Callbacks callbacks;
+	std::unique_ptr<TranscodeScheduler::Ticket> ticket;
+	const unsigned char* block {};
+	bool done {};
+	bool succeeded {};
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		if (nbReadBytes > 0)
+		{
+			_readBuffer.resize(nbReadBytes);
+			_blocks.push_back(std::move(_readBuffer));
+			_readBuffer = {};
+			_size += nbReadBytes;
+
+			block = _blocks.back().data();
+		}
+
+		if (_transcoder.isComplete() || _aborted)
+		{
+			complete(callbacks, ticket);
+			done = true;
+			succeeded = !_aborted && _transcoder.isSuccess();
+		}
+		else
+		{
+			auto itReady {std::partition(std::begin(_waiters), std::end(_waiters), [&](const auto& waiter) { return waiter.first >= _size; })};
+			for (auto it {itReady}; it != std::end(_waiters); ++it)
+				callbacks.push_back(std::move(it->second));
+			_waiters.erase(itReady, std::end(_waiters));
+		}
+	}
+
+	ticket.reset();
+	for (auto& callback : callbacks)
+		callback();
+
+	if (_cacheWriter)
+	{
+		if (block)
+			_cacheWriter->write(block, nbReadBytes);
+
+		// Truncated outputs are discarded along with the writer
+		if (done)
+		{
+			if (succeeded)
+				_cacheWriter->commit();
+			_cacheWriter.reset();
+		}
+	}
+
+	if (!done)
+		readNext();
+}
+
+void
+SharedTranscode::State::complete(Callbacks& callbacks, std::unique_ptr<TranscodeScheduler::Ticket>& ticket)
+{
+	_complete = true;
+	ticket = std::move(_ticket);
+
+	for (auto& waiter : _waiters)
+		callbacks.push_back(std::move(waiter.second));
+	_waiters.clear();
+}
+
+SharedTranscode::Data
+SharedTranscode::State::getData(std::size_t offset) const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	if (offset >= _size)
+		return {};
+
+	const std::vector<unsigned char>& block {_blocks[offset / blockSize]};
+	const std::size_t blockOffset {offset % blockSize};
+
+	return {block.data() + blockOffset, block.size() - blockOffset};
+}
+
+bool
+SharedTranscode::State::isComplete(std::size_t offset) const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	return _complete && offset >= _size;
+}
+
+void
+SharedTranscode::State::waitForData(std::size_t offset, std::function<void()> callback)
+{
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		if (offset >= _size && !_complete)
+		{
+			_waiters.emplace_back(offset, std::move(callback));
+			return;
+		}
+	}
+
+	callback();
+}
+
+SharedTranscode::SharedTranscode(const boost::filesystem::path& file, const TranscodeParameters& parameters, std::unique_ptr<TranscodeScheduler::Ticket> ticket, std::unique_ptr<TranscodeCache::Writer> cacheWriter)
+: _state {std::make_shared<State>(file, parameters, std::move(ticket), std::move(cacheWriter))}
+{
+	_state->schedule();
+}
+
+SharedTranscode::~SharedTranscode()
+{
+	_state->abort();
+}
+
+const std::string&
+SharedTranscode::getOutputMimeType() const
+{
+	return _state->getOutputMimeType();
+}
+
+SharedTranscode::Data
+SharedTranscode::getData(std::size_t offset) const
+{
+	return _state->getData(offset);
+}
+
+bool
+SharedTranscode::isComplete(std::size_t offset) const
+{
+	return _state->isComplete(offset);
+}
+
+void
+SharedTranscode::waitForData(std::size_t offset, std::function<void()> callback)
+{
+	_state->waitForData(offset, std::move(callback));
+}
+
+} // namespace Av
+
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "AvTranscodeCache.hpp"
+#include "AvTranscodeScheduler.hpp"
+#include "AvTranscoder.hpp"
+
+namespace Av {
+
+// Output of a transcoder, shared by all its readers
+// The transcoder starts once the ticket is admitted (immediately if there is no ticket) and produces as fast as it can
+// The whole output is kept, so that readers joining late start from the beginning
+// The transcoder is killed once the last reader has gone away, that is once this object is destroyed
+// If a cache writer is given, the output is also written to it and committed if the transcode completes
+class SharedTranscode
+{
+	public:
+		SharedTranscode(const boost::filesystem::path& file, const TranscodeParameters& parameters, std::unique_ptr<TranscodeScheduler::Ticket> ticket, std::unique_ptr<TranscodeCache::Writer> cacheWriter = {});
+		~SharedTranscode();
+
+		SharedTranscode(const SharedTranscode&) = delete;
+		SharedTranscode& operator=(const SharedTranscode&) = delete;
+
+		const std::string& getOutputMimeType() const;
+
+		// Output available at offset, stays valid as long as this object
+		// Empty if nothing is available yet at offset
+		struct Data
+		{
+			const unsigned char*	data {};
+			std::size_t		size {};
+		};
+		Data getData(std::size_t offset) const;
+
+		// Complete output, and nothing left to read at offset
+		bool isComplete(std::size_t offset) const;
+
+		// The callback is called once data is available at offset or the output is complete, immediately if already the case
+		// It may be called from any thread
+		void waitForData(std::size_t offset, std::function<void()> callback);
+
+	private:
+		class State;
+		std::shared_ptr<State>	_state;
+};
+
+} // namespace Av
+
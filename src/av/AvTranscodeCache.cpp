@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvTranscodeCache.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <sstream>
+#include <tuple>
+
+#include <Wt/Utils.h>
+
+#include "utils/Logger.hpp"
+
+namespace Av {
+
+static const std::string tmpExtension {".tmp"};
+
+TranscodeCache::Writer::Writer(TranscodeCache& cache, const std::string& key, const boost::filesystem::path& tmpPath)
+: _cache {cache},
+_key {key},
+_tmpPath {tmpPath},
+_ofs {tmpPath.string(), std::ios::binary | std::ios::trunc}
+{
+	if (!_ofs)
+	{
+		LMS_LOG(TRANSCODE, ERROR) << "Cannot create cache file '" << _tmpPath.string() << "'";
+		_failed = true;
+	}
+}
+
+TranscodeCache::Writer::~Writer()
+{
+	if (!_committed)
+	{
+		_ofs.close();
+
+		boost::system::error_code ec;
+		boost::filesystem::remove(_tmpPath, ec);
+	}
+}
+
+void
+TranscodeCache::Writer::write(const unsigned char* data, std::size_t size)
+{
+	if (_failed)
+		return;
+
+	// Would be evicted right away
+	if (_size + size > _cache._maxSize)
+	{
+		_failed = true;
+		return;
+	}
+
+	_ofs.write(reinterpret_cast<const char*>(data), size);
+	if (!_ofs)
+	{
+		LMS_LOG(TRANSCODE, ERROR) << "Cannot write cache file '" << _tmpPath.string() << "'";
+		_failed = true;
+		return;
+	}
+
+	_size += size;
+}
+
+void
+TranscodeCache::Writer::commit()
+{
+	if (_failed || _committed || _size == 0)
+		return;
+
+	_ofs.close();
+	if (!_ofs)
+		return;
+
+	boost::system::error_code ec;
+	boost::filesystem::rename(_tmpPath, _cache.getEntryPath(_key), ec);
+	if (ec)
+	{
+		LMS_LOG(TRANSCODE, ERROR) << "Cannot commit cache file '" << _tmpPath.string() << "': " << ec.message();
+		return;
+	}
+
+	_committed = true;
+	_cache.add(_key, _size);
+}
+
+TranscodeCache::TranscodeCache(const boost::filesystem::path& directory, std::uintmax_t maxSize)
+: _directory {directory},
+_maxSize {maxSize}
+{
+	boost::filesystem::create_directories(_directory);
+
+	load();
+
+	LMS_LOG(TRANSCODE, INFO) << "Transcode cache: " << _entries.size() << " entries, " << _size << " bytes, max size = " << _maxSize << " bytes";
+}
+
+bool
+TranscodeCache::isCacheable(const TranscodeParameters& parameters)
+{
+	return parameters.encoding && (!parameters.offset || parameters.offset->count() == 0);
+}
+
+std::string
+TranscodeCache::computeKey(const std::vector<unsigned char>& checksum, const TranscodeParameters& parameters)
+{
+	std::ostringstream oss;
+
+	oss << std::string(std::cbegin(checksum), std::cend(checksum)) << '\0'
+		<< (parameters.encoding ? static_cast<int>(*parameters.encoding) : -1) << '/'
+		<< parameters.bitrate << '/'
+		<< (parameters.stream ? static_cast<long long>(*parameters.stream) : -1) << '/'
+		<< parameters.stripMetadata;
+
+	return Wt::Utils::hexEncode(Wt::Utils::sha1(oss.str()));
+}
+
+std::unique_ptr<TranscodeCache::CachedFile>
+TranscodeCache::get(const std::string& key, const boost::filesystem::path& sourceFile)
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_entries.find(key)};
+	if (it == _entries.end())
+	{
+		_misses++;
+		return nullptr;
+	}
+
+	const boost::filesystem::path path {getEntryPath(key)};
+
+	// The source file may have changed since it has been scanned
+	boost::system::error_code entryEc;
+	boost::system::error_code sourceEc;
+	const std::time_t entryTime {boost::filesystem::last_write_time(path, entryEc)};
+	const std::time_t sourceTime {boost::filesystem::last_write_time(sourceFile, sourceEc)};
+	if (entryEc || sourceEc || sourceTime > entryTime)
+	{
+		LMS_LOG(TRANSCODE, DEBUG) << "Removing outdated cache entry for '" << sourceFile.string() << "'";
+		remove(key);
+		_misses++;
+		return nullptr;
+	}
+
+	std::unique_ptr<CachedFile> cachedFile {new CachedFile {path, std::ifstream {path.string(), std::ios::binary}, it->second.size, entryTime}};
+	if (!cachedFile->stream)
+	{
+		LMS_LOG(TRANSCODE, ERROR) << "Cannot open cache file '" << path.string() << "'";
+		remove(key);
+		_misses++;
+		return nullptr;
+	}
+
+	_lru.splice(_lru.begin(), _lru, it->second.itLru);
+	_hits++;
+
+	return cachedFile;
+}
+
+std::unique_ptr<TranscodeCache::Writer>
+TranscodeCache::createWriter(const std::string& key)
+{
+	std::size_t writerId;
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+		writerId = _nextWriterId++;
+	}
+
+	return std::unique_ptr<Writer> {new Writer {*this, key, _directory / (key + "." + std::to_string(writerId) + tmpExtension)}};
+}
+
+TranscodeCache::Stats
+TranscodeCache::getStats() const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	Stats stats;
+	stats.hits = _hits;
+	stats.misses = _misses;
+	stats.evictions = _evictions;
+	stats.entries = _entries.size();
+	stats.size = _size;
+	stats.maxSize = _maxSize;
+
+	return stats;
+}
+
+boost::filesystem::path
+TranscodeCache::getEntryPath(const std::string& key) const
+{
+	return _directory / key;
+}
+
+// The entries are ordered by their last write time, the last accesses are not persisted
+void
+TranscodeCache::load()
+{
+	std::vector<std::tuple<std::time_t, std::string, std::uintmax_t>> files;
+
+	boost::system::error_code ec;
+	for (boost::filesystem::directory_iterator it {_directory, ec}, end; !ec && it != end; it.increment(ec))
+	{
+		const boost::filesystem::path& path {it->path()};
+		if (!boost::filesystem::is_regular_file(path))
+			continue;
+
+		// Left by an interrupted transcode
+		if (path.extension() == tmpExtension)
+		{
+			boost::system::error_code removeEc;
+			boost::filesystem::remove(path, removeEc);
+			continue;
+		}
+
+		boost::system::error_code fileEc;
+		const std::uintmax_t size {boost::filesystem::file_size(path, fileEc)};
+		const std::time_t lastWriteTime {boost::filesystem::last_write_time(path, fileEc)};
+		if (!fileEc)
+			files.emplace_back(lastWriteTime, path.filename().string(), size);
+	}
+
+	std::sort(std::begin(files), std::end(files));
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	for (const auto& file : files)
+	{
+		_lru.push_front(std::get<1>(file));
+		_entries.emplace(std::get<1>(file), Entry {std::get<2>(file), _lru.begin()});
+		_size += std::get<2>(file);
+	}
+
+	evict();
+}
+
+void
+TranscodeCache::add(const std::string& key, std::uintmax_t size)
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_entries.find(key)};
+	if (it != _entries.end())
+	{
+		// Replaced by the rename
+		_size -= it->second.size;
+		_lru.erase(it->second.itLru);
+		_entries.erase(it);
+	}
+
+	_lru.push_front(key);
+	_entries.emplace(key, Entry {size, _lru.begin()});
+	_size += size;
+
+	evict();
+}
+
+void
+TranscodeCache::remove(const std::string& key)
+{
+	auto it {_entries.find(key)};
+	if (it == _entries.end())
+		return;
+
+	// Files being served remain readable until closed
+	boost::system::error_code ec;
+	boost::filesystem::remove(getEntryPath(key), ec);
+
+	_size -= it->second.size;
+	_lru.erase(it->second.itLru);
+	_entries.erase(it);
+}
+
+void
+TranscodeCache::evict()
+{
+	while (_size > _maxSize && !_lru.empty())
+	{
+		const std::string key {_lru.back()};
+
+		LMS_LOG(TRANSCODE, DEBUG) << "Evicting cache entry '" << key << "'";
+		remove(key);
+		_evictions++;
+	}
+}
+
+} // namespace Av
+
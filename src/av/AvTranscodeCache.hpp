@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "AvTranscoder.hpp"
+
+namespace Av {
+
+// Complete transcoder outputs stored on disk, keyed by the source checksum and the transcode parameters
+// Least recently used entries are removed once the total size exceeds the budget
+class TranscodeCache
+{
+	public:
+		// Fills a new entry, added to the cache once committed
+		// Destroying an uncommitted writer discards the entry
+		class Writer
+		{
+			public:
+				~Writer();
+
+				Writer(const Writer&) = delete;
+				Writer& operator=(const Writer&) = delete;
+
+				void write(const unsigned char* data, std::size_t size);
+				void commit();
+
+			private:
+				friend class TranscodeCache;
+
+				Writer(TranscodeCache& cache, const std::string& key, const boost::filesystem::path& tmpPath);
+
+				TranscodeCache&			_cache;
+				const std::string		_key;
+				const boost::filesystem::path	_tmpPath;
+				std::ofstream			_ofs;
+				std::uintmax_t			_size {};
+				bool				_failed {};
+				bool				_committed {};
+		};
+
+		// Opened under the cache lock, so that it remains readable once evicted
+		struct CachedFile
+		{
+			boost::filesystem::path	path;
+			std::ifstream		stream;
+			std::uintmax_t		size;
+			std::time_t		lastWriteTime;
+		};
+
+		struct Stats
+		{
+			std::size_t	hits {};	// since startup
+			std::size_t	misses {};	// since startup
+			std::size_t	evictions {};	// since startup
+			std::size_t	entries {};
+			std::uintmax_t	size {};
+			std::uintmax_t	maxSize {};
+		};
+
+		TranscodeCache(const boost::filesystem::path& directory, std::uintmax_t maxSize);
+
+		TranscodeCache(const TranscodeCache&) = delete;
+		TranscodeCache& operator=(const TranscodeCache&) = delete;
+
+		// Only complete transcodes of the whole file can be cached
+		static bool isCacheable(const TranscodeParameters& parameters);
+		static std::string computeKey(const std::vector<unsigned char>& checksum, const TranscodeParameters& parameters);
+
+		// Cached output, if any and if more recent than the source file
+		std::unique_ptr<CachedFile> get(const std::string& key, const boost::filesystem::path& sourceFile);
+
+		std::unique_ptr<Writer> createWriter(const std::string& key);
+
+		Stats getStats() const;
+
+	private:
+		struct Entry
+		{
+			std::uintmax_t				size;
+			std::list<std::string>::iterator	itLru;
+		};
+
+		boost::filesystem::path getEntryPath(const std::string& key) const;
+		void load();
+		void add(const std::string& key, std::uintmax_t size);
+		void remove(const std::string& key);
+		void evict();
+
+		const boost::filesystem::path	_directory;
+		const std::uintmax_t		_maxSize;
+
+		mutable std::mutex				_mutex;
+		std::unordered_map<std::string, Entry>		_entries;
+		std::list<std::string>				_lru;	// most recently used first
+		std::uintmax_t					_size {};
+		std::size_t					_nextWriterId {};
+
+		std::size_t					_hits {};
+		std::size_t					_misses {};
+		std::size_t					_evictions {};
+};
+
+} // namespace Av
+
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvTranscodeRegistry.hpp"
+
+#include <sstream>
+
+#include "utils/Logger.hpp"
+
+namespace Av {
+
+TranscodeRegistry::TranscodeRegistry(TranscodeScheduler* scheduler, TranscodeCache* cache)
+: _scheduler {scheduler},
+_cache {cache}
+{
+}
+
+std::shared_ptr<SharedTranscode>
+TranscodeRegistry::getOrCreate(const boost::filesystem::path& file, const TranscodeParameters& parameters, const std::string& user, TranscodeScheduler::Priority priority, const std::string& cacheKey)
+{
+	const std::string key {computeKey(file, parameters)};
+
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	auto it {_transcodes.find(key)};
+	if (it != _transcodes.end())
+	{
+		if (std::shared_ptr<SharedTranscode> transcode {it->second.lock()})
+		{
+			LMS_LOG(TRANSCODE, DEBUG) << "Joining transcode in progress of file '" << file.string() << "'";
+			_joinedCount++;
+			return transcode;
+		}
+	}
+
+	std::unique_ptr<TranscodeScheduler::Ticket> ticket;
+	if (_scheduler)
+	{
+		ticket = _scheduler->enqueue(user, priority);
+		if (!ticket)
+			return nullptr;
+	}
+
+	std::unique_ptr<TranscodeCache::Writer> cacheWriter;
+	if (_cache && !cacheKey.empty())
+		cacheWriter = _cache->createWriter(cacheKey);
+
+	auto transcode {std::make_shared<SharedTranscode>(file, parameters, std::move(ticket), std::move(cacheWriter))};
+
+	// Purge the transcodes that have been left
+	for (auto itTranscode {_transcodes.begin()}; itTranscode != _transcodes.end();)
+	{
+		if (itTranscode->second.expired())
+			itTranscode = _transcodes.erase(itTranscode);
+		else
+			++itTranscode;
+	}
+
+	_transcodes[key] = transcode;
+	_startedCount++;
+
+	return transcode;
+}
+
+TranscodeRegistry::Stats
+TranscodeRegistry::getStats() const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	Stats stats;
+	for (const auto& itTranscode : _transcodes)
+	{
+		if (!itTranscode.second.expired())
+			stats.inProgress++;
+	}
+	stats.started = _startedCount;
+	stats.joined = _joinedCount;
+
+	return stats;
+}
+
+std::string
+TranscodeRegistry::computeKey(const boost::filesystem::path& file, const TranscodeParameters& parameters)
+{
+	std::ostringstream oss;
+
+	oss << file.string() << '\0'
+		<< (parameters.encoding ? static_cast<int>(*parameters.encoding) : -1) << '/'
+		<< parameters.bitrate << '/'
+		<< (parameters.stream ? static_cast<long long>(*parameters.stream) : -1) << '/'
+		<< (parameters.offset ? parameters.offset->count() : 0) << '/'
+		<< parameters.stripMetadata;
+
+	return oss.str();
+}
+
+} // namespace Av
+
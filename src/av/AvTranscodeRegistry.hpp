@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "AvSharedTranscode.hpp"
+#include "AvTranscodeCache.hpp"
+#include "AvTranscodeScheduler.hpp"
+
+namespace Av {
+
+// Transcodes in progress, keyed by their file and parameters
+// Identical concurrent requests share the same transcoder
+class TranscodeRegistry
+{
+	public:
+		struct Stats
+		{
+			std::size_t	inProgress {};
+			std::size_t	started {};	// since startup
+			std::size_t	joined {};	// since startup
+		};
+
+		TranscodeRegistry(TranscodeScheduler* scheduler, TranscodeCache* cache);
+
+		TranscodeRegistry(const TranscodeRegistry&) = delete;
+		TranscodeRegistry& operator=(const TranscodeRegistry&) = delete;
+
+		// Joins the transcode in progress with the same file and parameters, or starts a new one
+		// Returns nullptr if a new transcode is needed and the scheduler rejected it
+		// A new transcode also fills the cache entry cacheKey, if not empty
+		std::shared_ptr<SharedTranscode> getOrCreate(const boost::filesystem::path& file, const TranscodeParameters& parameters, const std::string& user, TranscodeScheduler::Priority priority, const std::string& cacheKey = "");
+
+		Stats getStats() const;
+
+	private:
+		static std::string computeKey(const boost::filesystem::path& file, const TranscodeParameters& parameters);
+
+		TranscodeScheduler*	_scheduler;
+		TranscodeCache*		_cache;
+
+		mutable std::mutex					_mutex;
+		std::map<std::string, std::weak_ptr<SharedTranscode>>	_transcodes;
+		std::size_t						_startedCount {};
+		std::size_t						_joinedCount {};
+};
+
+} // namespace Av
+
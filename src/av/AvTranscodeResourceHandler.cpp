@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvTranscodeResourceHandler.hpp"
+
+#include "utils/FileResourceHandler.hpp"
+#include "utils/Logger.hpp"
+
+namespace Av {
+
+std::shared_ptr<TranscodeResourceHandler>
+TranscodeResourceHandler::create(std::shared_ptr<SharedTranscode> transcode)
+{
+	return std::make_shared<TranscodeResourceHandler>(std::move(transcode));
+}
+
+TranscodeResourceHandler::TranscodeResourceHandler(std::shared_ptr<SharedTranscode> transcode)
+: _transcode {std::move(transcode)}
+{
+}
+
+void
+TranscodeResourceHandler::processRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	if (!request.continuation())
+		response.setMimeType(_transcode->getOutputMimeType());
+
+	// Written directly from the shared output
+	const SharedTranscode::Data data {_transcode->getData(_offset)};
+	if (data.size > 0)
+	{
+		response.out().write(reinterpret_cast<const char*>(data.data), data.size);
+		if (!response.out())
+		{
+			LMS_LOG(TRANSCODE, ERROR) << "Write failed!";
+			return;
+		}
+
+		_offset += data.size;
+	}
+
+	if (_transcode->isComplete(_offset))
+		return;
+
+	Wt::Http::ResponseContinuation* continuation {response.createContinuation()};
+	continuation->setData(shared_from_this());
+
+	// More data may already be available, continue as soon as this chunk is sent
+	if (data.size > 0)
+		return;
+
+	continuation->waitForMoreData();
+
+	// Not keeping the handler alive, so that the transcode is released as soon as the client has gone away
+	_transcode->waitForData(_offset, [continuation = std::weak_ptr<Wt::Http::ResponseContinuation> {continuation->shared_from_this()}]
+	{
+		if (auto readyContinuation {continuation.lock()})
+			readyContinuation->haveMoreData();
+	});
+}
+
+std::shared_ptr<ResourceHandler>
+createTranscodeResourceHandler(TranscodeRegistry& registry,
+		TranscodeCache* cache,
+		const boost::filesystem::path& file,
+		const std::vector<unsigned char>& checksum,
+		const TranscodeParameters& parameters,
+		const std::string& user,
+		TranscodeScheduler::Priority priority)
+{
+	std::string cacheKey;
+	if (cache && !checksum.empty() && TranscodeCache::isCacheable(parameters))
+	{
+		cacheKey = TranscodeCache::computeKey(checksum, parameters);
+
+		// Transcoded again if the entry cannot be opened
+		if (std::unique_ptr<TranscodeCache::CachedFile> cachedFile {cache->get(cacheKey, file)})
+		{
+			LMS_LOG(TRANSCODE, DEBUG) << "Serving cached transcode of file '" << file.string() << "'";
+			return FileResourceHandler::create(std::move(cachedFile->stream), cachedFile->path, cachedFile->size, cachedFile->lastWriteTime, encodingToMimetype(*parameters.encoding));
+		}
+	}
+
+	std::shared_ptr<SharedTranscode> transcode {registry.getOrCreate(file, parameters, user, priority, cacheKey)};
+	if (!transcode)
+		return nullptr;
+
+	LMS_LOG(TRANSCODE, DEBUG) << "Mime type set to '" << transcode->getOutputMimeType() << "'";
+
+	return TranscodeResourceHandler::create(std::move(transcode));
+}
+
+} // namespace Av
+
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "utils/ResourceHandler.hpp"
+#include "AvSharedTranscode.hpp"
+#include "AvTranscodeCache.hpp"
+#include "AvTranscodeRegistry.hpp"
+
+namespace Av {
+
+// Streams the output of a shared transcode, from its beginning
+// Continuations wait for the transcode output to be available, so that no thread is blocked meanwhile
+class TranscodeResourceHandler final : public ResourceHandler
+{
+	public:
+		static std::shared_ptr<TranscodeResourceHandler> create(std::shared_ptr<SharedTranscode> transcode);
+
+		void processRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+		TranscodeResourceHandler(std::shared_ptr<SharedTranscode> transcode);
+
+	private:
+		std::shared_ptr<SharedTranscode>	_transcode;
+		std::size_t				_offset {};
+};
+
+// Serves the cached output of the transcode if any, otherwise joins or starts the transcode, that fills the cache if possible
+// checksum is the one of the source file, the cache is not used if empty
+// Returns nullptr if the scheduler rejected the transcode
+std::shared_ptr<ResourceHandler> createTranscodeResourceHandler(TranscodeRegistry& registry,
+		TranscodeCache* cache,
+		const boost::filesystem::path& file,
+		const std::vector<unsigned char>& checksum,
+		const TranscodeParameters& parameters,
+		const std::string& user,
+		TranscodeScheduler::Priority priority);
+
+} // namespace Av
+
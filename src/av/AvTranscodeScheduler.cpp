@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AvTranscodeScheduler.hpp"
+
+#include <algorithm>
+
+#include "utils/Logger.hpp"
+
+namespace Av {
+
+static
+void
+decrementCount(std::map<std::string, std::size_t>& counts, const std::string& user)
+{
+	auto it {counts.find(user)};
+	if (it != counts.end() && --it->second == 0)
+		counts.erase(it);
+}
+
+static
+std::size_t
+getCount(const std::map<std::string, std::size_t>& counts, const std::string& user)
+{
+	auto it {counts.find(user)};
+	return it != counts.end() ? it->second : 0;
+}
+
+TranscodeScheduler::Ticket::Ticket(TranscodeScheduler& scheduler, const std::string& user, Priority priority, std::uint64_t sequence)
+: _scheduler {scheduler},
+_user {user},
+_priority {priority},
+_sequence {sequence}
+{
+}
+
+TranscodeScheduler::Ticket::~Ticket()
+{
+	_scheduler.release(*this);
+}
+
+bool
+TranscodeScheduler::Ticket::isAdmitted() const
+{
+	std::unique_lock<std::mutex> lock {_scheduler._mutex};
+
+	return _admitted;
+}
+
+void
+TranscodeScheduler::Ticket::setAdmittedCallback(std::function<void()> callback)
+{
+	{
+		std::unique_lock<std::mutex> lock {_scheduler._mutex};
+
+		if (!_admitted)
+		{
+			_admittedCallback = std::move(callback);
+			return;
+		}
+	}
+
+	callback();
+}
+
+TranscodeScheduler::TranscodeScheduler(std::size_t maxRunning, std::size_t maxPerUser, std::size_t maxQueueSize)
+: _maxRunning {std::max(maxRunning, std::size_t {1})},
+_maxPerUser {maxPerUser},
+_maxQueueSize {maxQueueSize}
+{
+	LMS_LOG(TRANSCODE, INFO) << "Transcode scheduler: max running = " << _maxRunning << ", max per user = " << _maxPerUser << ", max queue size = " << _maxQueueSize;
+}
+
+std::unique_ptr<TranscodeScheduler::Ticket>
+TranscodeScheduler::enqueue(const std::string& user, Priority priority)
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	// The queued requests cannot run, otherwise they would have been admitted already
+	if (!canRun(user) && _maxQueueSize > 0 && _queue.size() >= _maxQueueSize)
+	{
+		_rejectedCount++;
+		LMS_LOG(TRANSCODE, INFO) << "Transcode rejected for user '" << user << "': queue is full (" << _queue.size() << " requests)";
+		return nullptr;
+	}
+
+	std::unique_ptr<Ticket> ticket {new Ticket {*this, user, priority, _nextSequence++}};
+
+	if (canRun(user))
+	{
+		// No callback can be set yet
+		Callbacks callbacks;
+		admit(*ticket, callbacks);
+	}
+	else
+	{
+		_queue.push_back(ticket.get());
+		_queuedPerUser[user]++;
+		LMS_LOG(TRANSCODE, DEBUG) << "Transcode queued for user '" << user << "', queue size = " << _queue.size();
+	}
+
+	return ticket;
+}
+
+std::size_t
+TranscodeScheduler::getUserLoad(const std::string& user) const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	return getCount(_runningPerUser, user) + getCount(_queuedPerUser, user);
+}
+
+TranscodeScheduler::Stats
+TranscodeScheduler::getStats() const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	Stats stats;
+	stats.running = _running;
+	stats.queued = _queue.size();
+	stats.admitted = _admittedCount;
+	stats.rejected = _rejectedCount;
+	if (_admittedCount > 0)
+		stats.averageWait = std::chrono::duration_cast<std::chrono::milliseconds>(_totalWait / _admittedCount);
+	stats.maxWait = std::chrono::duration_cast<std::chrono::milliseconds>(_maxWait);
+
+	return stats;
+}
+
+bool
+TranscodeScheduler::canRun(const std::string& user) const
+{
+	if (_running >= _maxRunning)
+		return false;
+
+	return _maxPerUser == 0 || getCount(_runningPerUser, user) < _maxPerUser;
+}
+
+void
+TranscodeScheduler::admit(Ticket& ticket, Callbacks& callbacks)
+{
+	ticket._admitted = true;
+	_running++;
+	_runningPerUser[ticket._user]++;
+
+	const std::chrono::steady_clock::duration wait {std::chrono::steady_clock::now() - ticket._enqueueTime};
+	_admittedCount++;
+	_totalWait += wait;
+	_maxWait = std::max(_maxWait, wait);
+
+	if (ticket._admittedCallback)
+	{
+		callbacks.push_back(std::move(ticket._admittedCallback));
+		ticket._admittedCallback = nullptr;
+	}
+}
+
+void
+TranscodeScheduler::admitQueued(Callbacks& callbacks)
+{
+	while (_running < _maxRunning)
+	{
+		// Highest priority first, then oldest first
+		auto itBest {_queue.end()};
+		for (auto it {_queue.begin()}; it != _queue.end(); ++it)
+		{
+			if (!canRun((*it)->_user))
+				continue;
+
+			if (itBest == _queue.end()
+					|| std::make_pair((*it)->_priority, (*it)->_sequence) < std::make_pair((*itBest)->_priority, (*itBest)->_sequence))
+				itBest = it;
+		}
+
+		if (itBest == _queue.end())
+			break;
+
+		Ticket& ticket {**itBest};
+		_queue.erase(itBest);
+		decrementCount(_queuedPerUser, ticket._user);
+
+		LMS_LOG(TRANSCODE, DEBUG) << "Transcode admitted for user '" << ticket._user << "' after " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ticket._enqueueTime).count() << " ms";
+		admit(ticket, callbacks);
+	}
+}
+
+void
+TranscodeScheduler::release(Ticket& ticket)
+{
+	Callbacks callbacks;
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		if (ticket._admitted)
+		{
+			_running--;
+			decrementCount(_runningPerUser, ticket._user);
+
+			admitQueued(callbacks);
+		}
+		else
+		{
+			_queue.erase(std::remove(std::begin(_queue), std::end(_queue), &ticket), std::end(_queue));
+			decrementCount(_queuedPerUser, ticket._user);
+		}
+	}
+
+	for (auto& callback : callbacks)
+		callback();
+}
+
+} // namespace Av
+
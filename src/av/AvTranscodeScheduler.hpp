@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Av {
+
+// Limits the number of transcoders running at the same time, globally and per user
+// Requests exceeding the limits are queued, by priority and then by arrival order
+// Requests are rejected if the queue is full
+class TranscodeScheduler
+{
+	public:
+		// Ordered from the highest priority
+		enum class Priority
+		{
+			Playing,	// track being listened to
+			Prefetch,	// track requested ahead of time
+		};
+
+		// Keeps a queued or a running transcode accounted
+		// Destroying the ticket leaves the queue, or releases the slot once the transcode is done
+		class Ticket
+		{
+			public:
+				~Ticket();
+
+				Ticket(const Ticket&) = delete;
+				Ticket& operator=(const Ticket&) = delete;
+
+				bool isAdmitted() const;
+
+				// The callback is called once the transcode can start, immediately if it already can
+				// It may be called from any thread, but never with the scheduler lock held
+				void setAdmittedCallback(std::function<void()> callback);
+
+			private:
+				friend class TranscodeScheduler;
+
+				Ticket(TranscodeScheduler& scheduler, const std::string& user, Priority priority, std::uint64_t sequence);
+
+				TranscodeScheduler&			_scheduler;
+				const std::string			_user;
+				const Priority				_priority;
+				const std::uint64_t			_sequence;
+				const std::chrono::steady_clock::time_point	_enqueueTime {std::chrono::steady_clock::now()};
+
+				bool					_admitted {};
+				std::function<void()>			_admittedCallback;
+		};
+
+		struct Stats
+		{
+			std::size_t			running {};
+			std::size_t			queued {};
+			std::size_t			admitted {};	// since startup
+			std::size_t			rejected {};	// since startup
+			std::chrono::milliseconds	averageWait {};	// of the admitted requests
+			std::chrono::milliseconds	maxWait {};
+		};
+
+		// maxPerUser and maxQueueSize set to 0 mean no limit
+		TranscodeScheduler(std::size_t maxRunning, std::size_t maxPerUser, std::size_t maxQueueSize);
+
+		TranscodeScheduler(const TranscodeScheduler&) = delete;
+		TranscodeScheduler& operator=(const TranscodeScheduler&) = delete;
+
+		// Returns nullptr if the request is rejected
+		std::unique_ptr<Ticket> enqueue(const std::string& user, Priority priority);
+
+		// Number of transcodes running or queued for this user
+		std::size_t getUserLoad(const std::string& user) const;
+
+		Stats getStats() const;
+
+	private:
+		using Callbacks = std::vector<std::function<void()>>;
+
+		bool canRun(const std::string& user) const;
+		void admit(Ticket& ticket, Callbacks& callbacks);
+		void admitQueued(Callbacks& callbacks);
+		void release(Ticket& ticket);
+
+		const std::size_t	_maxRunning;
+		const std::size_t	_maxPerUser;
+		const std::size_t	_maxQueueSize;
+
+		mutable std::mutex			_mutex;
+		std::vector<Ticket*>			_queue;
+		std::size_t				_running {};
+		std::map<std::string, std::size_t>	_runningPerUser;
+		std::map<std::string, std::size_t>	_queuedPerUser;
+		std::uint64_t				_nextSequence {};
+
+		std::size_t				_admittedCount {};
+		std::size_t				_rejectedCount {};
+		std::chrono::steady_clock::duration	_totalWait {};
+		std::chrono::steady_clock::duration	_maxWait {};
+};
+
+} // namespace Av
+
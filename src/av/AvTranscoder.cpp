@@ -20,7 +20,13 @@
 #include "AvTranscoder.hpp"
 
 #include <atomic>
-#include <mutex>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/asio/read.hpp>
 
 #include "AvInfo.hpp"
 #include "utils/Path.hpp"
@@ -37,13 +43,66 @@ static const std::vector<std::string> execNames =
 	"ffmpeg",
 };
 
-static std::mutex		transcoderMutex;
 static boost::filesystem::path	avConvPath = boost::filesystem::path();
+static boost::asio::io_service*	ioService {};
 static std::atomic<size_t>	globalId = {0};
 
+// Spawns the process with its stdout redirected to the returned pipe
+// stdin and stderr are redirected to /dev/null, so that nothing can block the child
+// Returns the pid of the child, or -1 on error
+static
+pid_t
+spawnProcess(const std::vector<std::string>& args, int& outputFd)
+{
+	// Everything has to be prepared before forking
+	std::vector<char*> argv;
+	for (const std::string& arg : args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	int pipeFds[2];
+	if (pipe2(pipeFds, O_CLOEXEC) < 0)
+		return -1;
+
+	const int nullFd {open("/dev/null", O_RDWR | O_CLOEXEC)};
+	if (nullFd < 0)
+	{
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+		return -1;
+	}
+
+	const pid_t pid {fork()};
+	if (pid == 0)
+	{
+		// Only async-signal-safe calls from here
+		if (dup2(pipeFds[1], STDOUT_FILENO) < 0
+				|| dup2(nullFd, STDIN_FILENO) < 0
+				|| dup2(nullFd, STDERR_FILENO) < 0)
+			_exit(127);
+
+		execv(argv[0], argv.data());
+		_exit(127);
+	}
+
+	close(pipeFds[1]);
+	close(nullFd);
+
+	if (pid < 0)
+	{
+		close(pipeFds[0]);
+		return -1;
+	}
+
+	outputFd = pipeFds[0];
+	return pid;
+}
+
 void
-Transcoder::init()
+Transcoder::init(boost::asio::io_service& service)
 {
+	ioService = &service;
+
 	for (std::string execName : execNames)
 	{
 		boost::filesystem::path p = searchExecPath(execName);
@@ -66,7 +125,16 @@ Transcoder::Transcoder(boost::filesystem::path filePath, TranscodeParameters par
   _isComplete(false),
   _id(globalId++)
 {
-
+	// The output mime type must be known before starting, since the transcode may be queued
+	if (_parameters.encoding)
+	{
+		_outputMimeType = encodingToMimetype(*_parameters.encoding);
+	}
+	else if (auto mediaFileFormat {guessMediaFileFormat(_filePath)})
+	{
+		_outputMimeType = mediaFileFormat->mimeType;
+		_copyFormat = mediaFileFormat->format;
+	}
 }
 
 bool
@@ -156,14 +224,10 @@ Transcoder::start()
 			default:
 				return false;
 		}
-
-		_outputMimeType = encodingToMimetype(*_parameters.encoding);
 	}
 	else
 	{
-		auto mediaFileFormat {guessMediaFileFormat(_filePath)};
-
-		if (!mediaFileFormat)
+		if (_copyFormat.empty())
 		{
 			LMS_LOG(AV, ERROR) << "Cannot guess media file format for '" << _filePath.string() << "'";
 			return false;
@@ -172,9 +236,7 @@ Transcoder::start()
 		args.push_back("-acodec");
 		args.push_back("copy");
 		args.push_back("-f");
-		args.push_back(mediaFileFormat->format);
-
-		_outputMimeType = mediaFileFormat->mimeType;
+		args.push_back(_copyFormat);
 	}
 
 	args.push_back("pipe:1");
@@ -183,84 +245,105 @@ Transcoder::start()
 	for (std::string arg : args)
 		LMS_LOG_TRANSCODE(DEBUG) << "Arg = '" << arg << "'";
 
-	// make sure only one thread is executing this part of code
+	int outputFd {-1};
+	_childPid = spawnProcess(args, outputFd);
+	if (_childPid < 0)
 	{
-		std::lock_guard<std::mutex> lock(transcoderMutex);
-
-		_child = std::make_shared<redi::ipstream>();
-
-		// Caution: stdin must have been closed before
-		_child->open(avConvPath.string(), args);
-		if (!_child->is_open())
-		{
-			LMS_LOG_TRANSCODE(DEBUG) << "Exec failed!";
-			return false;
-		}
-
-		if (_child->out().eof())
-		{
-			LMS_LOG_TRANSCODE(DEBUG) << "Early end of file!";
-			return false;
-		}
-
+		LMS_LOG_TRANSCODE(ERROR) << "Exec failed!";
+		return false;
 	}
+
+	_output = std::make_unique<boost::asio::posix::stream_descriptor>(*ioService, outputFd);
 	LMS_LOG_TRANSCODE(DEBUG) << "Stream opened!";
 
 	return true;
 }
 
 void
-Transcoder::process(std::vector<unsigned char>& output, std::size_t maxSize)
+Transcoder::asyncRead(unsigned char* buffer, std::size_t bufferSize, ReadCallback callback)
 {
-	if (!_child || _isComplete)
-		return;
-
-	if (_child->out().fail())
+	if (!_output || _isComplete)
 	{
-		LMS_LOG_TRANSCODE(DEBUG) << "Stdout FAILED 2";
+		_isComplete = true;
+		ioService->post([callback] { callback(0); });
+		return;
 	}
 
-	if (_child->out().eof())
+	// Wait for the buffer to be full to limit the number of continuations
+	boost::asio::async_read(*_output, boost::asio::buffer(buffer, bufferSize),
+		[this, callback](const boost::system::error_code& ec, std::size_t nbReadBytes)
+		{
+			_total += nbReadBytes;
+
+			if (ec)
+			{
+				if (ec == boost::asio::error::eof)
+				{
+					LMS_LOG_TRANSCODE(DEBUG) << "Stdout EOF!";
+					_isSuccess = waitForSuccessfulExit();
+				}
+				else
+					LMS_LOG_TRANSCODE(ERROR) << "Read failed: " << ec.message();
+
+				_isComplete = true;
+				_output.reset();
+			}
+
+			LMS_LOG_TRANSCODE(DEBUG) << "nb bytes = " << nbReadBytes << ", total = " << _total;
+
+			callback(nbReadBytes);
+		});
+}
+
+// Called once the output is closed, when the child is exiting
+// Not reaping the child, so that its pid cannot be reused before abort() or the destructor
+bool
+Transcoder::waitForSuccessfulExit()
+{
+	siginfo_t info {};
+	if (waitid(P_PID, _childPid, &info, WEXITED | WNOWAIT) < 0)
 	{
-		LMS_LOG_TRANSCODE(DEBUG) << "Stdout ENDED 2";
+		LMS_LOG_TRANSCODE(ERROR) << "Cannot get the transcoder exit status";
+		return false;
 	}
 
-	output.resize(maxSize);
-
-	//Read on the output stream
-	_child->out().read(reinterpret_cast<char*>(&output[0]), maxSize);
-	output.resize(_child->out().gcount());
-
-	if (_child->out().fail())
+	// Killed when aborted
+	if (info.si_code != CLD_EXITED)
 	{
-		LMS_LOG_TRANSCODE(DEBUG) << "Stdout FAILED";
+		LMS_LOG_TRANSCODE(DEBUG) << "Transcoder killed by signal " << info.si_status;
+		return false;
 	}
 
-	if (_child->out().eof())
+	if (info.si_status != 0)
 	{
-		LMS_LOG_TRANSCODE(DEBUG) << "Stdout EOF!";
-		_child->clear();
-
-		_isComplete = true;
-		_child.reset();
+		LMS_LOG_TRANSCODE(ERROR) << "Transcoder failed, exit status = " << info.si_status;
+		return false;
 	}
 
-	_total += output.size();
+	return true;
+}
 
-	LMS_LOG_TRANSCODE(DEBUG) << "nb bytes = " << output.size() << ", total = " << _total;
+void
+Transcoder::abort()
+{
+	if (_childPid > 0)
+	{
+		LMS_LOG_TRANSCODE(DEBUG) << "Aborting";
+		kill(_childPid, SIGKILL);
+	}
 }
 
 Transcoder::~Transcoder()
 {
 	LMS_LOG_TRANSCODE(DEBUG) << ", ~Transcoder called! Total produced bytes = " << _total;
 
-	if (_child)
+	_output.reset();
+
+	if (_childPid > 0)
 	{
-		LMS_LOG_TRANSCODE(DEBUG) << "Child still here!";
-		_child->rdbuf()->kill(SIGKILL);
-		LMS_LOG_TRANSCODE(DEBUG) << "Closing...";
-		_child->rdbuf()->close();
-		LMS_LOG_TRANSCODE(DEBUG) << "Closing DONE";
+		// The child may already have exited, but it still has to be reaped
+		kill(_childPid, SIGKILL);
+		waitpid(_childPid, nullptr, 0);
 	}
 }
 
@@ -20,9 +20,13 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <memory>
 
-#include <pstreams/pstream.h>
+#include <sys/types.h>
 
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
 
@@ -30,8 +34,6 @@
 
 namespace Av {
 
-
-
 struct TranscodeParameters
 {
 	boost::optional<Encoding>		encoding; // If not set, no transcoding is performed
@@ -44,7 +46,8 @@ struct TranscodeParameters
 class Transcoder
 {
 	public:
-		static void init();
+		// Reads on the transcoder output are completed using the given io service
+		static void init(boost::asio::io_service& ioService);
 
 		Transcoder(boost::filesystem::path file, TranscodeParameters parameters);
 		~Transcoder();
@@ -55,24 +58,41 @@ class Transcoder
 
 		bool start();
 		const std::string& getOutputMimeType() const { return _outputMimeType; }
-		void process(std::vector<unsigned char>& output, std::size_t maxSize);
+
+		// Reads some output, at most bufferSize bytes, without blocking the calling thread
+		// The callback is called from the io service threads once some data has been read, or once the output is complete
+		// Only one read can be pending at a time, and both the transcoder and buffer must stay valid until the callback is called
+		using ReadCallback = std::function<void(std::size_t nbReadBytes)>;
+		void asyncRead(unsigned char* buffer, std::size_t bufferSize, ReadCallback callback);
+
 		bool isComplete(void) const { return _isComplete; }
 
+		// Once complete, whether the whole output has been read and the child exited normally
+		bool isSuccess(void) const { return _isSuccess; }
+
+		// Kills the child, the pending read completes with the output produced so far
+		void abort();
+
 		const TranscodeParameters& getParameters() const { return _parameters; }
 
 
 	private:
 		Transcoder();
 
+		bool waitForSuccessfulExit();
+
 		boost::filesystem::path	_filePath;
 		TranscodeParameters	_parameters;
 
-		std::shared_ptr<redi::ipstream>	_child;
+		pid_t						_childPid {-1};
+		std::unique_ptr<boost::asio::posix::stream_descriptor>	_output;
 
 		bool			_isComplete = false;
+		bool			_isSuccess = false;
 		std::size_t		_total = 0;
 		std::size_t		_id;
 		std::string		_outputMimeType;
+		std::string		_copyFormat; // output format if no transcoding is performed
 };
 
 } // namespace Av
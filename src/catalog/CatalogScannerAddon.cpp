@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CatalogScannerAddon.hpp"
+
+#include <chrono>
+
+#include "utils/Logger.hpp"
+
+namespace Catalog {
+
+ScannerAddon::ScannerAddon(Wt::Dbo::SqlConnectionPool& connectionPool)
+: _db {connectionPool}
+{
+	updateSnapshot();
+}
+
+std::shared_ptr<const Snapshot>
+ScannerAddon::getSnapshot()
+{
+	return std::atomic_load(&_snapshot);
+}
+
+void
+ScannerAddon::requestStop()
+{
+	_stopRequested = true;
+}
+
+void
+ScannerAddon::preScanComplete()
+{
+	updateSnapshot();
+}
+
+void
+ScannerAddon::databaseReplaced()
+{
+	updateSnapshot();
+}
+
+void
+ScannerAddon::updateSnapshot()
+{
+	LMS_LOG(DBUPDATER, DEBUG) << "Building catalog snapshot...";
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	std::shared_ptr<const Snapshot> snapshot {Snapshot::build(_db.getSession(), _stopRequested)};
+	if (!snapshot)
+	{
+		LMS_LOG(DBUPDATER, INFO) << "Catalog snapshot build aborted";
+		return;
+	}
+
+	// Previous snapshot remains valid for its current readers
+	std::atomic_store(&_snapshot, snapshot);
+
+	LMS_LOG(DBUPDATER, INFO) << "New catalog snapshot published: " << snapshot->getTracks().size() << " tracks, "
+		<< snapshot->getReleases().size() << " releases, "
+		<< snapshot->getArtistsByName().size() << " artists, "
+		<< snapshot->getClusters().size() << " clusters, built in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms";
+}
+
+} // namespace Catalog
+
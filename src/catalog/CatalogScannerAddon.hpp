@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+#include "database/DatabaseHandler.hpp"
+#include "scanner/MediaScannerAddon.hpp"
+
+#include "CatalogSnapshot.hpp"
+
+namespace Catalog {
+
+// Rebuilds the catalog snapshot each time a scan completes
+class ScannerAddon final : public Scanner::MediaScannerAddon
+{
+	public:
+
+		ScannerAddon(Wt::Dbo::SqlConnectionPool& connectionPool);
+
+		// May be empty if no snapshot has been built yet
+		std::shared_ptr<const Snapshot> getSnapshot();
+
+	private:
+
+		void refreshSettings() override {}
+		void requestStop() override;
+		void trackAdded(Database::IdType trackId) override {}
+		void trackToRemove(Database::IdType trackId) override {}
+		void trackUpdated(Database::IdType trackId) override {}
+		void preScanComplete() override;
+		void databaseReplaced() override;
+
+		void updateSnapshot();
+
+		Database::Handler			_db;
+		std::shared_ptr<const Snapshot>		_snapshot;
+		bool					_stopRequested {false};
+};
+
+} // namespace Catalog
+
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CatalogSnapshot.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include <Wt/Dbo/Transaction.h>
+
+namespace Catalog {
+
+namespace {
+
+using Database::IdType;
+using Link = std::pair<IdType, IdType>;
+
+class StringPool
+{
+	public:
+		StringPool(std::vector<std::string>& strings) : _strings {strings} {}
+
+		Snapshot::StringId intern(const std::string& str)
+		{
+			auto it {_ids.find(str)};
+			if (it != _ids.end())
+				return it->second;
+
+			const Snapshot::StringId id {static_cast<Snapshot::StringId>(_strings.size())};
+			_strings.push_back(str);
+			_ids.emplace(str, id);
+
+			return id;
+		}
+
+	private:
+		std::vector<std::string>&				_strings;
+		std::unordered_map<std::string, Snapshot::StringId>	_ids;
+};
+
+template <typename Entity>
+const Entity*
+findById(const std::vector<Entity>& entities, IdType id)
+{
+	auto it {std::lower_bound(std::cbegin(entities), std::cend(entities), id,
+			[](const Entity& entity, IdType id) { return entity.id < id; })};
+
+	if (it == std::cend(entities) || it->id != id)
+		return nullptr;
+
+	return &(*it);
+}
+
+template <typename Entity>
+void
+sortById(std::vector<Entity>& entities)
+{
+	std::sort(std::begin(entities), std::end(entities), [](const Entity& a, const Entity& b) { return a.id < b.id; });
+}
+
+// Store the link targets of each entity in a single flat array
+// entities must be sorted by id
+template <typename Entity>
+void
+fillLinks(std::vector<Link> links, std::vector<Entity>& entities, Snapshot::Range Entity::* range, std::vector<IdType>& ids)
+{
+	std::sort(std::begin(links), std::end(links));
+	links.erase(std::unique(std::begin(links), std::end(links)), std::end(links));
+
+	ids.reserve(links.size());
+
+	auto itLink {std::cbegin(links)};
+	for (Entity& entity : entities)
+	{
+		while (itLink != std::cend(links) && itLink->first < entity.id)
+			++itLink;
+
+		(entity.*range).begin = ids.size();
+		for (; itLink != std::cend(links) && itLink->first == entity.id; ++itLink)
+			ids.push_back(itLink->second);
+		(entity.*range).end = ids.size();
+	}
+
+	ids.shrink_to_fit();
+}
+
+// Same order as the database "COLLATE NOCASE": only the ASCII letters are folded, whatever the locale
+unsigned char
+foldNoCase(unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+bool
+lessNoCase(const std::string& a, const std::string& b)
+{
+	return std::lexicographical_compare(std::cbegin(a), std::cend(a), std::cbegin(b), std::cend(b),
+			[](unsigned char x, unsigned char y) { return foldNoCase(x) < foldNoCase(y); });
+}
+
+} // namespace
+
+std::shared_ptr<Snapshot>
+Snapshot::build(Wt::Dbo::Session& session, const bool& stopRequested)
+{
+	auto snapshot {std::make_shared<Snapshot>()};
+	StringPool stringPool {snapshot->_strings};
+
+	std::vector<Link> trackArtistLinks;
+	std::vector<Link> trackClusterLinks;
+	std::vector<std::pair<IdType, std::string>> artistSortNames;	// only used to order the artists
+
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		{
+			using ResultType = std::tuple<IdType, std::string, boost::optional<IdType>>;
+			auto tracks {session.query<ResultType>("SELECT id, name, release_id FROM track").resultList()};
+
+			snapshot->_tracks.reserve(tracks.size());
+			for (const ResultType& track : tracks)
+				snapshot->_tracks.push_back({std::get<0>(track), stringPool.intern(std::get<1>(track)), std::get<2>(track).get_value_or(Wt::Dbo::dbo_default_traits::invalidId()), {}, {}});
+		}
+
+		if (stopRequested)
+			return {};
+
+		{
+			using ResultType = std::tuple<IdType, std::string>;
+			auto releases {session.query<ResultType>("SELECT id, name FROM release").resultList()};
+
+			snapshot->_releases.reserve(releases.size());
+			for (const ResultType& release : releases)
+				snapshot->_releases.push_back({std::get<0>(release), stringPool.intern(std::get<1>(release)), {}});
+		}
+
+		{
+			using ResultType = std::tuple<IdType, std::string, std::string>;
+			auto artists {session.query<ResultType>("SELECT id, name, sort_name FROM artist").resultList()};
+
+			snapshot->_artists.reserve(artists.size());
+			artistSortNames.reserve(artists.size());
+			for (const ResultType& artist : artists)
+			{
+				snapshot->_artists.push_back({std::get<0>(artist), stringPool.intern(std::get<1>(artist)), {}, {}});
+				artistSortNames.emplace_back(std::get<0>(artist), std::get<2>(artist));
+			}
+		}
+
+		{
+			using ResultType = std::tuple<IdType, std::string, IdType>;
+			auto clusters {session.query<ResultType>("SELECT id, name, cluster_type_id FROM cluster").resultList()};
+
+			snapshot->_clusters.reserve(clusters.size());
+			for (const ResultType& cluster : clusters)
+				snapshot->_clusters.push_back({std::get<0>(cluster), stringPool.intern(std::get<1>(cluster)), std::get<2>(cluster), {}});
+		}
+
+		if (stopRequested)
+			return {};
+
+		{
+			using ResultType = std::tuple<IdType, IdType>;
+			auto links {session.query<ResultType>("SELECT track_id, artist_id FROM track_artist_link").resultList()};
+
+			trackArtistLinks.reserve(links.size());
+			for (const ResultType& link : links)
+				trackArtistLinks.emplace_back(std::get<0>(link), std::get<1>(link));
+		}
+
+		{
+			using ResultType = std::tuple<IdType, IdType>;
+			auto links {session.query<ResultType>("SELECT track_id, cluster_id FROM track_cluster").resultList()};
+
+			trackClusterLinks.reserve(links.size());
+			for (const ResultType& link : links)
+				trackClusterLinks.emplace_back(std::get<0>(link), std::get<1>(link));
+		}
+	}
+
+	if (stopRequested)
+		return {};
+
+	sortById(snapshot->_tracks);
+	sortById(snapshot->_releases);
+	sortById(snapshot->_artists);
+	sortById(snapshot->_clusters);
+
+	std::vector<Link> releaseTrackLinks;
+	for (const Track& track : snapshot->_tracks)
+	{
+		if (Database::IdIsValid(track.releaseId))
+			releaseTrackLinks.emplace_back(track.releaseId, track.id);
+	}
+
+	std::vector<Link> artistTrackLinks;
+	std::vector<Link> artistReleaseLinks;
+	for (const Link& link : trackArtistLinks)
+	{
+		artistTrackLinks.emplace_back(link.second, link.first);
+
+		const Track* track {snapshot->getTrack(link.first)};
+		if (track && Database::IdIsValid(track->releaseId))
+			artistReleaseLinks.emplace_back(link.second, track->releaseId);
+	}
+
+	std::vector<Link> clusterTrackLinks;
+	clusterTrackLinks.reserve(trackClusterLinks.size());
+	for (const Link& link : trackClusterLinks)
+		clusterTrackLinks.emplace_back(link.second, link.first);
+
+	fillLinks(std::move(trackArtistLinks), snapshot->_tracks, &Track::artists, snapshot->_trackArtistIds);
+	fillLinks(std::move(trackClusterLinks), snapshot->_tracks, &Track::clusters, snapshot->_trackClusterIds);
+	fillLinks(std::move(releaseTrackLinks), snapshot->_releases, &Release::tracks, snapshot->_releaseTrackIds);
+	fillLinks(std::move(artistTrackLinks), snapshot->_artists, &Artist::tracks, snapshot->_artistTrackIds);
+	fillLinks(std::move(artistReleaseLinks), snapshot->_artists, &Artist::releases, snapshot->_artistReleaseIds);
+	fillLinks(std::move(clusterTrackLinks), snapshot->_clusters, &Cluster::tracks, snapshot->_clusterTrackIds);
+
+	// Same order as Artist::getAll, artists sharing the same sort name are ordered by id
+	std::sort(std::begin(artistSortNames), std::end(artistSortNames));
+
+	std::vector<std::size_t> artistIndexes(snapshot->_artists.size());
+	std::iota(std::begin(artistIndexes), std::end(artistIndexes), 0);
+	std::stable_sort(std::begin(artistIndexes), std::end(artistIndexes),
+			[&](std::size_t a, std::size_t b) { return lessNoCase(artistSortNames[a].second, artistSortNames[b].second); });
+
+	snapshot->_artistsByName.reserve(artistIndexes.size());
+	for (std::size_t artistIndex : artistIndexes)
+		snapshot->_artistsByName.push_back(&snapshot->_artists[artistIndex]);
+
+	snapshot->_strings.shrink_to_fit();
+
+	return snapshot;
+}
+
+const Snapshot::Track*
+Snapshot::getTrack(Database::IdType id) const
+{
+	return findById(_tracks, id);
+}
+
+const Snapshot::Release*
+Snapshot::getRelease(Database::IdType id) const
+{
+	return findById(_releases, id);
+}
+
+const Snapshot::Artist*
+Snapshot::getArtist(Database::IdType id) const
+{
+	return findById(_artists, id);
+}
+
+const Snapshot::Cluster*
+Snapshot::getCluster(Database::IdType id) const
+{
+	return findById(_clusters, id);
+}
+
+} // namespace Catalog
+
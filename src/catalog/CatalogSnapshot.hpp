@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Wt/Dbo/Session.h>
+
+#include "database/Types.hpp"
+
+namespace Catalog {
+
+// Read only view of the whole catalog: tracks, releases, artists, clusters and their links
+// Once built, a snapshot is never modified and can be shared between threads without locking
+class Snapshot
+{
+	public:
+
+		using StringId = std::uint32_t;
+
+		// Contiguous slice of one of the link arrays
+		class IdRange
+		{
+			public:
+				IdRange(const Database::IdType* begin, const Database::IdType* end) : _begin {begin}, _end {end} {}
+
+				const Database::IdType* begin() const { return _begin; }
+				const Database::IdType* end() const { return _end; }
+				std::size_t size() const { return _end - _begin; }
+				bool empty() const { return _begin == _end; }
+
+			private:
+				const Database::IdType* _begin;
+				const Database::IdType* _end;
+		};
+
+		struct Range
+		{
+			std::uint32_t begin {};
+			std::uint32_t end {};
+		};
+
+		struct Track
+		{
+			Database::IdType	id;
+			StringId		name;
+			Database::IdType	releaseId;	// invalid id if no release
+			Range			artists;
+			Range			clusters;
+		};
+
+		struct Release
+		{
+			Database::IdType	id;
+			StringId		name;
+			Range			tracks;
+		};
+
+		struct Artist
+		{
+			Database::IdType	id;
+			StringId		name;
+			Range			tracks;
+			Range			releases;
+		};
+
+		struct Cluster
+		{
+			Database::IdType	id;
+			StringId		name;
+			Database::IdType	clusterTypeId;
+			Range			tracks;
+		};
+
+		// Returns an empty pointer if stopRequested has been set during the build
+		static std::shared_ptr<Snapshot> build(Wt::Dbo::Session& session, const bool& stopRequested);
+
+		// Lookups, nullptr if not found
+		const Track*	getTrack(Database::IdType id) const;
+		const Release*	getRelease(Database::IdType id) const;
+		const Artist*	getArtist(Database::IdType id) const;
+		const Cluster*	getCluster(Database::IdType id) const;
+
+		// Sorted by id
+		const std::vector<Track>&	getTracks() const { return _tracks; }
+		const std::vector<Release>&	getReleases() const { return _releases; }
+		const std::vector<Cluster>&	getClusters() const { return _clusters; }
+		// Sorted by sort name, case insensitive, in the same order as Artist::getAll
+		const std::vector<const Artist*>& getArtistsByName() const { return _artistsByName; }
+
+		// Links, sorted by id
+		IdRange getArtistIds(const Track& track) const { return getIdRange(_trackArtistIds, track.artists); }
+		IdRange getClusterIds(const Track& track) const { return getIdRange(_trackClusterIds, track.clusters); }
+		IdRange getTrackIds(const Release& release) const { return getIdRange(_releaseTrackIds, release.tracks); }
+		IdRange getTrackIds(const Artist& artist) const { return getIdRange(_artistTrackIds, artist.tracks); }
+		IdRange getReleaseIds(const Artist& artist) const { return getIdRange(_artistReleaseIds, artist.releases); }
+		IdRange getTrackIds(const Cluster& cluster) const { return getIdRange(_clusterTrackIds, cluster.tracks); }
+
+		const std::string& getString(StringId id) const { return _strings[id]; }
+
+	private:
+
+		static IdRange getIdRange(const std::vector<Database::IdType>& ids, Range range)
+		{
+			return IdRange {ids.data() + range.begin, ids.data() + range.end};
+		}
+
+		std::vector<std::string>	_strings;
+
+		std::vector<Track>		_tracks;
+		std::vector<Release>		_releases;
+		std::vector<Artist>		_artists;
+		std::vector<Cluster>		_clusters;
+		std::vector<const Artist*>	_artistsByName;
+
+		std::vector<Database::IdType>	_trackArtistIds;
+		std::vector<Database::IdType>	_trackClusterIds;
+		std::vector<Database::IdType>	_releaseTrackIds;
+		std::vector<Database::IdType>	_artistTrackIds;
+		std::vector<Database::IdType>	_artistReleaseIds;
+		std::vector<Database::IdType>	_clusterTrackIds;
+};
+
+} // namespace Catalog
+
@@ -18,9 +18,13 @@
  */
 #include "Artist.hpp"
 
+#include <algorithm>
+#include <random>
+
 #include <Wt/Dbo/WtSqlTraits.h>
 
 #include "utils/Logger.hpp"
+#include "utils/RandomPermutation.hpp"
 
 #include "Cluster.hpp"
 #include "Release.hpp"
@@ -88,38 +92,35 @@ getQuery(Wt::Dbo::Session& session,
 		const std::set<IdType>& clusterIds,
 		const std::vector<std::string>& keywords)
 {
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-	std::ostringstream oss;
-	oss << "SELECT DISTINCT a FROM artist a";
+	WhereClause where;
 
 	for (auto keyword : keywords)
 		where.And(WhereClause("a.name LIKE ?")).bind("%%" + keyword + "%%");
 
 	if (!clusterIds.empty())
-	{
-		oss << " INNER JOIN track t ON t.id = t_a_l.track_id INNER JOIN track_artist_link t_a_l ON t_a_l.artist_id = a.id INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
+		where.And(WhereClause::in("c.id", clusterIds));
 
-		WhereClause clusterClause;
+	const std::string sql {queryCache.get({keywords.size(), clusterIds.size()}, [&]
+	{
+		std::string res {"SELECT DISTINCT a FROM artist a"};
 
-		for (auto id : clusterIds)
-			clusterClause.Or(WhereClause("c.id = ?")).bind(std::to_string(id));
+		if (!clusterIds.empty())
+			res += " INNER JOIN track t ON t.id = t_a_l.track_id INNER JOIN track_artist_link t_a_l ON t_a_l.artist_id = a.id INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
 
-		where.And(clusterClause);
-	}
-	oss << " " << where.get();
+		res += " " + where.get();
 
-	if (!clusterIds.empty())
-		oss << " GROUP BY t.id HAVING COUNT(DISTINCT c.id) = " << clusterIds.size();
+		if (!clusterIds.empty())
+			res += " GROUP BY t.id HAVING COUNT(DISTINCT c.id) = " + std::to_string(clusterIds.size());
 
-	oss << " ORDER BY a.sort_name COLLATE NOCASE";
+		res += " ORDER BY a.sort_name COLLATE NOCASE";
 
-	Wt::Dbo::Query<Artist::pointer> query = session.query<Artist::pointer>( oss.str() );
+		return res;
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-	{
-		query.bind(bindArg);
-	}
+	Wt::Dbo::Query<Artist::pointer> query {session.query<Artist::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	return query;
 }
@@ -175,37 +176,34 @@ Artist::getReleases(const std::set<IdType>& clusterIds) const
 	assert(IdIsValid(self()->id()));
 	assert(session());
 
-	WhereClause where;
-
-	std::ostringstream oss;
+	static SqlQueryCache queryCache;
 
-	oss << "SELECT DISTINCT r FROM release r INNER JOIN artist a ON a.id = t_a_l.artist_id INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id INNER JOIN track t ON t.release_id = r.id";
+	WhereClause where;
 
 	if (!clusterIds.empty())
-	{
-		oss << " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
-
-		WhereClause clusterClause;
+		where.And(WhereClause::in("c.id", clusterIds));
 
-		for (auto id : clusterIds)
-			clusterClause.Or(WhereClause("c.id = ?")).bind(std::to_string(id));
+	where.And(WhereClause("a.id = ?")).bind(id());
 
-		where.And(clusterClause);
-	}
+	const std::string sql {queryCache.get({clusterIds.size()}, [&]
+	{
+		std::string res {"SELECT DISTINCT r FROM release r INNER JOIN artist a ON a.id = t_a_l.artist_id INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id INNER JOIN track t ON t.release_id = r.id"};
 
-	where.And(WhereClause("a.id = ?")).bind(std::to_string(id()));
+		if (!clusterIds.empty())
+			res += " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
 
-	oss << " " << where.get();
+		res += " " + where.get();
 
-	if (!clusterIds.empty())
-		oss << " GROUP BY t.id HAVING COUNT(DISTINCT c.id) = " << clusterIds.size();
+		if (!clusterIds.empty())
+			res += " GROUP BY t.id HAVING COUNT(DISTINCT c.id) = " + std::to_string(clusterIds.size());
 
-	oss << " ORDER BY t.year,r.name";
+		res += " ORDER BY t.year,r.name";
 
-	Wt::Dbo::Query<Release::pointer> query = session()->query<Release::pointer>( oss.str() );
+		return res;
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Release::pointer> query {session()->query<Release::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	Wt::Dbo::collection<Wt::Dbo::ptr<Release>> res = query;
 
@@ -253,12 +251,24 @@ Artist::getRandomTracks(boost::optional<std::size_t> count) const
 	assert(IdIsValid(self()->id()));
 	assert(session());
 
-	Wt::Dbo::collection<Wt::Dbo::ptr<Track>> tracks {session()->query<Wt::Dbo::ptr<Track>>("SELECT t from track t INNER JOIN artist a ON a.id = t_a_l.artist_id INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id")
-		.where("a.id = ?").bind(self()->id())
-		.orderBy("RANDOM()")
-		.limit(count ? static_cast<int>(*count) : -1)};
+	// Only fetch the selected tracks instead of sorting all of them randomly
+	Wt::Dbo::collection<IdType> ids {session()->query<IdType>("SELECT DISTINCT t_a_l.track_id from track_artist_link t_a_l")
+		.where("t_a_l.artist_id = ?").bind(self()->id())};
+	const std::vector<IdType> trackIds(ids.begin(), ids.end());
 
-	return std::vector<Wt::Dbo::ptr<Track>>(tracks.begin(), tracks.end());
+	const std::size_t size {count ? std::min(*count, trackIds.size()) : trackIds.size()};
+	const RandomPermutation permutation {trackIds.size(), std::random_device {}()};
+
+	std::vector<Wt::Dbo::ptr<Track>> tracks;
+	tracks.reserve(size);
+	for (std::size_t i {}; i < size; ++i)
+	{
+		Wt::Dbo::ptr<Track> track {Track::getById(*session(), trackIds[permutation[i]])};
+		if (track)
+			tracks.emplace_back(std::move(track));
+	}
+
+	return tracks;
 }
 
 std::vector<std::vector<Wt::Dbo::ptr<Cluster>>>
@@ -268,26 +278,27 @@ Artist::getClusterGroups(std::vector<ClusterType::pointer> clusterTypes, std::si
 	assert(IdIsValid(self()->id()));
 	assert(session());
 
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-	std::ostringstream oss;
-	oss << "SELECT c FROM cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id INNER JOIN artist a ON t_a_l.artist_id = a.id INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id";
+	std::set<IdType> clusterTypeIds;
+	for (auto clusterType : clusterTypes)
+		clusterTypeIds.insert(clusterType.id());
 
-	where.And(WhereClause("a.id = ?")).bind(std::to_string(self()->id()));
-	{
-		WhereClause clusterClause;
-		for (auto clusterType : clusterTypes)
-			clusterClause.Or(WhereClause("c_type.id = ?")).bind(std::to_string(clusterType.id()));
+	WhereClause where;
 
-		where.And(clusterClause);
-	}
-	oss << " " << where.get();
-	oss << "GROUP BY c.id ORDER BY COUNT(DISTINCT c.id) DESC";
+	where.And(WhereClause("a.id = ?")).bind(self()->id());
+	if (!clusterTypeIds.empty())
+		where.And(WhereClause::in("c_type.id", clusterTypeIds));
 
-	Wt::Dbo::Query<Cluster::pointer> query = session()->query<Cluster::pointer>( oss.str() );
+	const std::string sql {queryCache.get({clusterTypeIds.size()}, [&]
+	{
+		return "SELECT c FROM cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id INNER JOIN artist a ON t_a_l.artist_id = a.id INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = t.id"
+			" " + where.get() +
+			" GROUP BY c.id ORDER BY COUNT(DISTINCT c.id) DESC";
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Cluster::pointer> query {session()->query<Cluster::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	Wt::Dbo::collection<Cluster::pointer> queryRes = query;
 
@@ -19,6 +19,8 @@
 
 #include "Cluster.hpp"
 
+#include <tuple>
+
 #include "Artist.hpp"
 #include "Release.hpp"
 #include "ScanSettings.hpp"
@@ -162,6 +164,29 @@ ClusterType::getClusters() const
 	return std::vector<Cluster::pointer>(res.begin(), res.end());
 }
 
+std::vector<ClusterType::ClusterStats>
+ClusterType::getClustersStats() const
+{
+	assert(self());
+	assert(IdIsValid(self()->id()));
+	assert(session());
+
+	using ResultType = std::tuple<IdType, std::string, long long, long long>;
+	Wt::Dbo::collection<ResultType> res = session()->query<ResultType>(
+			"SELECT c.id, c.name, COUNT(t_c.track_id), COUNT(DISTINCT t.release_id) FROM cluster c"
+			" LEFT OUTER JOIN track_cluster t_c ON t_c.cluster_id = c.id"
+			" LEFT OUTER JOIN track t ON t.id = t_c.track_id")
+		.where("c.cluster_type_id = ?").bind(self()->id())
+		// Same order as the index: no sort needed
+		.groupBy("c.name, c.id")
+		.orderBy("c.name, c.id");
+
+	std::vector<ClusterStats> stats;
+	for (const ResultType& clusterStats : res)
+		stats.push_back({std::get<0>(clusterStats), std::get<1>(clusterStats), static_cast<std::size_t>(std::get<2>(clusterStats)), static_cast<std::size_t>(std::get<3>(clusterStats))});
+
+	return stats;
+}
 
 } // namespace Database
 
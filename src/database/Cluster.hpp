@@ -101,6 +101,17 @@ class ClusterType : public Wt::Dbo::Dbo<ClusterType>
 		std::vector<Cluster::pointer> getClusters() const;
 		Cluster::pointer getCluster(std::string name) const;
 
+		struct ClusterStats
+		{
+			IdType		id;
+			std::string	name;
+			std::size_t	trackCount;
+			std::size_t	releaseCount;
+		};
+
+		// Track and release counts of all the clusters, ordered by name, in a single query
+		std::vector<ClusterStats> getClustersStats() const;
+
 		template<class Action>
 		void persist(Action& a)
 		{
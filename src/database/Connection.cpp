@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Connection.hpp"
+
+#include <vector>
+
+#include "utils/Logger.hpp"
+
+namespace Database {
+
+static
+std::vector<std::string>
+getPragmas(StorageProfile profile)
+{
+	// WAL mode allows synchronous = NORMAL without risking corruption, only the last commits may be lost on power failure
+	std::vector<std::string> pragmas {"journal_mode = WAL", "synchronous = NORMAL", "busy_timeout = 5000"};
+
+	switch (profile)
+	{
+		case StorageProfile::LowMemory:
+			pragmas.emplace_back("cache_size = -2000");	// 2 MiB
+			pragmas.emplace_back("mmap_size = 0");
+			pragmas.emplace_back("temp_store = FILE");
+			break;
+
+		case StorageProfile::Balanced:
+			pragmas.emplace_back("cache_size = -32768");	// 32 MiB
+			pragmas.emplace_back("mmap_size = 268435456");	// 256 MiB
+			pragmas.emplace_back("temp_store = MEMORY");
+			break;
+
+		case StorageProfile::Throughput:
+			pragmas.emplace_back("cache_size = -524288");	// 512 MiB
+			pragmas.emplace_back("mmap_size = 2147418112");	// SQLite default upper limit, about 2 GiB
+			pragmas.emplace_back("temp_store = MEMORY");
+			break;
+	}
+
+	return pragmas;
+}
+
+boost::optional<StorageProfile>
+getStorageProfile(const std::string& name)
+{
+	if (name == "low-memory")
+		return StorageProfile::LowMemory;
+	if (name == "balanced")
+		return StorageProfile::Balanced;
+	if (name == "throughput")
+		return StorageProfile::Throughput;
+
+	return boost::none;
+}
+
+Connection::Connection(const std::string& db, StorageProfile profile, bool readOnly)
+: Wt::Dbo::backend::Sqlite3 {db},
+_profile {profile},
+_readOnly {readOnly}
+{
+	applyStorageProfile();
+}
+
+Connection::Connection(const Connection& other)
+: Wt::Dbo::backend::Sqlite3 {other},
+_profile {other._profile},
+_readOnly {other._readOnly}
+{
+	applyStorageProfile();
+}
+
+std::unique_ptr<Wt::Dbo::SqlConnection>
+Connection::clone() const
+{
+	return std::make_unique<Connection>(*this);
+}
+
+void
+Connection::applyStorageProfile()
+{
+	for (const std::string& pragma : getPragmas(_profile))
+	{
+		LMS_LOG(DB, DEBUG) << "Applying 'PRAGMA " << pragma << "'";
+		executeSql("PRAGMA " + pragma);
+	}
+
+	if (_readOnly)
+		executeSql("PRAGMA query_only = ON");
+}
+
+} // namespace Database
+
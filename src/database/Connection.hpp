@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <boost/optional.hpp>
+#include <Wt/Dbo/backend/Sqlite3.h>
+
+namespace Database {
+
+// Sets of pragmas tuned for the available memory
+enum class StorageProfile
+{
+	LowMemory,	// SQLite defaults: small page cache, no memory mapping
+	Balanced,
+	Throughput,	// Large page cache, whole database memory mapped
+};
+
+// "low-memory", "balanced" or "throughput"
+boost::optional<StorageProfile> getStorageProfile(const std::string& name);
+
+// Sqlite3 connection set up using a storage profile
+// The connections cloned by the pool are set up the same way
+class Connection : public Wt::Dbo::backend::Sqlite3
+{
+	public:
+		// If readOnly is set, any statement modifying the database fails
+		Connection(const std::string& db, StorageProfile profile, bool readOnly = false);
+		Connection(const Connection& other);
+
+		std::unique_ptr<Wt::Dbo::SqlConnection> clone() const override;
+
+	private:
+		void applyStorageProfile();
+
+		const StorageProfile _profile;
+		const bool _readOnly;
+};
+
+} // namespace Database
+
@@ -19,8 +19,9 @@
 
 #include "DatabaseHandler.hpp"
 
+#include <algorithm>
+
 #include <Wt/Dbo/FixedSqlConnectionPool.h>
-#include <Wt/Dbo/backend/Sqlite3.h>
 
 #include <Wt/Auth/Dbo/AuthInfo.h>
 #include <Wt/Auth/Dbo/UserDatabase.h>
@@ -36,6 +37,10 @@
 
 #include "Artist.hpp"
 #include "Cluster.hpp"
+#include "InstrumentedConnection.hpp"
+#include "Maintenance.hpp"
+#include "Migration.hpp"
+#include "PlayStats.hpp"
 #include "Release.hpp"
 #include "ScanSettings.hpp"
 #include "SimilaritySettings.hpp"
@@ -46,42 +51,35 @@
 
 namespace Database {
 
-#define LMS_DATABASE_VERSION	3
-
 namespace {
 	Wt::Auth::AuthService authService;
 	Wt::Auth::PasswordService passwordService {authService};
 }
 
-using Version = std::size_t;
-
-class VersionInfo
+static
+void
+mapClasses(Wt::Dbo::Session& session)
 {
-	public:
-		using pointer = Wt::Dbo::ptr<VersionInfo>;
-
-		static VersionInfo::pointer get(Wt::Dbo::Session& session)
-		{
-			pointer versionInfo {session.find<VersionInfo>()};
-			if (!versionInfo)
-				versionInfo = session.add(std::make_unique<VersionInfo>());
-
-			return versionInfo;
-		}
-
-		Version getVersion() const { return _version; }
-		void setVersion(Version version) { _version = static_cast<int>(version); }
-
-		template<class Action>
-		void persist(Action& a)
-		{
-			Wt::Dbo::field(a, _version, "db_version");
-		}
-
-	private:
-		int _version {LMS_DATABASE_VERSION};
-};
-
+	session.mapClass<VersionInfo>("version_info");
+	session.mapClass<Artist>("artist");
+	session.mapClass<Cluster>("cluster");
+	session.mapClass<ClusterType>("cluster_type");
+	session.mapClass<TrackList>("tracklist");
+	session.mapClass<TrackListEntry>("tracklist_entry");
+	session.mapClass<Release>("release");
+	session.mapClass<Track>("track");
+	session.mapClass<TrackArtistLink>("track_artist_link");
+	session.mapClass<TrackFeatures>("track_features");
+
+	session.mapClass<ScanSettings>("scan_settings");
+	session.mapClass<SimilaritySettings>("similarity_settings");
+	session.mapClass<SimilaritySettingsFeature>("similarity_settings_feature");
+
+	session.mapClass<AuthInfo>("auth_info");
+	session.mapClass<AuthInfo::AuthIdentityType>("auth_identity");
+	session.mapClass<AuthInfo::AuthTokenType>("auth_token");
+	session.mapClass<User>("user");
+}
 
 void
 Handler::configureAuth(void)
@@ -127,69 +125,64 @@ Handler::getPasswordService()
 }
 
 
-Handler::Handler(Wt::Dbo::SqlConnectionPool& connectionPool)
+void
+Handler::prepareTables(Wt::Dbo::SqlConnectionPool& connectionPool)
 {
-	_session.setConnectionPool(connectionPool);
+	Wt::Dbo::Session session;
+	session.setConnectionPool(connectionPool);
 
-	_session.mapClass<VersionInfo>("version_info");
-	_session.mapClass<Artist>("artist");
-	_session.mapClass<Cluster>("cluster");
-	_session.mapClass<ClusterType>("cluster_type");
-	_session.mapClass<TrackList>("tracklist");
-	_session.mapClass<TrackListEntry>("tracklist_entry");
-	_session.mapClass<Release>("release");
-	_session.mapClass<Track>("track");
-	_session.mapClass<TrackArtistLink>("track_artist_link");
-	_session.mapClass<TrackFeatures>("track_features");
-
-	_session.mapClass<ScanSettings>("scan_settings");
-	_session.mapClass<SimilaritySettings>("similarity_settings");
-	_session.mapClass<SimilaritySettingsFeature>("similarity_settings_feature");
-
-	_session.mapClass<AuthInfo>("auth_info");
-	_session.mapClass<AuthInfo::AuthIdentityType>("auth_identity");
-	_session.mapClass<AuthInfo::AuthTokenType>("auth_token");
-	_session.mapClass<User>("user");
+	mapClasses(session);
 
 	try {
-		Wt::Dbo::Transaction transaction {_session};
+		Wt::Dbo::Transaction transaction {session};
 
-	        _session.createTables();
+	        session.createTables();
 
 		LMS_LOG(DB, INFO) << "Tables created";
 	}
 	catch (Wt::Dbo::Exception& e)
 	{
-		LMS_LOG(DB, ERROR) << "Cannot create tables: " << e.what();
+		LMS_LOG(DB, INFO) << "Cannot create tables: " << e.what();
 	}
 
-	try
-	{
-		Wt::Dbo::Transaction transaction {_session};
+	doDbMigration(session);
 
-		Version version {VersionInfo::get(_session)->getVersion()};
-		if (version != LMS_DATABASE_VERSION)
-			throw LmsException {"Outdated database, please rebuild it (database migration not yet implemented)"};
-	}
-	catch (std::exception& e)
 	{
-		throw LmsException {"Cannot get database version, please rebuild it (database migration not yet implemented)"};
-	}
-
-	{
-		Wt::Dbo::Transaction transaction {_session};
+		Wt::Dbo::Transaction transaction {session};
 
 		// Indexes
-		_session.execute("CREATE INDEX IF NOT EXISTS track_path_idx ON track(file_path)");
-		_session.execute("CREATE INDEX IF NOT EXISTS track_name_idx ON track(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS artist_name_idx ON artist(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS release_name_idx ON release(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS track_release_idx ON track(release_id)");
-		_session.execute("CREATE INDEX IF NOT EXISTS cluster_name_idx ON cluster(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS cluster_type_name_idx ON cluster_type(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS tracklist_name_idx ON tracklist(name)");
-		_session.execute("CREATE INDEX IF NOT EXISTS track_features_track_idx ON track_features(track_id)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_path_idx ON track(file_path)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_name_idx ON track(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS artist_name_idx ON artist(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS release_name_idx ON release(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_release_idx ON track(release_id)");
+		session.execute("CREATE INDEX IF NOT EXISTS cluster_name_idx ON cluster(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS cluster_type_name_idx ON cluster_type(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS tracklist_name_idx ON tracklist(name)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_features_track_idx ON track_features(track_id)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_mbid_idx ON track(mbid)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_file_added_idx ON track(file_added)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_checksum_idx ON track(checksum)");
+		session.execute("CREATE INDEX IF NOT EXISTS release_mbid_idx ON release(mbid)");
+		session.execute("CREATE INDEX IF NOT EXISTS artist_mbid_idx ON artist(mbid)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_artist_link_artist_track_type_idx ON track_artist_link(artist_id, track_id, type)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_artist_link_track_type_idx ON track_artist_link(track_id, type)");
+		session.execute("CREATE INDEX IF NOT EXISTS track_cluster_cluster_track_idx ON track_cluster(cluster_id, track_id)");
+		session.execute("CREATE INDEX IF NOT EXISTS cluster_cluster_type_name_idx ON cluster(cluster_type_id, name)");
+		session.execute("CREATE INDEX IF NOT EXISTS tracklist_user_type_idx ON tracklist(user_id, type)");
+		session.execute("CREATE INDEX IF NOT EXISTS tracklist_entry_tracklist_position_idx ON tracklist_entry(tracklist_id, position)");
+		session.execute("CREATE INDEX IF NOT EXISTS tracklist_entry_track_idx ON tracklist_entry(track_id)");
+
+		// Aggregates, not mapped
+		PlayStats::createTables(session);
 	}
+}
+
+Handler::Handler(Wt::Dbo::SqlConnectionPool& connectionPool)
+{
+	_session.setConnectionPool(connectionPool);
+
+	mapClasses(_session);
 
 	_users = new UserDatabase(_session);
 }
@@ -254,15 +247,20 @@ Handler::createUser(const Wt::Auth::User& authUser)
 }
 
 std::unique_ptr<Wt::Dbo::SqlConnectionPool>
-Handler::createConnectionPool(boost::filesystem::path p)
+Handler::createConnectionPool(boost::filesystem::path p, QueryStats* queryStats, StorageProfile profile, bool readOnly, std::size_t poolSize)
 {
-	LMS_LOG(DB, INFO) << "Creating connection pool on file " << p.string();
+	LMS_LOG(DB, INFO) << "Creating " << (readOnly ? "read only " : "") << "connection pool on file " << p.string() << ", size = " << poolSize;
+
+	std::unique_ptr<Connection> connection;
+	if (queryStats)
+		connection = std::make_unique<InstrumentedConnection>(p.string(), profile, readOnly, *queryStats);
+	else
+		connection = std::make_unique<Connection>(p.string(), profile, readOnly);
 
-	auto connection = std::make_unique<Wt::Dbo::backend::Sqlite3>(p.string());
-	connection->executeSql("pragma journal_mode=WAL");
-//	connection->setProperty("show-queries", "true");
+	if (!readOnly)
+		Maintenance::enableIncrementalVacuum(*connection);
 
-	auto pool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), 1);
+	auto pool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), std::max(poolSize, std::size_t {1}));
 	pool->setTimeout(std::chrono::seconds(10));
 
 	return pool;
@@ -29,10 +29,13 @@
 #include <Wt/Auth/Login.h>
 #include <Wt/Auth/PasswordService.h>
 
+#include "Connection.hpp"
 #include "User.hpp"
 
 namespace Database {
 
+class QueryStats;
+
 using UserDatabase = Wt::Auth::Dbo::UserDatabase<AuthInfo>;
 
 // Session living class handling the database and the login
@@ -59,7 +62,14 @@ class Handler
 		static const Wt::Auth::AuthService& getAuthService();
 		static const Wt::Auth::PasswordService& getPasswordService();
 
-		static std::unique_ptr<Wt::Dbo::SqlConnectionPool> createConnectionPool(boost::filesystem::path db);
+		// If set, stats are collected for each executed statement
+		// Read only pools cannot be used to prepare the tables
+		// poolSize is the number of connections that can be used concurrently
+		static std::unique_ptr<Wt::Dbo::SqlConnectionPool> createConnectionPool(boost::filesystem::path db, QueryStats* queryStats = nullptr, StorageProfile profile = StorageProfile::Balanced, bool readOnly = false, std::size_t poolSize = 1);
+
+		// Create or migrate the tables and indexes, to be called once before any Handler is created
+		// Throws LmsException if the database cannot be used
+		static void prepareTables(Wt::Dbo::SqlConnectionPool& connectionPool);
 
 	private:
 
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "InstrumentedConnection.hpp"
+
+#include <vector>
+
+#include <Wt/Dbo/SqlStatement.h>
+
+namespace Database {
+
+namespace {
+
+// Forwards everything to the backend statement
+// The time spent in execute() and nextRow() is accumulated and reported once
+// all the rows have been fetched, or when the statement is reused
+// Wt::Dbo keeps the prepared statements of each connection keyed by their SQL text,
+// so every execution after the first one is a hit in this cache
+class InstrumentedStatement : public Wt::Dbo::SqlStatement
+{
+	public:
+		InstrumentedStatement(std::unique_ptr<Wt::Dbo::SqlStatement> statement, QueryStats& stats)
+		: _statement {std::move(statement)},
+		_stats {stats},
+		_query {QueryStats::normalize(_statement->sql())}
+		{}
+
+		~InstrumentedStatement()
+		{
+			report();
+		}
+
+		void reset() override
+		{
+			report();
+			_params.clear();
+			_statement->reset();
+		}
+
+		void bind(int column, const std::string& value) override		{ setParam(column, "<string>"); _statement->bind(column, value); }
+		void bind(int column, short value) override				{ setParam(column, value); _statement->bind(column, value); }
+		void bind(int column, int value) override				{ setParam(column, value); _statement->bind(column, value); }
+		void bind(int column, long long value) override				{ setParam(column, value); _statement->bind(column, value); }
+		void bind(int column, float value) override				{ setParam(column, value); _statement->bind(column, value); }
+		void bind(int column, double value) override				{ setParam(column, value); _statement->bind(column, value); }
+		void bind(int column, const std::chrono::system_clock::time_point& value, Wt::Dbo::SqlDateTimeType type) override { setParam(column, "<datetime>"); _statement->bind(column, value, type); }
+		void bind(int column, const std::chrono::duration<int, std::milli>& value) override { setParam(column, value.count()); _statement->bind(column, value); }
+		void bind(int column, const std::vector<unsigned char>& value) override	{ setParam(column, "<blob>"); _statement->bind(column, value); }
+		void bindNull(int column) override					{ setParam(column, "NULL"); _statement->bindNull(column); }
+
+		void execute() override
+		{
+			report();
+
+			if (_executed)
+				_stats.recordStatementReused();
+			_executed = true;
+
+			_pending = true;
+			const auto start {std::chrono::steady_clock::now()};
+			_statement->execute();
+			_duration += std::chrono::steady_clock::now() - start;
+
+			// Nothing to fetch
+			if (_statement->columnCount() == 0)
+				report();
+		}
+
+		long long insertedId() override { return _statement->insertedId(); }
+		int affectedRowCount() override { return _statement->affectedRowCount(); }
+
+		bool nextRow() override
+		{
+			const auto start {std::chrono::steady_clock::now()};
+			const bool res {_statement->nextRow()};
+			_duration += std::chrono::steady_clock::now() - start;
+
+			if (res)
+				_rows++;
+			else
+				report();
+
+			return res;
+		}
+
+		int columnCount() const override { return _statement->columnCount(); }
+
+		bool getResult(int column, std::string* value, int size) override			{ return _statement->getResult(column, value, size); }
+		bool getResult(int column, short* value) override					{ return _statement->getResult(column, value); }
+		bool getResult(int column, int* value) override						{ return _statement->getResult(column, value); }
+		bool getResult(int column, long long* value) override					{ return _statement->getResult(column, value); }
+		bool getResult(int column, float* value) override					{ return _statement->getResult(column, value); }
+		bool getResult(int column, double* value) override					{ return _statement->getResult(column, value); }
+		bool getResult(int column, std::chrono::system_clock::time_point* value, Wt::Dbo::SqlDateTimeType type) override { return _statement->getResult(column, value, type); }
+		bool getResult(int column, std::chrono::duration<int, std::milli>* value) override	{ return _statement->getResult(column, value); }
+		bool getResult(int column, std::vector<unsigned char>* value, int size) override	{ return _statement->getResult(column, value, size); }
+
+		std::string sql() const override { return _statement->sql(); }
+
+	private:
+
+		// Only numbers are kept, other values are redacted
+		template <typename T>
+		void setParam(int column, T value)
+		{
+			setParam(column, std::to_string(value));
+		}
+
+		void setParam(int column, const char* value)
+		{
+			setParam(column, std::string {value});
+		}
+
+		void setParam(int column, std::string value)
+		{
+			if (!_stats.isSlowQueryLogEnabled() || column < 0)
+				return;
+
+			if (static_cast<std::size_t>(column) >= _params.size())
+				_params.resize(column + 1, "?");
+
+			_params[column] = std::move(value);
+		}
+
+		void report()
+		{
+			if (!_pending)
+				return;
+
+			_stats.record(_query, std::chrono::duration_cast<std::chrono::microseconds>(_duration), _rows, _params);
+
+			_pending = false;
+			_duration = {};
+			_rows = 0;
+		}
+
+		std::unique_ptr<Wt::Dbo::SqlStatement>	_statement;
+		QueryStats&				_stats;
+		const std::string			_query;
+
+		bool					_executed {};
+		bool					_pending {};
+		std::chrono::steady_clock::duration	_duration {};
+		std::size_t				_rows {};
+		std::vector<std::string>		_params;
+};
+
+} // namespace
+
+InstrumentedConnection::InstrumentedConnection(const std::string& db, StorageProfile profile, bool readOnly, QueryStats& stats)
+: Connection {db, profile, readOnly},
+_stats {stats}
+{
+}
+
+InstrumentedConnection::InstrumentedConnection(const InstrumentedConnection& other)
+: Connection {other},
+_stats {other._stats}
+{
+}
+
+std::unique_ptr<Wt::Dbo::SqlConnection>
+InstrumentedConnection::clone() const
+{
+	return std::make_unique<InstrumentedConnection>(*this);
+}
+
+std::unique_ptr<Wt::Dbo::SqlStatement>
+InstrumentedConnection::prepareStatement(const std::string& sql)
+{
+	_stats.recordStatementPrepared();
+	return std::make_unique<InstrumentedStatement>(Connection::prepareStatement(sql), _stats);
+}
+
+} // namespace Database
+
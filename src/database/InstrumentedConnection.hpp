@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Connection.hpp"
+#include "QueryStats.hpp"
+
+namespace Database {
+
+// Connection that reports the execution time and the returned rows of each statement
+class InstrumentedConnection : public Connection
+{
+	public:
+		InstrumentedConnection(const std::string& db, StorageProfile profile, bool readOnly, QueryStats& stats);
+		InstrumentedConnection(const InstrumentedConnection& other);
+
+		std::unique_ptr<Wt::Dbo::SqlConnection> clone() const override;
+		std::unique_ptr<Wt::Dbo::SqlStatement> prepareStatement(const std::string& sql) override;
+
+	private:
+		QueryStats&	_stats;
+};
+
+} // namespace Database
+
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Maintenance.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <Wt/Dbo/SqlStatement.h>
+
+#include "utils/Logger.hpp"
+
+namespace Database {
+
+// Fetch all the rows: some pragmas only do part of their work at each step
+static
+std::vector<long long>
+executePragma(Wt::Dbo::SqlConnection& connection, const std::string& pragma)
+{
+	std::vector<long long> res;
+
+	std::unique_ptr<Wt::Dbo::SqlStatement> statement {connection.prepareStatement("PRAGMA " + pragma)};
+	statement->execute();
+
+	bool firstRow {true};
+	while (statement->nextRow())
+	{
+		if (!firstRow)
+			continue;
+
+		firstRow = false;
+		for (int column {}; column < statement->columnCount(); ++column)
+		{
+			long long value {};
+			statement->getResult(column, &value);
+			res.push_back(value);
+		}
+	}
+
+	return res;
+}
+
+static
+long long
+getPragmaValue(Wt::Dbo::SqlConnection& connection, const std::string& pragma)
+{
+	const std::vector<long long> values {executePragma(connection, pragma)};
+	return values.empty() ? 0 : values.front();
+}
+
+// Empty for in-memory databases
+static
+boost::filesystem::path
+getDatabaseFile(Wt::Dbo::SqlConnection& connection)
+{
+	// seq, name, file
+	std::unique_ptr<Wt::Dbo::SqlStatement> statement {connection.prepareStatement("PRAGMA database_list")};
+	statement->execute();
+
+	std::string file;
+	while (statement->nextRow())
+	{
+		std::string name;
+		statement->getResult(1, &name, 0);
+		if (name == "main")
+			statement->getResult(2, &file, 0);
+	}
+
+	return file;
+}
+
+static
+std::uintmax_t
+getFileSize(const boost::filesystem::path& file)
+{
+	boost::system::error_code ec;
+	const std::uintmax_t size {boost::filesystem::file_size(file, ec)};
+
+	return ec ? 0 : size;
+}
+
+void
+Maintenance::enableIncrementalVacuum(Wt::Dbo::SqlConnection& connection)
+{
+	constexpr long long incrementalVacuum {2};
+
+	if (getPragmaValue(connection, "auto_vacuum") == incrementalVacuum)
+		return;
+
+	// Only applies to existing databases once rebuilt
+	LMS_LOG(DB, INFO) << "Enabling incremental vacuum, this may take a while...";
+	connection.executeSql("PRAGMA auto_vacuum = INCREMENTAL");
+	connection.executeSql("VACUUM");
+	LMS_LOG(DB, INFO) << "Incremental vacuum enabled";
+}
+
+Maintenance::Result
+Maintenance::run(Wt::Dbo::SqlConnectionPool& connectionPool)
+{
+	Result res;
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	std::unique_ptr<Wt::Dbo::SqlConnection> connection {connectionPool.getConnection()};
+
+	try
+	{
+		const boost::filesystem::path dbFile {getDatabaseFile(*connection)};
+		const std::uintmax_t sizeBefore {getFileSize(dbFile) + getFileSize(dbFile.string() + "-wal")};
+
+		// Runs ANALYZE on the tables whose statistics are stale
+		executePragma(*connection, "optimize");
+		executePragma(*connection, "incremental_vacuum");
+
+		// busy, frames in the WAL, checkpointed frames
+		const std::vector<long long> checkpoint {executePragma(*connection, "wal_checkpoint(TRUNCATE)")};
+		if (!checkpoint.empty() && checkpoint.front() != 0)
+			LMS_LOG(DB, INFO) << "WAL checkpoint could not complete, database busy";
+
+		const std::uintmax_t sizeAfter {getFileSize(dbFile) + getFileSize(dbFile.string() + "-wal")};
+		if (sizeBefore > sizeAfter)
+			res.reclaimedBytes = sizeBefore - sizeAfter;
+	}
+	catch (Wt::Dbo::Exception& e)
+	{
+		LMS_LOG(DB, ERROR) << "Database maintenance failed: " << e.what();
+	}
+
+	connectionPool.returnConnection(std::move(connection));
+
+	res.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+	LMS_LOG(DB, INFO) << "Database maintenance done in " << res.duration.count() << " ms, reclaimed " << res.reclaimedBytes << " bytes";
+
+	return res;
+}
+
+} // namespace Database
+
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <Wt/Dbo/SqlConnection.h>
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+namespace Database {
+
+// Keeps the database file compact and the query planner statistics up to date
+// Runs outside of any transaction, on a connection taken from the pool
+class Maintenance
+{
+	public:
+
+		struct Result
+		{
+			std::chrono::milliseconds	duration {};
+			std::uintmax_t			reclaimedBytes {};	// shrinking of the database and WAL files
+		};
+
+		// Switch the database to incremental auto vacuum, rebuilding it if needed
+		// Must be called before the connection is shared
+		static void enableIncrementalVacuum(Wt::Dbo::SqlConnection& connection);
+
+		// PRAGMA optimize, incremental vacuum and WAL checkpoint
+		// Blocks the users of the pool until done
+		static Result run(Wt::Dbo::SqlConnectionPool& connectionPool);
+};
+
+} // namespace Database
+
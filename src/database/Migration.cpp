@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Migration.hpp"
+
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "utils/Exception.hpp"
+#include "utils/Logger.hpp"
+
+#include "PlayStats.hpp"
+#include "TrackFeatures.hpp"
+#include "TrackList.hpp"
+#include "Types.hpp"
+
+namespace Database {
+
+namespace {
+
+// Databases older than this one have to be rebuilt
+const Version minSupportedVersion {3};
+
+struct MigrationStep
+{
+	Version					version;	// version reached once the step is done
+	std::vector<std::string>		statements;	// executed first
+	std::function<void(Wt::Dbo::Session&)>	hook;		// optional, executed after the statements
+};
+
+// Ordered by version
+// When bumping LMS_DATABASE_VERSION, add a step here and a fixture of the previous version in test/database/fixtures
+// Hooks must only use raw SQL: mapped classes follow the latest schema, which later steps may not have reached yet
+const std::vector<MigrationStep> migrationSteps
+{
+	// Features are stored as packed vectors
+	{
+		4,
+		{
+			"ALTER TABLE track_features ADD vector BLOB NOT NULL DEFAULT x''",
+		},
+		[](Wt::Dbo::Session& session)
+		{
+			TrackFeatures::FeatureDimensions dimensions;
+			{
+				using DimensionType = std::tuple<std::string, int>;
+				Wt::Dbo::collection<DimensionType> res = session.query<DimensionType>("SELECT name, dimension_count FROM similarity_settings_feature");
+				for (const DimensionType& dimension : res)
+					dimensions[std::get<0>(dimension)] = std::get<1>(dimension);
+			}
+
+			// No settings yet: the features are fetched again on next scan
+			if (dimensions.empty())
+			{
+				session.execute("DELETE FROM track_features");
+				return;
+			}
+
+			// Documents are large, only a few of them are loaded at a time
+			static constexpr int batchSize {100};
+
+			using ResultType = std::tuple<IdType, std::string>;
+			IdType lastId {};
+			while (true)
+			{
+				Wt::Dbo::collection<ResultType> res = session.query<ResultType>("SELECT id, data FROM track_features WHERE id > ? ORDER BY id LIMIT ?")
+					.bind(lastId).bind(batchSize);
+				const std::vector<ResultType> features(res.begin(), res.end());
+				if (features.empty())
+					break;
+
+				for (const ResultType& feature : features)
+				{
+					const boost::optional<std::vector<float>> vector {TrackFeatures::extractVector(std::get<1>(feature), dimensions)};
+
+					// Unusable features are fetched again on next scan
+					if (vector)
+						session.execute("UPDATE track_features SET vector = ? WHERE id = ?").bind(TrackFeatures::packVector(*vector)).bind(std::get<0>(feature));
+					else
+						session.execute("DELETE FROM track_features WHERE id = ?").bind(std::get<0>(feature));
+				}
+
+				lastId = std::get<0>(features.back());
+			}
+		},
+	},
+	// Play stats are aggregated
+	{
+		5,
+		{},
+		[](Wt::Dbo::Session& session)
+		{
+			PlayStats::createTables(session);
+
+			Wt::Dbo::collection<IdType> res = session.query<IdType>("SELECT id FROM \"user\"");
+			const std::vector<IdType> userIds(res.begin(), res.end());
+
+			const Wt::WDateTime now {Wt::WDateTime::currentDateTime()};
+			for (IdType userId : userIds)
+				PlayStats::rebuild(session, userId, now);
+		},
+	},
+	// Tracklist entries are ordered by position
+	{
+		6,
+		{
+			"ALTER TABLE tracklist_entry ADD position BIGINT NOT NULL DEFAULT 0",
+			"UPDATE tracklist_entry SET position = id * " + std::to_string(TrackListEntry::positionGap),
+			"DROP INDEX IF EXISTS tracklist_entry_tracklist_idx",
+		},
+		{},
+	},
+	// Users have a Subsonic API secret
+	{
+		7,
+		{
+			"ALTER TABLE \"user\" ADD subsonic_api_secret TEXT NOT NULL DEFAULT ''",
+		},
+		{},
+	},
+};
+
+} // namespace
+
+VersionInfo::pointer
+VersionInfo::get(Wt::Dbo::Session& session)
+{
+	pointer versionInfo {session.find<VersionInfo>()};
+	if (!versionInfo)
+		versionInfo = session.add(std::make_unique<VersionInfo>());
+
+	return versionInfo;
+}
+
+void
+doDbMigration(Wt::Dbo::Session& session)
+{
+	Version version;
+	try
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		version = VersionInfo::get(session)->getVersion();
+	}
+	catch (std::exception& e)
+	{
+		LMS_LOG(DB, ERROR) << "Cannot get database version: " << e.what();
+		throw LmsException {"Cannot get database version, please rebuild it"};
+	}
+
+	LMS_LOG(DB, INFO) << "Database version = " << version << ", LMS database version = " << LMS_DATABASE_VERSION;
+
+	if (version > LMS_DATABASE_VERSION)
+		throw LmsException {"Database version " + std::to_string(version) + " is more recent than the supported one, please upgrade LMS"};
+
+	if (version < minSupportedVersion)
+		throw LmsException {"Database version " + std::to_string(version) + " is too old to be migrated, please rebuild it"};
+
+	for (const MigrationStep& step : migrationSteps)
+	{
+		if (step.version <= version)
+			continue;
+
+		LMS_LOG(DB, INFO) << "Migrating database from version " << version << " to " << step.version << "...";
+
+		try
+		{
+			Wt::Dbo::Transaction transaction {session};
+
+			for (const std::string& statement : step.statements)
+				session.execute(statement);
+
+			if (step.hook)
+				step.hook(session);
+
+			VersionInfo::get(session).modify()->setVersion(step.version);
+		}
+		catch (std::exception& e)
+		{
+			LMS_LOG(DB, ERROR) << "Migration to version " << step.version << " failed: " << e.what();
+			throw LmsException {"Database migration to version " + std::to_string(step.version) + " failed"};
+		}
+
+		LMS_LOG(DB, INFO) << "Migrating database from version " << version << " to " << step.version << " DONE";
+
+		version = step.version;
+	}
+
+	if (version != LMS_DATABASE_VERSION)
+		throw LmsException {"No migration path from database version " + std::to_string(version)};
+}
+
+} // namespace Database
+
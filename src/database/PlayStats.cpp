@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PlayStats.hpp"
+
+#include <cassert>
+#include <string>
+
+#include "Artist.hpp"
+#include "Release.hpp"
+#include "Track.hpp"
+#include "TrackList.hpp"
+#include "User.hpp"
+
+namespace Database {
+
+namespace {
+
+struct Aggregate
+{
+	std::string	table;
+	std::string	column;		// id of the aggregated object
+	std::string	objectTable;
+	std::string	trackObjects;	// object ids of the bound track, as "object_id"
+	std::string	historyObjects;	// object ids of each entry of the bound tracklist, as "object_id"
+};
+
+const Aggregate trackStats
+{
+	"play_stats_track",
+	"track_id",
+	"track",
+	"SELECT t.id AS object_id FROM track t WHERE t.id = ?",
+	"SELECT p_e.track_id AS object_id FROM tracklist_entry p_e WHERE p_e.tracklist_id = ?",
+};
+
+const Aggregate releaseStats
+{
+	"play_stats_release",
+	"release_id",
+	"release",
+	"SELECT t.release_id AS object_id FROM track t WHERE t.id = ? AND t.release_id IS NOT NULL",
+	"SELECT t.release_id AS object_id FROM tracklist_entry p_e INNER JOIN track t ON t.id = p_e.track_id WHERE p_e.tracklist_id = ? AND t.release_id IS NOT NULL",
+};
+
+// An artist may be linked several times to the same track
+const Aggregate artistStats
+{
+	"play_stats_artist",
+	"artist_id",
+	"artist",
+	"SELECT DISTINCT t_a_l.artist_id AS object_id FROM track_artist_link t_a_l WHERE t_a_l.track_id = ?",
+	"SELECT t_a_l.artist_id AS object_id FROM tracklist_entry p_e INNER JOIN track_artist_link t_a_l ON t_a_l.track_id = p_e.track_id WHERE p_e.tracklist_id = ? GROUP BY p_e.id, t_a_l.artist_id",
+};
+
+const Aggregate* const aggregates[] {&trackStats, &releaseStats, &artistStats};
+
+using Day = long long;
+
+// Days since epoch, UTC
+Day
+toDay(const Wt::WDateTime& time)
+{
+	return static_cast<Day>(time.toTime_t() / (24 * 3600));
+}
+
+template <typename T>
+std::vector<Wt::Dbo::ptr<T>>
+getTop(Wt::Dbo::Session& session, const Aggregate& aggregate, const std::string& sql, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since)
+{
+	assert(user);
+
+	auto query {session.query<Wt::Dbo::ptr<T>>(sql)};
+	query.where("p_s.user_id = ?").bind(user.id());
+	if (since.isValid())
+		query.where("p_s.day >= ?").bind(toDay(since));
+
+	Wt::Dbo::collection<Wt::Dbo::ptr<T>> res = query
+		.groupBy("p_s." + aggregate.column)
+		.orderBy("SUM(p_s.count) DESC")
+		.limit(static_cast<int>(limit));
+
+	return std::vector<Wt::Dbo::ptr<T>>(res.begin(), res.end());
+}
+
+} // namespace
+
+void
+PlayStats::createTables(Wt::Dbo::Session& session)
+{
+	for (const Aggregate* aggregate : aggregates)
+	{
+		session.execute("CREATE TABLE IF NOT EXISTS " + aggregate->table + " ("
+				"user_id INTEGER NOT NULL REFERENCES \"user\"(id) ON DELETE CASCADE,"
+				+ aggregate->column + " INTEGER NOT NULL REFERENCES " + aggregate->objectTable + "(id) ON DELETE CASCADE,"
+				"day INTEGER NOT NULL,"
+				"count INTEGER NOT NULL,"
+				"PRIMARY KEY (user_id, " + aggregate->column + ", day)"
+				") WITHOUT ROWID");
+
+		// Used when tracks, releases or artists are removed
+		session.execute("CREATE INDEX IF NOT EXISTS " + aggregate->table + "_" + aggregate->column + "_idx ON " + aggregate->table + "(" + aggregate->column + ")");
+	}
+}
+
+void
+PlayStats::addPlay(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track, const Wt::WDateTime& time)
+{
+	assert(user);
+	assert(track);
+
+	const Day day {toDay(time)};
+
+	for (const Aggregate* aggregate : aggregates)
+	{
+		session.execute("INSERT OR IGNORE INTO " + aggregate->table + " (user_id, " + aggregate->column + ", day, count) SELECT ?, object_id, ?, 0 FROM (" + aggregate->trackObjects + ")")
+			.bind(user.id()).bind(day).bind(track.id());
+
+		session.execute("UPDATE " + aggregate->table + " SET count = count + 1 WHERE user_id = ? AND day = ? AND " + aggregate->column + " IN (" + aggregate->trackObjects + ")")
+			.bind(user.id()).bind(day).bind(track.id());
+	}
+}
+
+void
+PlayStats::rebuild(Wt::Dbo::Session& session, IdType userId, const Wt::WDateTime& time)
+{
+	const Day day {toDay(time)};
+
+	// The history is only created on the first play
+	Wt::Dbo::collection<IdType> res = session.query<IdType>("SELECT id FROM tracklist WHERE name = ? AND user_id = ?")
+		.bind(User::playedTrackListName).bind(userId).limit(1);
+	const std::vector<IdType> historyIds(res.begin(), res.end());
+
+	for (const Aggregate* aggregate : aggregates)
+	{
+		session.execute("DELETE FROM " + aggregate->table + " WHERE user_id = ?").bind(userId);
+
+		if (!historyIds.empty())
+			session.execute("INSERT INTO " + aggregate->table + " (user_id, " + aggregate->column + ", day, count) SELECT ?, object_id, ?, COUNT(*) FROM (" + aggregate->historyObjects + ") GROUP BY object_id")
+				.bind(userId).bind(day).bind(historyIds.front());
+	}
+}
+
+void
+PlayStats::compactHistory(Wt::Dbo::Session& session, Wt::Dbo::ptr<TrackList> history, std::size_t maxEntries)
+{
+	assert(history);
+
+	session.execute("DELETE FROM tracklist_entry WHERE tracklist_id = ? AND id <= (SELECT id FROM tracklist_entry WHERE tracklist_id = ? ORDER BY id DESC LIMIT 1 OFFSET ?)")
+		.bind(history.id()).bind(history.id()).bind(static_cast<int>(maxEntries));
+}
+
+std::vector<Artist::pointer>
+PlayStats::getTopArtists(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since)
+{
+	return getTop<Artist>(session, artistStats, "SELECT a FROM artist a INNER JOIN play_stats_artist p_s ON p_s.artist_id = a.id", user, limit, since);
+}
+
+std::vector<Release::pointer>
+PlayStats::getTopReleases(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since)
+{
+	return getTop<Release>(session, releaseStats, "SELECT r FROM release r INNER JOIN play_stats_release p_s ON p_s.release_id = r.id", user, limit, since);
+}
+
+std::vector<Track::pointer>
+PlayStats::getTopTracks(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since)
+{
+	return getTop<Track>(session, trackStats, "SELECT t FROM track t INNER JOIN play_stats_track p_s ON p_s.track_id = t.id", user, limit, since);
+}
+
+} // namespace Database
+
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <Wt/Dbo/Dbo.h>
+#include <Wt/WDateTime.h>
+
+#include "Types.hpp"
+
+namespace Database {
+
+class Artist;
+class Release;
+class Track;
+class TrackList;
+class User;
+
+// Play counts per user, per day, for tracks, releases and artists
+// Maintained along with the play history so that the top queries do not have to go through it
+class PlayStats
+{
+	public:
+		// Create the aggregate tables, if needed
+		static void createTables(Wt::Dbo::Session& session);
+
+		// Must be called for each entry appended to the play history
+		static void addPlay(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, Wt::Dbo::ptr<Track> track, const Wt::WDateTime& time);
+
+		// Recompute the stats of the user from the whole play history
+		// History entries are not dated: all of them are accounted at the given time
+		// Only relies on the tables, so that it can be used by the migrations
+		static void rebuild(Wt::Dbo::Session& session, IdType userId, const Wt::WDateTime& time);
+
+		// Only keep the maxEntries most recent entries of the history, stats are kept untouched
+		static void compactHistory(Wt::Dbo::Session& session, Wt::Dbo::ptr<TrackList> history, std::size_t maxEntries);
+
+		// Most played first, only plays at or after since are accounted if set
+		static std::vector<Wt::Dbo::ptr<Artist>> getTopArtists(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since = {});
+		static std::vector<Wt::Dbo::ptr<Release>> getTopReleases(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since = {});
+		static std::vector<Wt::Dbo::ptr<Track>> getTopTracks(Wt::Dbo::Session& session, Wt::Dbo::ptr<User> user, std::size_t limit, const Wt::WDateTime& since = {});
+};
+
+} // namespace Database
+
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "QueryStats.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+#include "utils/Logger.hpp"
+#include "utils/Utils.hpp"
+
+namespace Database {
+
+static
+bool
+isIdentifierChar(char c)
+{
+	return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+QueryStats::QueryStats(std::chrono::milliseconds slowQueryThreshold)
+: _slowQueryThreshold {slowQueryThreshold}
+{
+}
+
+void
+QueryStats::record(const std::string& query, std::chrono::microseconds duration, std::size_t rows, const std::vector<std::string>& params)
+{
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		Stats& stats {_stats[query]};
+		stats.count++;
+		stats.total += duration;
+		stats.rows += rows;
+		stats.histogram[getBucket(duration)]++;
+	}
+
+	if (isSlowQueryLogEnabled() && duration >= _slowQueryThreshold)
+		LMS_LOG(DB, WARNING) << "Slow query: " << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms, " << rows << " rows, query = '" << query << "', params = [" << joinStrings(params, ", ") << "]";
+}
+
+std::vector<QueryStats::Entry>
+QueryStats::getEntries() const
+{
+	std::vector<Entry> res;
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		res.reserve(_stats.size());
+		for (const auto& itStats : _stats)
+		{
+			const Stats& stats {itStats.second};
+			res.push_back({itStats.first, stats.count, stats.total, getPercentile(stats, 50), getPercentile(stats, 99), stats.rows});
+		}
+	}
+
+	std::sort(std::begin(res), std::end(res), [](const Entry& a, const Entry& b) { return a.total > b.total; });
+
+	return res;
+}
+
+QueryStats::StatementCacheStats
+QueryStats::getStatementCacheStats() const
+{
+	return {_statementHits.load(), _statementMisses.load()};
+}
+
+void
+QueryStats::clear()
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	_stats.clear();
+	_statementHits = 0;
+	_statementMisses = 0;
+}
+
+std::size_t
+QueryStats::getBucket(std::chrono::microseconds duration)
+{
+	std::size_t bucket {};
+	for (auto value {duration.count()}; value > 1 && bucket < nbBuckets - 1; value >>= 1)
+		++bucket;
+
+	return bucket;
+}
+
+std::chrono::microseconds
+QueryStats::getPercentile(const Stats& stats, std::size_t percentile)
+{
+	const std::size_t rank {(stats.count * percentile + 99) / 100};
+
+	std::size_t count {};
+	for (std::size_t bucket {}; bucket < nbBuckets; ++bucket)
+	{
+		count += stats.histogram[bucket];
+		if (count >= rank)
+			return std::chrono::microseconds {1LL << (bucket + 1)}; // upper bound of the bucket
+	}
+
+	return {};
+}
+
+std::string
+QueryStats::normalize(const std::string& sql)
+{
+	std::string res;
+	res.reserve(sql.size());
+
+	for (std::size_t i {}; i < sql.size(); ++i)
+	{
+		const char c {sql[i]};
+
+		if (std::isspace(static_cast<unsigned char>(c)))
+		{
+			if (!res.empty() && res.back() != ' ')
+				res.push_back(' ');
+		}
+		else if (c == '\'')
+		{
+			// skip the whole string literal, '' being an escaped quote
+			for (++i; i < sql.size(); ++i)
+			{
+				if (sql[i] != '\'')
+					continue;
+
+				if (i + 1 < sql.size() && sql[i + 1] == '\'')
+					++i;
+				else
+					break;
+			}
+			res.push_back('?');
+		}
+		else if (std::isdigit(static_cast<unsigned char>(c)) && (res.empty() || !isIdentifierChar(res.back())))
+		{
+			while (i + 1 < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i + 1])) || sql[i + 1] == '.'))
+				++i;
+			res.push_back('?');
+		}
+		else
+			res.push_back(c);
+	}
+
+	if (!res.empty() && res.back() == ' ')
+		res.pop_back();
+
+	return res;
+}
+
+} // namespace Database
+
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Database {
+
+// Per statement execution statistics, shared by all the connections of a pool
+class QueryStats
+{
+	public:
+
+		struct Entry
+		{
+			std::string			query;
+			std::size_t			count {};
+			std::chrono::microseconds	total {};
+			std::chrono::microseconds	p50 {};
+			std::chrono::microseconds	p99 {};
+			std::size_t			rows {};
+		};
+
+		// Executions taking longer than slowQueryThreshold are logged, 0 to disable
+		QueryStats(std::chrono::milliseconds slowQueryThreshold = {});
+
+		bool isSlowQueryLogEnabled() const { return _slowQueryThreshold.count() > 0; }
+
+		// query must be normalized
+		// params are only used by the slow query log and should already be redacted
+		void record(const std::string& query, std::chrono::microseconds duration, std::size_t rows, const std::vector<std::string>& params);
+
+		// Prepared statement cache of the connections: a miss is a newly prepared statement,
+		// a hit is an execution of a statement that was already prepared
+		struct StatementCacheStats
+		{
+			std::size_t	hits {};
+			std::size_t	misses {};
+		};
+
+		void recordStatementPrepared() { _statementMisses++; }
+		void recordStatementReused() { _statementHits++; }
+		StatementCacheStats getStatementCacheStats() const;
+
+		// Sorted by total time, descending
+		std::vector<Entry> getEntries() const;
+		void clear();
+
+		// Collapse white spaces and replace literals by '?'
+		static std::string normalize(const std::string& sql);
+
+	private:
+
+		// Log2 histogram of the durations in microseconds, used to approximate the percentiles
+		static constexpr std::size_t nbBuckets {32};
+
+		struct Stats
+		{
+			std::size_t			count {};
+			std::chrono::microseconds	total {};
+			std::size_t			rows {};
+			std::array<std::size_t, nbBuckets> histogram {};
+		};
+
+		static std::size_t getBucket(std::chrono::microseconds duration);
+		static std::chrono::microseconds getPercentile(const Stats& stats, std::size_t percentile);
+
+		const std::chrono::milliseconds	_slowQueryThreshold;
+
+		mutable std::mutex				_mutex;
+		std::unordered_map<std::string, Stats>		_stats;
+
+		std::atomic<std::size_t>			_statementHits {};
+		std::atomic<std::size_t>			_statementMisses {};
+};
+
+} // namespace Database
+
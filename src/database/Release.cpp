@@ -64,8 +64,7 @@ Release::create(Wt::Dbo::Session& session, const std::string& name, const std::s
 std::size_t
 Release::getCount(Wt::Dbo::Session& session)
 {
-	Wt::Dbo::collection<pointer> releases {session.find<Release>()};
-	return releases.size();
+	return session.query<int>("SELECT COUNT(*) FROM release");
 }
 
 std::vector<Release::pointer>
@@ -116,37 +115,35 @@ getQuery(Wt::Dbo::Session& session,
 			const std::set<IdType>& clusterIds,
 			const std::vector<std::string> keywords)
 {
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-        std::ostringstream oss;
-	oss << "SELECT DISTINCT r FROM release r";
+	WhereClause where;
 
 	for (auto keyword : keywords)
 		where.And(WhereClause("r.name LIKE ?")).bind("%%" + keyword + "%%");
 
 	if (!clusterIds.empty())
-	{
-		oss << " INNER JOIN track t ON t.release_id = r.id INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
+		where.And(WhereClause::in("c.id", clusterIds));
 
-		WhereClause clusterClause;
+	const std::string sql {queryCache.get({keywords.size(), clusterIds.size()}, [&]
+	{
+		std::string res {"SELECT DISTINCT r FROM release r"};
 
-		for (auto id : clusterIds)
-			clusterClause.Or(WhereClause("c.id = ?")).bind(std::to_string(id));
+		if (!clusterIds.empty())
+			res += " INNER JOIN track t ON t.release_id = r.id INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
 
-		where.And(clusterClause);
-	}
+		res += " " + where.get();
 
-	oss << " " << where.get();
+		if (!clusterIds.empty())
+			res += " GROUP BY t.id HAVING COUNT(*) = " + std::to_string(clusterIds.size());
 
-	if (!clusterIds.empty())
-		oss << " GROUP BY t.id HAVING COUNT(*) = " << clusterIds.size();
+		res += " ORDER BY r.name COLLATE NOCASE";
 
-	oss << " ORDER BY r.name COLLATE NOCASE";
+		return res;
+	})};
 
-	Wt::Dbo::Query<Release::pointer> query = session.query<Release::pointer>( oss.str() );
-
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Release::pointer> query {session.query<Release::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	return query;
 }
@@ -289,38 +286,34 @@ Release::getTracks(const std::set<IdType>& clusterIds) const
 	assert(self()->id() != Wt::Dbo::dbo_traits<Release>::invalidId() );
 	assert(session());
 
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-	std::ostringstream oss;
-	oss << "SELECT t FROM track t INNER JOIN release r ON t.release_id = r.id";
+	WhereClause where;
 
 	if (!clusterIds.empty())
-	{
-		oss << " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
-
-		WhereClause clusterClause;
+		where.And(WhereClause::in("c.id", clusterIds));
 
-		for (auto id : clusterIds)
-			clusterClause.Or(WhereClause("c.id = ?")).bind(std::to_string(id));
+	where.And(WhereClause("r.id = ?")).bind(id());
 
-		where.And(clusterClause);
-	}
+	const std::string sql {queryCache.get({clusterIds.size()}, [&]
+	{
+		std::string res {"SELECT t FROM track t INNER JOIN release r ON t.release_id = r.id"};
 
-	where.And(WhereClause("r.id = ?")).bind(std::to_string(id()));
+		if (!clusterIds.empty())
+			res += " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
 
-	oss << " " << where.get();
+		res += " " + where.get();
 
-	if (!clusterIds.empty())
-		oss << " GROUP BY t.id HAVING COUNT(*) = " << clusterIds.size();
+		if (!clusterIds.empty())
+			res += " GROUP BY t.id HAVING COUNT(*) = " + std::to_string(clusterIds.size());
 
-	oss << " ORDER BY t.disc_number,t.track_number";
+		res += " ORDER BY t.disc_number,t.track_number";
 
-	Wt::Dbo::Query<Track::pointer> query = session()->query<Track::pointer>( oss.str() );
+		return res;
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-	{
-		query.bind(bindArg);
-	}
+	Wt::Dbo::Query<Track::pointer> query {session()->query<Track::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	Wt::Dbo::collection< Wt::Dbo::ptr<Track> > res = query;
 
@@ -349,26 +342,27 @@ Release::getClusterGroups(std::vector<ClusterType::pointer> clusterTypes, std::s
 	assert(self()->id() != Wt::Dbo::dbo_traits<Artist>::invalidId() );
 	assert(session());
 
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-	std::ostringstream oss;
+	std::set<IdType> clusterTypeIds;
+	for (auto clusterType : clusterTypes)
+		clusterTypeIds.insert(clusterType.id());
 
-	oss << "SELECT c from cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id INNER JOIN release r ON t.release_id = r.id ";
+	WhereClause where;
 
-	where.And(WhereClause("r.id = ?")).bind(std::to_string(self()->id()));
-	{
-		WhereClause clusterClause;
-		for (auto clusterType : clusterTypes)
-			clusterClause.Or(WhereClause("c_type.id = ?")).bind(std::to_string(clusterType.id()));
-		where.And(clusterClause);
-	}
-	oss << " " << where.get();
-	oss << " GROUP BY c.id ORDER BY COUNT(c.id) DESC";
+	where.And(WhereClause("r.id = ?")).bind(self()->id());
+	if (!clusterTypeIds.empty())
+		where.And(WhereClause::in("c_type.id", clusterTypeIds));
 
-	Wt::Dbo::Query<Cluster::pointer> query = session()->query<Cluster::pointer>( oss.str() );
+	const std::string sql {queryCache.get({clusterTypeIds.size()}, [&]
+	{
+		return "SELECT c from cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id INNER JOIN release r ON t.release_id = r.id"
+			" " + where.get() +
+			" GROUP BY c.id ORDER BY COUNT(c.id) DESC";
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Cluster::pointer> query {session()->query<Cluster::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	Wt::Dbo::collection<Cluster::pointer> queryRes = query;
 
@@ -79,5 +79,15 @@ SimilaritySettings::getFeatures() const
 	return std::vector<Wt::Dbo::ptr<SimilaritySettingsFeature>>(_features.begin(), _features.end());
 }
 
+std::map<std::string, std::size_t>
+SimilaritySettings::getFeatureDimensions() const
+{
+	std::map<std::string, std::size_t> res;
+	for (const Wt::Dbo::ptr<SimilaritySettingsFeature>& feature : _features)
+		res[feature->getName()] = feature->getNbDimensions();
+
+	return res;
+}
+
 } // namespace Database
 
@@ -19,6 +19,9 @@
 
 #pragma once
 
+#include <map>
+#include <string>
+
 #include <Wt/Dbo/Dbo.h>
 
 namespace Database {
@@ -76,6 +79,7 @@ class SimilaritySettings : public Wt::Dbo::Dbo<SimilaritySettings>
 		std::size_t		getVersion() const { return _settingsVersion; }
 		EngineType		getEngineType() const { return _engineType; }
 		std::vector<Wt::Dbo::ptr<SimilaritySettingsFeature>> getFeatures() const;
+		std::map<std::string, std::size_t> getFeatureDimensions() const; // feature name -> number of dimensions
 
 		// Setters
 		void	setEngineType(EngineType type) { _engineType = type; }
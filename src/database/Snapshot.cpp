@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Snapshot.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include <sqlite3.h>
+
+#include "utils/Exception.hpp"
+#include "utils/Logger.hpp"
+
+#include "Connection.hpp"
+
+namespace Database {
+
+static const boost::filesystem::path snapshotDbFileName {"lms.db"};
+static const boost::filesystem::path currentFileName {"current"};
+
+static
+void
+copyDirectoryFiles(const boost::filesystem::path& srcDirectory, const boost::filesystem::path& dstDirectory)
+{
+	boost::filesystem::create_directories(dstDirectory);
+
+	if (!boost::filesystem::is_directory(srcDirectory))
+		return;
+
+	for (const boost::filesystem::directory_entry& entry : boost::filesystem::directory_iterator {srcDirectory})
+	{
+		if (!boost::filesystem::is_regular_file(entry.path()))
+			continue;
+
+		boost::filesystem::copy_file(entry.path(), dstDirectory / entry.path().filename(), boost::filesystem::copy_option::overwrite_if_exists);
+	}
+}
+
+static
+void
+backupDatabase(const boost::filesystem::path& srcFile, const boost::filesystem::path& dstFile)
+{
+	constexpr std::size_t maxAttempts {10};
+
+	// Do not touch the schema, the database may be in use
+	Connection source {srcFile.string(), StorageProfile::LowMemory, true};
+
+	sqlite3* dst {};
+	if (sqlite3_open_v2(dstFile.string().c_str(), &dst, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
+	{
+		const std::string error {dst ? sqlite3_errmsg(dst) : "out of memory"};
+		sqlite3_close(dst);
+		throw LmsException {"Cannot open '" + dstFile.string() + "': " + error};
+	}
+
+	sqlite3_backup* backup {sqlite3_backup_init(dst, "main", source.connection(), "main")};
+	if (!backup)
+	{
+		const std::string error {sqlite3_errmsg(dst)};
+		sqlite3_close(dst);
+		throw LmsException {"Cannot start backup: " + error};
+	}
+
+	// All the pages are copied in a single step, within a single read transaction on the source
+	// Copying a few pages at a time would let SQLite restart the backup each time the source is written in between,
+	// which may never end while the server is writing
+	// In WAL mode, this read transaction does not prevent the server from writing
+	int res {SQLITE_BUSY};
+	for (std::size_t attempt {}; attempt < maxAttempts && (res == SQLITE_BUSY || res == SQLITE_LOCKED); ++attempt)
+	{
+		if (attempt > 0)
+		{
+			LMS_LOG(DB, DEBUG) << "Backup: source busy, retrying...";
+			std::this_thread::sleep_for(std::chrono::milliseconds {500});
+		}
+
+		res = sqlite3_backup_step(backup, -1);
+	}
+
+	const int pageCount {sqlite3_backup_pagecount(backup)};
+	sqlite3_backup_finish(backup);
+
+	const std::string error {res == SQLITE_BUSY || res == SQLITE_LOCKED ? "source database still busy after " + std::to_string(maxAttempts) + " attempts" : sqlite3_errmsg(dst)};
+	sqlite3_close(dst);
+
+	if (res != SQLITE_DONE)
+		throw LmsException {"Backup of '" + srcFile.string() + "' failed: " + error};
+
+	LMS_LOG(DB, DEBUG) << "Backup: copied " << pageCount << " pages";
+}
+
+void
+Snapshot::create(const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories, const boost::filesystem::path& snapshotDirectory)
+{
+	LMS_LOG(DB, INFO) << "Creating snapshot in '" << snapshotDirectory.string() << "'...";
+
+	boost::filesystem::create_directories(snapshotDirectory);
+
+	// Write in a temporary file first, so that an interrupted backup does not leave a truncated database
+	const boost::filesystem::path dstFile {snapshotDirectory / snapshotDbFileName};
+	const boost::filesystem::path tmpFile {dstFile.string() + ".tmp"};
+
+	backupDatabase(dbFile, tmpFile);
+	boost::filesystem::rename(tmpFile, dstFile);
+
+	for (const boost::filesystem::path& directory : directories)
+		copyDirectoryFiles(directory, snapshotDirectory / directory.filename());
+
+	LMS_LOG(DB, INFO) << "Snapshot created in '" << snapshotDirectory.string() << "'";
+}
+
+void
+Snapshot::publish(const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories, const boost::filesystem::path& publishDirectory)
+{
+	const boost::optional<std::string> previousId {getPublishedId(publishDirectory)};
+	const std::string id {std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count())};
+
+	create(dbFile, directories, publishDirectory / id);
+
+	// Atomically replace the current id
+	const boost::filesystem::path tmpFile {(publishDirectory / currentFileName).string() + ".tmp"};
+	{
+		std::ofstream ofs {tmpFile.string(), std::ios::trunc};
+		ofs << id;
+		if (!ofs)
+			throw LmsException {"Cannot write '" + tmpFile.string() + "'"};
+	}
+	boost::filesystem::rename(tmpFile, publishDirectory / currentFileName);
+
+	for (const boost::filesystem::directory_entry& entry : boost::filesystem::directory_iterator {publishDirectory})
+	{
+		const std::string name {entry.path().filename().string()};
+		if (!boost::filesystem::is_directory(entry.path()) || name == id || (previousId && name == *previousId))
+			continue;
+
+		boost::system::error_code ec;
+		boost::filesystem::remove_all(entry.path(), ec);
+		if (ec)
+			LMS_LOG(DB, ERROR) << "Cannot remove old snapshot '" << entry.path().string() << "': " << ec.message();
+	}
+
+	LMS_LOG(DB, INFO) << "Published snapshot '" << id << "'";
+}
+
+boost::optional<std::string>
+Snapshot::getPublishedId(const boost::filesystem::path& publishDirectory)
+{
+	std::ifstream ifs {(publishDirectory / currentFileName).string()};
+
+	std::string id;
+	if (!(ifs >> id) || !boost::filesystem::is_regular_file(publishDirectory / id / snapshotDbFileName))
+		return boost::none;
+
+	return id;
+}
+
+void
+Snapshot::install(const boost::filesystem::path& snapshotDirectory, const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories)
+{
+	const boost::filesystem::path srcFile {snapshotDirectory / snapshotDbFileName};
+	if (!boost::filesystem::is_regular_file(srcFile))
+		throw LmsException {"No database found in '" + snapshotDirectory.string() + "'"};
+
+	LMS_LOG(DB, INFO) << "Installing snapshot '" << snapshotDirectory.string() << "'...";
+
+	boost::filesystem::create_directories(dbFile.parent_path());
+	boost::filesystem::remove(dbFile.string() + "-wal");
+	boost::filesystem::remove(dbFile.string() + "-shm");
+	boost::filesystem::copy_file(srcFile, dbFile, boost::filesystem::copy_option::overwrite_if_exists);
+
+	for (const boost::filesystem::path& directory : directories)
+	{
+		boost::filesystem::remove_all(directory);
+		copyDirectoryFiles(snapshotDirectory / directory.filename(), directory);
+	}
+
+	LMS_LOG(DB, INFO) << "Snapshot '" << snapshotDirectory.string() << "' installed";
+}
+
+} // namespace Database
+
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+
+namespace Database {
+
+// A snapshot is a directory holding a consistent copy of the database,
+// along with the cache directories that go with it
+// Published snapshots are stored in <publish directory>/<id>, the file
+// <publish directory>/current holding the id of the last complete one
+class Snapshot
+{
+	public:
+		// Uses the SQLite online backup API, copying a consistent state of the database while it can still be written
+		// Directories are copied in the snapshot using their name
+		// Throws LmsException on failure
+		static void create(const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories, const boost::filesystem::path& snapshotDirectory);
+
+		// Create a new snapshot and make it the current one
+		// Only the previous snapshot is kept, so that the instances still copying it can finish
+		static void publish(const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories, const boost::filesystem::path& publishDirectory);
+
+		// Id of the last published snapshot, if any
+		static boost::optional<std::string> getPublishedId(const boost::filesystem::path& publishDirectory);
+
+		// Copy the database and the directories of the snapshot to the given locations
+		// The database must not be in use, the previous content of the directories is removed
+		static void install(const boost::filesystem::path& snapshotDirectory, const boost::filesystem::path& dbFile, const std::vector<boost::filesystem::path>& directories);
+};
+
+} // namespace Database
+
@@ -21,7 +21,22 @@
 
 #include <algorithm>
 #include <cassert>
-#include <sstream>
+
+namespace Database {
+
+WhereClause
+WhereClause::in(const std::string& column, const std::set<IdType>& values)
+{
+	std::string placeholders;
+	for (std::size_t i {}; i < values.size(); ++i)
+		placeholders += (i == 0 ? "?" : ", ?");
+
+	WhereClause res {column + " IN (" + placeholders + ")"};
+	for (IdType value : values)
+		res.bind(value);
+
+	return res;
+}
 
 WhereClause&
 WhereClause::And(const WhereClause& otherClause)
@@ -32,10 +47,7 @@ WhereClause::And(const WhereClause& otherClause)
 		_clause += "(" + otherClause._clause + ")";
 
 		// Add associated bind args
-		for (const std::string& otherBindArg : otherClause._bindArgs)
-		{
-			_bindArgs.push_back(otherBindArg);
-		}
+		_bindArgs.insert(std::end(_bindArgs), std::cbegin(otherClause._bindArgs), std::cend(otherClause._bindArgs));
 	}
 	return *this;
 }
@@ -49,10 +61,7 @@ WhereClause::Or(const WhereClause& otherClause)
 		_clause += "(" + otherClause._clause + ")";
 
 		// Add associated bind args
-		for (const std::string& otherBindArg : otherClause._bindArgs)
-		{
-			_bindArgs.push_back(otherBindArg);
-		}
+		_bindArgs.insert(std::end(_bindArgs), std::cbegin(otherClause._bindArgs), std::cend(otherClause._bindArgs));
 	}
 	return *this;
 }
@@ -67,133 +76,47 @@ WhereClause::get(void) const
 }
 
 WhereClause&
-WhereClause::bind(const std::string& bindArg)
+WhereClause::bind(long long bindArg)
 {
 	assert(_bindArgs.size() < static_cast<std::size_t>(std::count(_clause.begin(), _clause.end(), '?')));
 
-	_bindArgs.push_back(bindArg);
+	_bindArgs.emplace_back(bindArg);
 
 	return *this;
 }
 
-InnerJoinClause::InnerJoinClause(const std::string& clause)
-:_clause(clause)
-{
-}
-
-InnerJoinClause&
-InnerJoinClause::And(const InnerJoinClause& clause)
-{
-	if (!_clause.empty())
-		_clause += " ";
-
-	_clause += "INNER JOIN " + clause._clause;
-
-	return *this;
-}
-
-SelectStatement::SelectStatement(const std::string& statement)
-{
-	And(statement);
-}
-
-SelectStatement&
-SelectStatement::And(const std::string& statement)
+WhereClause&
+WhereClause::bind(const std::string& bindArg)
 {
-	_statement.push_back(statement);
+	assert(_bindArgs.size() < static_cast<std::size_t>(std::count(_clause.begin(), _clause.end(), '?')));
 
-	_statement.sort();
-	_statement.unique();
+	_bindArgs.emplace_back(bindArg);
 
 	return *this;
 }
 
 std::string
-SelectStatement::get() const
+SqlQueryCache::get(const Shape& shape, std::function<std::string()> buildQuery)
 {
-	std::string res = "SELECT ";
-
-	for (std::list<std::string>::const_iterator it = _statement.begin(); it != _statement.end(); ++it)
 	{
-		if (it != _statement.begin())
-			res += ",";
-		res += *it;
-	}
-
-	return res;
-}
+		std::unique_lock<std::mutex> lock {_mutex};
 
-
-
-GroupByStatement&
-GroupByStatement::And(const GroupByStatement& statement)
-{
-	if( _statement.empty() && !statement._statement.empty())
-		_statement = "GROUP BY ";
-	else if (!_statement.empty() && !statement._statement.empty())
-		_statement += ",";
-
-	_statement += statement._statement;
-	return *this;
-}
-
-FromClause::FromClause(const std::string& clause)
-{
-	_clause.push_back(clause);
-}
-
-FromClause&
-FromClause::And(const FromClause& clause)
-{
-	for (const std::string fromClause : clause._clause)
-	{
-		_clause.push_back(fromClause);
+		auto it {_queries.find(shape)};
+		if (it != _queries.end())
+			return it->second;
 	}
 
-	_clause.sort();
-	_clause.unique();
-
-	return *this;
-}
-
-std::string
-FromClause::get() const
-{
-	std::ostringstream oss;
+	std::string query {buildQuery()};
 
-	if (!_clause.empty())
 	{
-		oss << "FROM ";
-		for (std::list<std::string>::const_iterator it = _clause.begin(); it != _clause.end(); ++it) {
-			if (it != _clause.begin())
-				oss << ",";
+		std::unique_lock<std::mutex> lock {_mutex};
 
-			oss << *it;
-		}
+		if (_queries.size() < maxEntries)
+			_queries.emplace(shape, query);
 	}
 
-	return oss.str();
+	return query;
 }
 
-std::string
-SqlQuery::get(void) const
-{
-	std::ostringstream oss;
-
-	oss << _selectStatement.get();
-
-	if (!_fromClause.get().empty())
-		oss << " " << _fromClause.get();
-
-	if (!_innerJoinClause.get().empty())
-		oss << " " << _innerJoinClause.get();
-
-	if (!_whereClause.get().empty())
-		oss << " " << _whereClause.get();
-
-	if (!_groupByStatement.get().empty())
-		oss << " " << _groupByStatement.get();
-
-	return oss.str();
-}
+} // namespace Database
 
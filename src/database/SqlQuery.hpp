@@ -19,117 +19,91 @@
 
 #pragma once
 
-#include <list>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
+#include <boost/variant.hpp>
+
+#include <Wt/Dbo/Query.h>
+
+#include "Types.hpp"
+
+namespace Database {
+
+// Bound as is, so that integer columns are compared with integers
+using SqlValue = boost::variant<long long, std::string>;
 
 class WhereClause
 {
 	public:
 
 		WhereClause() {}
-		WhereClause(const std::string& clause) { _clause = clause; }
+		WhereClause(const std::string& clause) : _clause {clause} {}
+
+		// "column IN (?, ...)", with the values bound
+		static WhereClause in(const std::string& column, const std::set<IdType>& values);
 
 		WhereClause& And(const WhereClause& clause);
 		WhereClause& Or(const WhereClause& clause);
 
 		// Arguments binding (for each '?' in where clause)
+		WhereClause& bind(long long arg);
 		WhereClause& bind(const std::string& arg);
 
 		std::string get() const;
-		const std::list<std::string>&	getBindArgs(void) const	{return _bindArgs;}
+		const std::vector<SqlValue>& getBindArgs() const { return _bindArgs; }
 
 	private:
 
-		std::string _clause;		// WHERE clause
-		std::list<std::string>  _bindArgs;
-
+		std::string		_clause;
+		std::vector<SqlValue>	_bindArgs;
 };
 
-class InnerJoinClause
+// SQL of the queries whose text only depends on a few sizes (number of keywords, of clusters, ...)
+// Each shape always gets the same text, built once, so that the prepared statements can be reused
+class SqlQueryCache
 {
 	public:
+		using Shape = std::vector<std::size_t>;
 
-		InnerJoinClause() {}
-		InnerJoinClause(const std::string& clause);
-
-		InnerJoinClause&	And(const InnerJoinClause& clause);
-		std::string get() const	{ return _clause;}
+		std::string get(const Shape& shape, std::function<std::string()> buildQuery);
 
 	private:
+		static constexpr std::size_t maxEntries {256};
 
-		std::string _clause;
+		std::mutex			_mutex;
+		std::map<Shape, std::string>	_queries;
 };
 
-class GroupByStatement
-{
-	public:
-		GroupByStatement() {}
-		GroupByStatement(const std::string& statement) { _statement = statement; }
-
-		GroupByStatement& And(const GroupByStatement& statement);
-
-		std::string get() const      {return _statement;}
+namespace Impl {
 
-	private:
-		std::string _statement;		// SELECT statement
-
-};
-
-class SelectStatement
+template <typename Result>
+class BindVisitor : public boost::static_visitor<>
 {
 	public:
-		SelectStatement() {};
-		SelectStatement(const std::string& item);
-
-		SelectStatement& And(const std::string& item);
+		BindVisitor(Wt::Dbo::Query<Result>& query) : _query {query} {}
 
-		std::string get() const;
+		template <typename T>
+		void operator()(const T& value) const { _query.bind(value); }
 
 	private:
-
-		std::list<std::string>	_statement;
+		Wt::Dbo::Query<Result>& _query;
 };
 
-class FromClause
-{
-	public:
-
-		FromClause() {}
-		FromClause(const std::string& clause);
-
-		FromClause& And(const FromClause& clause);
-
-		std::string get() const;
-
-	private:
-
-		std::list<std::string>	_clause;
+} // namespace Impl
 
-};
-
-class SqlQuery
+template <typename Result>
+void
+bindArgs(Wt::Dbo::Query<Result>& query, const std::vector<SqlValue>& args)
 {
-	public:
-
-		SelectStatement&	select(void)		{ return _selectStatement;}
-		SelectStatement&	select(const std::string& statement)		{ _selectStatement = SelectStatement(statement); return _selectStatement; }
-		FromClause&		from(void)		{ return _fromClause; }
-		FromClause&		from(const std::string& clause)			{ _whereClause = WhereClause(clause); return _fromClause; }
-		InnerJoinClause&	innerJoin(void)		{ return _innerJoinClause; }
-		WhereClause&		where(void)		{ return _whereClause; }
-		const WhereClause&	where(void) const	{ return _whereClause; }
-		GroupByStatement&	groupBy(void) 		{ return _groupByStatement; }
-		const GroupByStatement&	groupBy(void) const	{ return _groupByStatement; }
+	const Impl::BindVisitor<Result> visitor {query};
+	for (const SqlValue& arg : args)
+		boost::apply_visitor(visitor, arg);
+}
 
-		std::string get(void) const;
-
-	private:
-
-		SelectStatement		_selectStatement;	// SELECT statement
-		InnerJoinClause		_innerJoinClause;	// INNER JOIN
-		FromClause		_fromClause;		// FROM tables
-		WhereClause		_whereClause;		// WHERE clause
-		GroupByStatement	_groupByStatement;	// GROUP BY statement
-};
+} // namespace Database
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SwappableConnectionPool.hpp"
+
+#include "utils/Exception.hpp"
+
+namespace Database {
+
+void
+SwappableConnectionPool::swap(std::unique_ptr<Wt::Dbo::SqlConnectionPool> pool)
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	_pool = std::move(pool);
+}
+
+std::unique_ptr<Wt::Dbo::SqlConnection>
+SwappableConnectionPool::getConnection()
+{
+	std::shared_ptr<Wt::Dbo::SqlConnectionPool> pool;
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+		pool = _pool;
+	}
+
+	if (!pool)
+		throw LmsException {"No database available"};
+
+	// May wait for a connection to be returned
+	std::unique_ptr<Wt::Dbo::SqlConnection> connection {pool->getConnection()};
+
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+		_connectionPools.emplace(connection.get(), std::move(pool));
+	}
+
+	return connection;
+}
+
+void
+SwappableConnectionPool::returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection)
+{
+	std::shared_ptr<Wt::Dbo::SqlConnectionPool> pool;
+	{
+		std::unique_lock<std::mutex> lock {_mutex};
+
+		auto itPool {_connectionPools.find(connection.get())};
+		if (itPool == _connectionPools.end())
+			return;
+
+		pool = std::move(itPool->second);
+		_connectionPools.erase(itPool);
+	}
+
+	// The previous pool is released along with its connections if this was the last one in use
+	pool->returnConnection(std::move(connection));
+}
+
+void
+SwappableConnectionPool::prepareForDropTables() const
+{
+	std::unique_lock<std::mutex> lock {_mutex};
+
+	if (_pool)
+		_pool->prepareForDropTables();
+}
+
+} // namespace Database
+
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <Wt/Dbo/SqlConnection.h>
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+namespace Database {
+
+// Pool whose connections can all be switched to another database at once
+// The connections in use while switching keep working on the previous database until they are returned
+class SwappableConnectionPool : public Wt::Dbo::SqlConnectionPool
+{
+	public:
+		SwappableConnectionPool() = default;
+
+		// Thread safe
+		void swap(std::unique_ptr<Wt::Dbo::SqlConnectionPool> pool);
+
+		// Throws LmsException if no pool has been set yet
+		std::unique_ptr<Wt::Dbo::SqlConnection> getConnection() override;
+		void returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection) override;
+		void prepareForDropTables() const override;
+
+	private:
+		mutable std::mutex	_mutex;
+		std::shared_ptr<Wt::Dbo::SqlConnectionPool>	_pool;
+
+		// Pool each connection in use comes from, so that previous pools live until all their connections are returned
+		std::unordered_map<const Wt::Dbo::SqlConnection*, std::shared_ptr<Wt::Dbo::SqlConnectionPool>> _connectionPools;
+};
+
+} // namespace Database
+
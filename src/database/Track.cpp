@@ -164,37 +164,35 @@ getQuery(Wt::Dbo::Session& session,
 		const std::set<IdType>& clusterIds,
 		const std::vector<std::string> keywords)
 {
-	WhereClause where;
+	static SqlQueryCache queryCache;
 
-	std::ostringstream oss;
-	oss << "SELECT t FROM track t";
+	WhereClause where;
 
 	for (auto keyword : keywords)
 		where.And(WhereClause("t.name LIKE ?")).bind("%%" + keyword + "%%");
 
 	if (!clusterIds.empty())
-	{
-		oss << " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
+		where.And(WhereClause::in("c.id", clusterIds));
 
-		WhereClause clusterClause;
-
-		for (auto id : clusterIds)
-			clusterClause.Or(WhereClause("c.id = ?")).bind(std::to_string(id));
+	const std::string sql {queryCache.get({keywords.size(), clusterIds.size()}, [&]
+	{
+		std::string res {"SELECT t FROM track t"};
 
-		where.And(clusterClause);
-	}
+		if (!clusterIds.empty())
+			res += " INNER JOIN cluster c ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id";
 
-	oss << " " << where.get();
+		res += " " + where.get();
 
-	if (!clusterIds.empty())
-		oss << " GROUP BY t.id HAVING COUNT(*) = " << clusterIds.size();
+		if (!clusterIds.empty())
+			res += " GROUP BY t.id HAVING COUNT(*) = " + std::to_string(clusterIds.size());
 
-	oss << " ORDER BY t.name COLLATE NOCASE";
+		res += " ORDER BY t.name COLLATE NOCASE";
 
-	Wt::Dbo::Query<Track::pointer> query = session.query<Track::pointer>( oss.str() );
+		return res;
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Track::pointer> query {session.query<Track::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	return query;
 }
@@ -333,26 +331,27 @@ Track::getClusterGroups(std::vector<ClusterType::pointer> clusterTypes, std::siz
 	assert(IdIsValid(self()->id()));
 	assert(session());
 
-	WhereClause where;
+	static SqlQueryCache queryCache;
+
+	std::set<IdType> clusterTypeIds;
+	for (auto clusterType : clusterTypes)
+		clusterTypeIds.insert(clusterType.id());
 
-	std::ostringstream oss;
+	WhereClause where;
 
-	oss << "SELECT c from cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id";
+	where.And(WhereClause("t.id = ?")).bind(self()->id());
+	if (!clusterTypeIds.empty())
+		where.And(WhereClause::in("c_type.id", clusterTypeIds));
 
-	where.And(WhereClause("t.id = ?")).bind(std::to_string(self()->id()));
+	const std::string sql {queryCache.get({clusterTypeIds.size()}, [&]
 	{
-		WhereClause clusterClause;
-		for (auto clusterType : clusterTypes)
-			clusterClause.Or(WhereClause("c_type.id = ?")).bind(std::to_string(clusterType.id()));
-		where.And(clusterClause);
-	}
-	oss << " " << where.get();
-	oss << " GROUP BY c.id ORDER BY COUNT(c.id) DESC";
-
-	Wt::Dbo::Query<Cluster::pointer> query = session()->query<Cluster::pointer>( oss.str() );
+		return "SELECT c from cluster c INNER JOIN track t ON c.id = t_c.cluster_id INNER JOIN track_cluster t_c ON t_c.track_id = t.id INNER JOIN cluster_type c_type ON c.cluster_type_id = c_type.id"
+			" " + where.get() +
+			" GROUP BY c.id ORDER BY COUNT(c.id) DESC";
+	})};
 
-	for (const std::string& bindArg : where.getBindArgs())
-		query.bind(bindArg);
+	Wt::Dbo::Query<Cluster::pointer> query {session()->query<Cluster::pointer>(sql)};
+	bindArgs(query, where.getBindArgs());
 
 	Wt::Dbo::collection<Cluster::pointer> queryRes = query;
 
@@ -19,6 +19,10 @@
 
 #include "TrackFeatures.hpp"
 
+#include <cstring>
+#include <sstream>
+#include <tuple>
+
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
@@ -27,16 +31,117 @@
 
 namespace Database {
 
-TrackFeatures::TrackFeatures(Wt::Dbo::ptr<Track> track, const std::string& jsonEncodedFeatures)
+// Throws boost::property_tree::ptree_error
+static
+void
+parseFeatures(const std::string& jsonEncodedFeatures, std::map<std::string /*name*/, std::vector<double> /*values*/>& features)
+{
+	boost::property_tree::ptree root;
+
+	std::istringstream iss(jsonEncodedFeatures);
+	boost::property_tree::read_json(iss, root);
+
+	for (auto& featureNode : features)
+	{
+		auto node = root.get_child(featureNode.first);
+
+		bool hasChildren = false;
+		for (const auto& child : node.get_child(""))
+		{
+			hasChildren = true;
+			featureNode.second.push_back(child.second.get_value<double>());
+		}
+
+		if (!hasChildren)
+		{
+			featureNode.second.push_back(node.get_value<double>());
+		}
+	}
+}
+
+TrackFeatures::TrackFeatures(Wt::Dbo::ptr<Track> track, const std::vector<float>& vector, const std::string& jsonEncodedFeatures)
 : _data(jsonEncodedFeatures),
+_vector(packVector(vector)),
 _track(track)
 {
 }
 
 TrackFeatures::pointer
-TrackFeatures::create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, const std::string& jsonEncodedFeatures)
+TrackFeatures::create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, const std::vector<float>& vector, const std::string& jsonEncodedFeatures)
+{
+	return session.add(std::make_unique<TrackFeatures>(track, vector, jsonEncodedFeatures));
+}
+
+std::vector<std::pair<IdType, std::vector<float>>>
+TrackFeatures::getAllVectors(Wt::Dbo::Session& session)
+{
+	using ResultType = std::tuple<IdType, std::vector<unsigned char>>;
+	Wt::Dbo::collection<ResultType> results = session.query<ResultType>("SELECT track_id, vector FROM track_features");
+
+	std::vector<std::pair<IdType, std::vector<float>>> res;
+	for (const ResultType& result : results)
+		res.emplace_back(std::get<0>(result), unpackVector(std::get<1>(result)));
+
+	return res;
+}
+
+void
+TrackFeatures::removeAllSources(Wt::Dbo::Session& session)
+{
+	session.execute("UPDATE track_features SET data = '' WHERE LENGTH(data) > 0 AND LENGTH(vector) > 0");
+}
+
+boost::optional<std::vector<float>>
+TrackFeatures::extractVector(const std::string& jsonEncodedFeatures, const FeatureDimensions& dimensions)
+{
+	std::map<std::string, std::vector<double>> features;
+	for (const auto& dimension : dimensions)
+		features[dimension.first] = {};
+
+	try
+	{
+		parseFeatures(jsonEncodedFeatures, features);
+	}
+	catch (boost::property_tree::ptree_error& error)
+	{
+		LMS_LOG(SIMILARITY, ERROR) << "Cannot extract features: ptree exception: " << error.what();
+		return boost::none;
+	}
+
+	std::vector<float> res;
+	for (const auto& feature : features)
+	{
+		const std::size_t nbDimensions {dimensions.at(feature.first)};
+		if (feature.second.size() != nbDimensions)
+		{
+			LMS_LOG(SIMILARITY, WARNING) << "Dimension mismatch for feature '" << feature.first << "'. Expected " << nbDimensions << ", got " << feature.second.size();
+			return boost::none;
+		}
+
+		res.insert(std::end(res), std::cbegin(feature.second), std::cend(feature.second));
+	}
+
+	return res;
+}
+
+std::vector<unsigned char>
+TrackFeatures::packVector(const std::vector<float>& vector)
+{
+	std::vector<unsigned char> res(vector.size() * sizeof(float));
+	if (!vector.empty())
+		std::memcpy(res.data(), vector.data(), res.size());
+
+	return res;
+}
+
+std::vector<float>
+TrackFeatures::unpackVector(const std::vector<unsigned char>& data)
 {
-	return session.add(std::make_unique<TrackFeatures>(track, jsonEncodedFeatures));
+	std::vector<float> res(data.size() / sizeof(float));
+	if (!res.empty())
+		std::memcpy(res.data(), data.data(), res.size() * sizeof(float));
+
+	return res;
 }
 
 std::vector<double>
@@ -56,30 +161,15 @@ TrackFeatures::getFeatures(const std::string& featureNode) const
 bool
 TrackFeatures::getFeatures(std::map<std::string /*name*/, std::vector<double> /*values*/>& features) const
 {
-	try
+	if (_data.empty())
 	{
-		boost::property_tree::ptree root;
-
-		std::istringstream iss(_data);
-		boost::property_tree::read_json(iss, root);
-
-		for (auto& featureNode : features)
-		{
-			auto node = root.get_child(featureNode.first);
-
-			bool hasChildren = false;
-			for (const auto& child : node.get_child(""))
-			{
-				hasChildren = true;
-				featureNode.second.push_back(child.second.get_value<double>());
-			}
-
-			if (!hasChildren)
-			{
-				featureNode.second.push_back(node.get_value<double>());
-			}
-		}
+		LMS_LOG(SIMILARITY, ERROR) << "Track " << _track.id() << ": source features have not been kept";
+		return false;
+	}
 
+	try
+	{
+		parseFeatures(_data, features);
 		return true;
 	}
 	catch (boost::property_tree::ptree_error& error)
@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 
+#include <boost/optional.hpp>
 #include <Wt/Dbo/Dbo.h>
 
 #include "Types.hpp"
@@ -35,12 +38,32 @@ class TrackFeatures : public Wt::Dbo::Dbo<TrackFeatures>
 
 		using pointer = Wt::Dbo::ptr<TrackFeatures>;
 
+		// Feature name -> number of dimensions
+		// Packed vectors contain the features in the order of this map
+		using FeatureDimensions = std::map<std::string, std::size_t>;
+
 		TrackFeatures() = default;
-		TrackFeatures(Wt::Dbo::ptr<Track> track, const std::string& jsonEncodedFeatures);
+		TrackFeatures(Wt::Dbo::ptr<Track> track, const std::vector<float>& vector, const std::string& jsonEncodedFeatures);
 
 		// Create utility
-		static pointer create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, const std::string& jsonEncodedFeatures);
+		// jsonEncodedFeatures may be empty if the source document is not to be kept
+		static pointer create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, const std::vector<float>& vector, const std::string& jsonEncodedFeatures = "");
+
+		// Single read of all the packed vectors, with their track id
+		static std::vector<std::pair<IdType, std::vector<float>>> getAllVectors(Wt::Dbo::Session& session);
+
+		// Drop the source documents of the features that have a packed vector
+		static void removeAllSources(Wt::Dbo::Session& session);
+
+		// Extract the features from an AcousticBrainz low level document
+		static boost::optional<std::vector<float>> extractVector(const std::string& jsonEncodedFeatures, const FeatureDimensions& dimensions);
+
+		static std::vector<unsigned char> packVector(const std::vector<float>& vector);
+		static std::vector<float> unpackVector(const std::vector<unsigned char>& data);
+
+		std::vector<float> getVector() const { return unpackVector(_vector); }
 
+		// Use the source document, empty if it has not been kept
 		std::vector<double> getFeatures(const std::string& featureNode) const;
 		bool getFeatures(std::map<std::string /*featureNode*/, std::vector<double> /*values*/>& featureNodes) const;
 
@@ -48,12 +71,14 @@ class TrackFeatures : public Wt::Dbo::Dbo<TrackFeatures>
 		void persist(Action& a)
 		{
 			Wt::Dbo::field(a, _data,	"data");
+			Wt::Dbo::field(a, _vector,	"vector");
 			Wt::Dbo::belongsTo(a, _track, "track", Wt::Dbo::OnDeleteCascade);
 		}
 
 	private:
 
 		std::string _data;
+		std::vector<unsigned char> _vector;	// float32, host byte order
 		Wt::Dbo::ptr<Track> _track;
 };
 
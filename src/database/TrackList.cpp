@@ -18,6 +18,7 @@
  */
 #include "TrackList.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <random>
 
@@ -31,6 +32,44 @@
 
 namespace Database {
 
+// Stay below the default max number of bound variables
+static constexpr std::size_t maxBatchSize {256};
+
+static
+std::string
+getBatchPlaceholders(std::size_t count, const std::string& row)
+{
+	std::string res;
+	for (std::size_t i {}; i < count; ++i)
+	{
+		if (i > 0)
+			res += ", ";
+		res += row;
+	}
+
+	return res;
+}
+
+static
+long long
+getLastPosition(Wt::Dbo::Session& session, IdType tracklistId)
+{
+	return session.query<long long>("SELECT COALESCE(MAX(position), 0) FROM tracklist_entry")
+		.where("tracklist_id = ?").bind(tracklistId);
+}
+
+// Entry ids, ordered by position
+static
+std::vector<IdType>
+getEntryIds(Wt::Dbo::Session& session, IdType tracklistId)
+{
+	Wt::Dbo::collection<IdType> res = session.query<IdType>("SELECT id FROM tracklist_entry")
+		.where("tracklist_id = ?").bind(tracklistId)
+		.orderBy("position");
+
+	return std::vector<IdType>(res.begin(), res.end());
+}
+
 TrackList::TrackList(const std::string& name, Type type, bool isPublic, Wt::Dbo::ptr<User> user)
 : _name {name},
  _type {type},
@@ -60,6 +99,75 @@ TrackList::add(IdType trackId)
 	return TrackListEntry::create(*session(), Database::Track::getById(*session(), trackId), self());
 }
 
+void
+TrackList::add(const std::vector<IdType>& trackIds)
+{
+	assert(session());
+	assert(IdIsValid(self()->id()));
+
+	session()->flush();
+
+	long long position {getLastPosition(*session(), self()->id())};
+
+	for (std::size_t offset {}; offset < trackIds.size(); offset += maxBatchSize)
+	{
+		const std::size_t batchSize {std::min(maxBatchSize, trackIds.size() - offset)};
+
+		Wt::Dbo::Call call {session()->execute("WITH entry(track_id, position) AS (VALUES " + getBatchPlaceholders(batchSize, "(?, ?)") + ")"
+				" INSERT INTO tracklist_entry (version, position, track_id, tracklist_id)"
+				" SELECT 0, entry.position, entry.track_id, ? FROM entry INNER JOIN track t ON t.id = entry.track_id")};
+
+		for (std::size_t i {}; i < batchSize; ++i)
+		{
+			position += TrackListEntry::positionGap;
+			call.bind(trackIds[offset + i]).bind(position);
+		}
+		call.bind(self()->id());
+		call.run();
+	}
+}
+
+void
+TrackList::remove(const std::vector<std::size_t>& positions)
+{
+	assert(session());
+	assert(IdIsValid(self()->id()));
+
+	session()->flush();
+
+	const std::vector<IdType> entryIds {getEntryIds(*session(), self()->id())};
+
+	std::vector<IdType> entryIdsToRemove;
+	for (std::size_t position : positions)
+	{
+		if (position < entryIds.size())
+			entryIdsToRemove.push_back(entryIds[position]);
+	}
+
+	std::sort(std::begin(entryIdsToRemove), std::end(entryIdsToRemove));
+	entryIdsToRemove.erase(std::unique(std::begin(entryIdsToRemove), std::end(entryIdsToRemove)), std::end(entryIdsToRemove));
+
+	for (std::size_t offset {}; offset < entryIdsToRemove.size(); offset += maxBatchSize)
+	{
+		const std::size_t batchSize {std::min(maxBatchSize, entryIdsToRemove.size() - offset)};
+
+		Wt::Dbo::Call call {session()->execute("DELETE FROM tracklist_entry WHERE id IN (" + getBatchPlaceholders(batchSize, "?") + ")")};
+		for (std::size_t i {}; i < batchSize; ++i)
+			call.bind(entryIdsToRemove[offset + i]);
+		call.run();
+	}
+}
+
+void
+TrackList::clear()
+{
+	assert(session());
+	assert(IdIsValid(self()->id()));
+
+	session()->flush();
+	session()->execute("DELETE FROM tracklist_entry WHERE tracklist_id = ?").bind(self()->id());
+}
+
 TrackList::pointer
 TrackList::get(Wt::Dbo::Session& session, const std::string& name, Type type, Wt::Dbo::ptr<User> user)
 {
@@ -106,7 +214,7 @@ TrackList::getEntries(boost::optional<std::size_t> offset, boost::optional<std::
 	Wt::Dbo::collection<Wt::Dbo::ptr<TrackListEntry>> entries =
 		session()->find<TrackListEntry>()
 		.where("tracklist_id = ?").bind(self().id())
-		.orderBy("id")
+		.orderBy("position")
 		.limit(size ? static_cast<int>(*size) : -1)
 		.offset(offset ? static_cast<int>(*offset) : -1);
 
@@ -122,7 +230,7 @@ TrackList::getEntriesReverse(boost::optional<std::size_t> offset, boost::optiona
 	Wt::Dbo::collection<Wt::Dbo::ptr<TrackListEntry>> entries =
 		session()->find<TrackListEntry>()
 		.where("tracklist_id = ?").bind(self().id())
-		.orderBy("id DESC")
+		.orderBy("position DESC")
 		.limit(size ? static_cast<int>(*size) : -1)
 		.offset(offset ? static_cast<int>(*offset) : -1);
 
@@ -180,8 +288,9 @@ TrackList::getTrackIds() const
 	assert(session());
 	assert(IdIsValid(self()->id()));
 
-	Wt::Dbo::collection<IdType> res = session()->query<IdType>("SELECT p_e.track_id from tracklist_entry p_e INNER JOIN tracklist p ON p_e.tracklist_id = p.id")
-		.where("p.id = ?").bind(self()->id());
+	Wt::Dbo::collection<IdType> res = session()->query<IdType>("SELECT p_e.track_id from tracklist_entry p_e")
+		.where("p_e.tracklist_id = ?").bind(self()->id())
+		.orderBy("p_e.position");
 
 	return std::vector<IdType>(res.begin(), res.end());
 }
@@ -204,66 +313,22 @@ void
 TrackList::shuffle()
 {
 	assert(session());
+	assert(IdIsValid(self()->id()));
 
-	auto entries = getEntries();
+	std::vector<IdType> trackIds {getTrackIds()};
 
 	auto now = std::chrono::system_clock::now();
 	std::mt19937 randGenerator(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
 
-	std::shuffle(entries.begin(), entries.end(), randGenerator);
+	std::shuffle(trackIds.begin(), trackIds.end(), randGenerator);
 
 	clear();
-	for (auto entry : entries)
-		TrackListEntry::create(*session(), entry->getTrack(), self());
-}
-
-std::vector<Artist::pointer>
-TrackList::getTopArtists(std::size_t limit) const
-{
-	assert(session());
-	assert(IdIsValid(self()->id()));
-
-	Wt::Dbo::collection<Artist::pointer> res = session()->query<Artist::pointer>("SELECT a from artist a INNER JOIN track t ON t.id = t_a_l.track_id INNER JOIN track_artist_link t_a_l ON t_a_l.artist_id = a.id INNER JOIN tracklist_entry p_e ON p_e.track_id = t.id INNER JOIN tracklist p ON p.id = p_e.tracklist_id")
-		.where("p.id = ?").bind(self()->id())
-		.groupBy("a.id")
-		.orderBy("COUNT(a.id) DESC")
-		.limit(static_cast<int>(limit));
-
-	return std::vector<Artist::pointer>(res.begin(), res.end());
-}
-
-std::vector<Release::pointer>
-TrackList::getTopReleases(std::size_t limit) const
-{
-	assert(session());
-	assert(IdIsValid(self()->id()));
-
-	Wt::Dbo::collection<Release::pointer> res = session()->query<Release::pointer>("SELECT r from release r INNER JOIN track t ON t.release_id = r.id INNER JOIN tracklist_entry p_e ON p_e.track_id = t.id INNER JOIN tracklist p ON p.id = p_e.tracklist_id")
-		.where("p.id = ?").bind(self()->id())
-		.groupBy("r.id")
-		.orderBy("COUNT(r.id) DESC")
-		.limit(static_cast<int>(limit));
-
-	return std::vector<Release::pointer>(res.begin(), res.end());
-}
-
-std::vector<Track::pointer>
-TrackList::getTopTracks(std::size_t limit) const
-{
-	assert(session());
-	assert(IdIsValid(self()->id()));
-
-	Wt::Dbo::collection<Track::pointer> res = session()->query<Track::pointer>("SELECT t from track t INNER JOIN tracklist_entry p_e ON p_e.track_id = t.id INNER JOIN tracklist p ON p.id = p_e.tracklist_id")
-		.where("p.id = ?").bind(self()->id())
-		.groupBy("t.id")
-		.orderBy("COUNT(t.id) DESC")
-		.limit(static_cast<int>(limit));
-
-	return std::vector<Track::pointer>(res.begin(), res.end());
+	add(trackIds);
 }
 
-TrackListEntry::TrackListEntry(Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<TrackList> tracklist)
-: _track(track),
+TrackListEntry::TrackListEntry(Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<TrackList> tracklist, long long position)
+: _position(position),
+ _track(track),
  _tracklist(tracklist)
 {
 
@@ -279,7 +344,7 @@ TrackListEntry::create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, Wt:
 	assert(track);
 	assert(tracklist);
 
-	auto res = session.add( std::make_unique<TrackListEntry>( track, tracklist) );
+	auto res = session.add( std::make_unique<TrackListEntry>( track, tracklist, getLastPosition(session, tracklist.id()) + positionGap) );
 	session.flush();
 
 	return res;
@@ -50,11 +50,6 @@ class TrackList : public Wt::Dbo::Dbo<TrackList>
 		TrackList() = default;
 		TrackList(const std::string& name, Type type, bool isPublic, Wt::Dbo::ptr<User> user);
 
-		// Stats utility
-		std::vector<Wt::Dbo::ptr<Artist>> getTopArtists(std::size_t limit = 1) const;
-		std::vector<Wt::Dbo::ptr<Release>> getTopReleases(std::size_t limit = 1) const;
-		std::vector<Wt::Dbo::ptr<Track>> getTopTracks(std::size_t limit = 1) const;
-
 		// Search utility
 		static pointer	get(Wt::Dbo::Session& session, const std::string& name, Type type, Wt::Dbo::ptr<User> user);
 		static pointer	getById(Wt::Dbo::Session& session, IdType tracklistId);
@@ -74,7 +69,13 @@ class TrackList : public Wt::Dbo::Dbo<TrackList>
 		void		setName(const std::string& name) { _name = name; }
 		void		setIsPublic(bool isPublic) { _isPublic = isPublic; }
 		Wt::Dbo::ptr<TrackListEntry> add(IdType trackId);
-		void clear() { _entries.clear(); }
+
+		// Bulk operations, using multi-row statements
+		// Unknown tracks are skipped
+		void add(const std::vector<IdType>& trackIds);
+		// positions are the indexes of the entries, as given by getEntries
+		void remove(const std::vector<std::size_t>& positions);
+		void clear();
 		void shuffle();
 
 		// Get tracks, ordered by position
@@ -83,6 +84,7 @@ class TrackList : public Wt::Dbo::Dbo<TrackList>
 		std::vector<Wt::Dbo::ptr<TrackListEntry>> getEntries(boost::optional<std::size_t> offset = {}, boost::optional<std::size_t> size = {}) const;
 		std::vector<Wt::Dbo::ptr<TrackListEntry>> getEntriesReverse(boost::optional<std::size_t>  offset = {}, boost::optional<std::size_t> size = {}) const;
 
+		// Ordered by position
 		std::vector<IdType> getTrackIds() const;
 
 		std::chrono::milliseconds getDuration() const;
@@ -120,12 +122,15 @@ class TrackListEntry : public Wt::Dbo::Dbo<TrackListEntry>
 
 		using pointer = Wt::Dbo::ptr<TrackListEntry>;
 
+		// Entries are ordered by position, with gaps to allow insertions
+		static constexpr long long positionGap {1024};
+
 		TrackListEntry();
-		TrackListEntry(Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<TrackList> tracklist);
+		TrackListEntry(Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<TrackList> tracklist, long long position);
 
 		static pointer getById(Wt::Dbo::Session& session, IdType id);
 
-		// Create utility
+		// Create utility, appends the entry to the tracklist
 		static pointer create(Wt::Dbo::Session& session, Wt::Dbo::ptr<Track> track, Wt::Dbo::ptr<TrackList> tracklist);
 
 		// Accessors
@@ -134,12 +139,15 @@ class TrackListEntry : public Wt::Dbo::Dbo<TrackListEntry>
 		template<class Action>
 		void persist(Action& a)
 		{
+			Wt::Dbo::field(a,	_position, "position");
+
 			Wt::Dbo::belongsTo(a,	_track, "track", Wt::Dbo::OnDeleteCascade);
 			Wt::Dbo::belongsTo(a,	_tracklist, "tracklist", Wt::Dbo::OnDeleteCascade);
 		}
 
 	private:
 
+		long long		_position {};
 		Wt::Dbo::ptr<Track>	_track;
 		Wt::Dbo::ptr<TrackList>	_tracklist;
 };
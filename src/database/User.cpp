@@ -33,6 +33,8 @@ User::audioTranscodeAllowedBitrates =
 	320000,
 };
 
+const std::string User::playedTrackListName {"__played_tracks__"};
+
 User::User()
 : _maxAudioTranscodeBitrate{static_cast<int>(*audioTranscodeAllowedBitrates.rbegin())}
 {
@@ -94,15 +96,13 @@ User::getMaxAudioTranscodeBitrate(void) const
 Wt::Dbo::ptr<TrackList>
 User::getPlayedTrackList() const
 {
-	static const std::string listName = "__played_tracks__";
-
 	assert(self());
 	assert(IdIsValid(self()->id()));
 	assert(session());
 
-	auto res = TrackList::get(*session(), listName, TrackList::Type::Internal, self());
+	auto res = TrackList::get(*session(), playedTrackListName, TrackList::Type::Internal, self());
 	if (!res)
-		res = TrackList::create(*session(), listName, TrackList::Type::Internal, false, self());
+		res = TrackList::create(*session(), playedTrackListName, TrackList::Type::Internal, false, self());
 
 	return res;
 }
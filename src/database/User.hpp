@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include <Wt/Dbo/Dbo.h>
@@ -63,6 +64,9 @@ class User : public Wt::Dbo::Dbo<User>
 		// list of audio parameters
 		static const std::set<Bitrate> audioTranscodeAllowedBitrates;
 
+		// Name of the internal tracklist holding the play history
+		static const std::string playedTrackListName;
+
 		User();
 
 		// utility
@@ -82,6 +86,7 @@ class User : public Wt::Dbo::Dbo<User>
 		void setCurPlayingTrackPos(std::size_t pos)		{ _curPlayingTrackPos = pos; }
 		void setRadio(bool val)					{ _radio = val; }
 		void setRepeatAll(bool val)				{ _repeatAll = val; }
+		void setSubsonicApiSecret(const std::string& secret)	{ _subsonicApiSecret = secret; }
 
 		// read
 		bool			isAdmin() const { return _type == Type::ADMIN; }
@@ -93,6 +98,7 @@ class User : public Wt::Dbo::Dbo<User>
 		std::size_t		getCurPlayingTrackPos() const { return _curPlayingTrackPos; }
 		bool			isRepeatAllSet() const { return _repeatAll; }
 		bool			isRadioSet() const { return _radio; }
+		const std::string&	getSubsonicApiSecret() const { return _subsonicApiSecret; }
 
 		Wt::Dbo::ptr<TrackList> getQueuedTrackList() const;
 		Wt::Dbo::ptr<TrackList> getPlayedTrackList() const;
@@ -109,6 +115,7 @@ class User : public Wt::Dbo::Dbo<User>
 				Wt::Dbo::field(a, _curPlayingTrackPos, "cur_playing_track_pos");
 				Wt::Dbo::field(a, _repeatAll, "repeat_all");
 				Wt::Dbo::field(a, _radio, "radio");
+				Wt::Dbo::field(a, _subsonicApiSecret, "subsonic_api_secret");
 				Wt::Dbo::hasMany(a, _tracklists, Wt::Dbo::ManyToOne, "user");
 			}
 
@@ -132,6 +139,9 @@ class User : public Wt::Dbo::Dbo<User>
 		bool		_repeatAll {};
 		bool		_radio {};
 
+		// Shared with the Subsonic clients, used by the token authentication
+		std::string	_subsonicApiSecret;
+
 		Wt::Dbo::collection< Wt::Dbo::ptr<TrackList> > _tracklists;
 
 };
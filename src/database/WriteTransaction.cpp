@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WriteTransaction.hpp"
+
+#include <Wt/Dbo/Session.h>
+
+namespace Database {
+
+WriteTransaction::WriteTransaction(Wt::Dbo::Session& session)
+: _transaction {session}
+{
+	// Wt::Dbo only starts deferred transactions: a statement that writes nothing
+	// is enough to take the write lock, waiting for the other writers if needed
+	session.execute("UPDATE version_info SET db_version = db_version WHERE 0");
+}
+
+} // namespace Database
+
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Wt/Dbo/Transaction.h>
+
+namespace Database {
+
+// Transaction taking the database write lock before running anything else
+// To be used by the transactions that read before writing: a deferred transaction that has
+// already read fails at once with SQLITE_BUSY when it starts writing while another connection
+// is writing or has written meanwhile, whereas waiting for the write lock obeys the busy timeout
+class WriteTransaction
+{
+	public:
+		WriteTransaction(Wt::Dbo::Session& session);
+
+		WriteTransaction(const WriteTransaction&) = delete;
+		WriteTransaction& operator=(const WriteTransaction&) = delete;
+
+		// See Wt::Dbo::Transaction
+		bool commit() { return _transaction.commit(); }
+
+	private:
+		Wt::Dbo::Transaction _transaction;
+};
+
+} // namespace Database
+
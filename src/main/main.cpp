@@ -17,6 +17,9 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <thread>
+
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
@@ -24,15 +27,27 @@
 #include <Wt/WApplication.h>
 
 #include "api/subsonic/SubsonicResource.hpp"
+#include "api/subsonic/SubsonicResponseCache.hpp"
 #include "av/AvInfo.hpp"
+#include "av/AvTranscodeCache.hpp"
+#include "av/AvTranscodeRegistry.hpp"
+#include "av/AvTranscodeScheduler.hpp"
 #include "av/AvTranscoder.hpp"
+#include "catalog/CatalogScannerAddon.hpp"
 #include "cover/CoverArtGrabber.hpp"
+#include "database/QueryStats.hpp"
+#include "database/Snapshot.hpp"
+#include "database/SwappableConnectionPool.hpp"
 #include "image/Image.hpp"
+#include "random/RandomSampler.hpp"
 #include "scanner/MediaScanner.hpp"
+#include "scanner/SnapshotWatcher.hpp"
+#include "similarity/features/SimilarityFeaturesCache.hpp"
 #include "similarity/features/SimilarityFeaturesScannerAddon.hpp"
 #include "similarity/SimilaritySearcher.hpp"
 #include "ui/LmsApplication.hpp"
 #include "utils/Config.hpp"
+#include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
 #include "Service.hpp"
 
@@ -95,9 +110,6 @@ int main(int argc, char* argv[])
 
 	try
 	{
-		// Make pstream work with ffmpeg
-		close(STDIN_FILENO);
-
 		Config::instance().setFile(configFilePath);
 
 		// Make sure the working directory exists
@@ -120,20 +132,112 @@ int main(int argc, char* argv[])
 		// lib init
 		Image::init(argv[0]);
 		Av::AvInit();
-		Av::Transcoder::init();
+		Av::Transcoder::init(server.ioService());
 		Database::Handler::configureAuth();
 
+		Database::QueryStats& queryStats {ServiceProvider<Database::QueryStats>::create(std::chrono::milliseconds {Config::instance().getULong("db-slow-query-threshold", 500)})};
+
+		const std::string storageProfileName {Config::instance().getString("db-storage-profile", "balanced")};
+		const boost::optional<Database::StorageProfile> storageProfile {Database::getStorageProfile(storageProfileName)};
+		if (!storageProfile)
+			throw LmsException {"Invalid db-storage-profile '" + storageProfileName + "'"};
+
+		std::size_t connectionPoolSize {Config::instance().getULong("db-connection-pool-size", 0)};
+		if (connectionPoolSize == 0)
+			connectionPoolSize = std::max(std::thread::hardware_concurrency(), 1U);
+
+		const boost::filesystem::path dbFile {Config::instance().getPath("working-dir") / "lms.db"};
+		const boost::filesystem::path snapshotPublishDirectory {Config::instance().getString("snapshot-publish-dir", "")};
+		const bool readReplica {Config::instance().getBool("read-replica", false)};
+		if (readReplica && snapshotPublishDirectory.empty())
+			throw LmsException {"snapshot-publish-dir must be set in read-replica mode"};
+
 		// Initializing a connection pool to the database that will be shared along services
-		auto connectionPool = Database::Handler::createConnectionPool(Config::instance().getPath("working-dir") / "lms.db");
+		// Read replicas do not own their database, they serve the snapshots published by the primary instance
+		std::unique_ptr<Wt::Dbo::SqlConnectionPool> connectionPool;
+		Scanner::SnapshotWatcher* snapshotWatcher {};
+		if (readReplica)
+		{
+			auto swappableConnectionPool {std::make_unique<Database::SwappableConnectionPool>()};
+			snapshotWatcher = &ServiceProvider<Scanner::SnapshotWatcher>::create(*swappableConnectionPool,
+					snapshotPublishDirectory,
+					std::chrono::seconds {Config::instance().getULong("read-replica-poll-period", 60)},
+					*storageProfile,
+					&queryStats,
+					connectionPoolSize);
+			snapshotWatcher->refresh();
+			connectionPool = std::move(swappableConnectionPool);
+		}
+		else
+		{
+			connectionPool = Database::Handler::createConnectionPool(dbFile, &queryStats, *storageProfile, false, connectionPoolSize);
+			Database::Handler::prepareTables(*connectionPool);
+		}
 
 		UserInterface::LmsApplicationGroupContainer appGroups;
 
 		// Service initialization order is important
-		Scanner::MediaScanner& mediaScanner {ServiceProvider<Scanner::MediaScanner>::create(*connectionPool)};
+		Scanner::MediaScanner* mediaScanner {};
+		if (!readReplica)
+			mediaScanner = &ServiceProvider<Scanner::MediaScanner>::create(*connectionPool, std::chrono::hours {Config::instance().getULong("db-maintenance-period", 24)});
+
+		auto setScannerAddon {[&](Scanner::MediaScannerAddon& addon)
+		{
+			if (mediaScanner)
+				mediaScanner->setAddon(addon);
+			else
+				snapshotWatcher->setAddon(addon);
+		}};
 
 		Similarity::FeaturesScannerAddon similarityFeaturesScannerAddon(*connectionPool);
 
-		mediaScanner.setAddon(similarityFeaturesScannerAddon);
+		setScannerAddon(similarityFeaturesScannerAddon);
+
+		if (Config::instance().getBool("catalog-snapshot", false))
+		{
+			Catalog::ScannerAddon& catalogScannerAddon {ServiceProvider<Catalog::ScannerAddon>::create(*connectionPool)};
+			setScannerAddon(catalogScannerAddon);
+		}
+
+		Random::Sampler& randomSampler {ServiceProvider<Random::Sampler>::create(*connectionPool)};
+		setScannerAddon(randomSampler);
+
+		// Must be the last addon: invalidated once the others are up to date
+		API::Subsonic::ResponseCache& subsonicResponseCache {ServiceProvider<API::Subsonic::ResponseCache>::create(Config::instance().getULong("api-subsonic-response-cache-size", 64))};
+		setScannerAddon(subsonicResponseCache);
+
+		// Publish a snapshot for the read replicas once the features cache has been updated
+		if (mediaScanner && !snapshotPublishDirectory.empty())
+		{
+			mediaScanner->scanComplete().connect([=](Scanner::MediaScanner::Stats)
+			{
+				try
+				{
+					Database::Snapshot::publish(dbFile, {Similarity::FeaturesCache::getDirectory()}, snapshotPublishDirectory);
+				}
+				catch (std::exception& e)
+				{
+					LMS_LOG(MAIN, ERROR) << "Cannot publish snapshot: " << e.what();
+				}
+			});
+		}
+
+		{
+			std::size_t maxRunningTranscodes {Config::instance().getULong("transcode-max-running", 0)};
+			if (maxRunningTranscodes == 0)
+				maxRunningTranscodes = std::max(std::thread::hardware_concurrency(), 1U);
+
+			Av::TranscodeScheduler& transcodeScheduler {ServiceProvider<Av::TranscodeScheduler>::create(maxRunningTranscodes,
+					Config::instance().getULong("transcode-max-per-user", 2),
+					Config::instance().getULong("transcode-max-queue-size", 32))};
+
+			// in MiB
+			Av::TranscodeCache* transcodeCache {};
+			if (const std::size_t transcodeCacheSize {Config::instance().getULong("transcode-cache-size", 1024)})
+				transcodeCache = &ServiceProvider<Av::TranscodeCache>::create(Config::instance().getPath("working-dir") / "cache" / "transcode", static_cast<std::uintmax_t>(transcodeCacheSize) * 1024 * 1024);
+
+			ServiceProvider<Av::TranscodeRegistry>::create(&transcodeScheduler, transcodeCache);
+		}
 
 		CoverArt::Grabber& coverArtGrabber {ServiceProvider<CoverArt::Grabber>::create()};
 		coverArtGrabber.setDefaultCover(server.appRoot() + "/images/unknown-cover.jpg");
@@ -149,14 +253,25 @@ int main(int argc, char* argv[])
 				server.addResource(&subsonicResource, path);
 		}
 
-		// bind UI entry point
-		server.addEntryPoint(Wt::EntryPointType::Application,
-				std::bind(UserInterface::LmsApplication::create,
-					std::placeholders::_1, std::ref(*connectionPool), std::ref(appGroups)));
+		// bind UI entry point, not available on read replicas since it needs to write in the database
+		if (!readReplica)
+		{
+			server.addEntryPoint(Wt::EntryPointType::Application,
+					std::bind(UserInterface::LmsApplication::create,
+						std::placeholders::_1, std::ref(*connectionPool), std::ref(appGroups)));
+		}
 
 		// Start
-		LMS_LOG(MAIN, INFO) << "Starting media scanner...";
-		mediaScanner.start();
+		if (mediaScanner)
+		{
+			LMS_LOG(MAIN, INFO) << "Starting media scanner...";
+			mediaScanner->start();
+		}
+		else
+		{
+			LMS_LOG(MAIN, INFO) << "Starting snapshot watcher...";
+			snapshotWatcher->start();
+		}
 
 		LMS_LOG(MAIN, INFO) << "Starting server...";
 		server.start();
@@ -169,8 +284,16 @@ int main(int argc, char* argv[])
 		LMS_LOG(MAIN, INFO) << "Stopping server...";
 		server.stop();
 
-		LMS_LOG(MAIN, INFO) << "Stopping media scanner...";
-		mediaScanner.stop();
+		if (mediaScanner)
+		{
+			LMS_LOG(MAIN, INFO) << "Stopping media scanner...";
+			mediaScanner->stop();
+		}
+		else
+		{
+			LMS_LOG(MAIN, INFO) << "Stopping snapshot watcher...";
+			snapshotWatcher->stop();
+		}
 
 		LMS_LOG(MAIN, INFO) << "Clean stop!";
 		res = EXIT_SUCCESS;
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RandomSampler.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "utils/Logger.hpp"
+#include "utils/RandomPermutation.hpp"
+
+namespace Random {
+
+static
+std::vector<Database::IdType>
+getIds(Wt::Dbo::Session& session, const std::string& table)
+{
+	Wt::Dbo::collection<Database::IdType> res = session.query<Database::IdType>("SELECT id FROM " + table);
+	return std::vector<Database::IdType>(res.begin(), res.end());
+}
+
+static
+std::vector<Database::IdType>
+sample(const std::vector<Database::IdType>& ids, std::uint64_t seed, std::size_t offset, std::size_t size)
+{
+	std::vector<Database::IdType> res;
+
+	if (offset >= ids.size())
+		return res;
+
+	size = std::min(size, ids.size() - offset);
+	res.reserve(size);
+
+	const RandomPermutation permutation {ids.size(), seed};
+	for (std::size_t i {offset}; i < offset + size; ++i)
+		res.push_back(ids[permutation[i]]);
+
+	return res;
+}
+
+Sampler::Sampler(Wt::Dbo::SqlConnectionPool& connectionPool)
+: _db {connectionPool}
+{
+	refreshIds();
+}
+
+std::uint64_t
+Sampler::getSeed() const
+{
+	return std::atomic_load(&_ids)->seed;
+}
+
+std::vector<Database::IdType>
+Sampler::getTrackIds(std::uint64_t seed, std::size_t offset, std::size_t size) const
+{
+	return sample(std::atomic_load(&_ids)->tracks, seed, offset, size);
+}
+
+std::vector<Database::IdType>
+Sampler::getReleaseIds(std::uint64_t seed, std::size_t offset, std::size_t size) const
+{
+	return sample(std::atomic_load(&_ids)->releases, seed, offset, size);
+}
+
+void
+Sampler::preScanComplete()
+{
+	refreshIds();
+}
+
+void
+Sampler::databaseReplaced()
+{
+	refreshIds();
+}
+
+void
+Sampler::refreshIds()
+{
+	auto ids {std::make_shared<Ids>()};
+
+	{
+		Wt::Dbo::Transaction transaction {_db.getSession()};
+
+		ids->tracks = getIds(_db.getSession(), "track");
+		ids->releases = getIds(_db.getSession(), "release");
+	}
+
+	ids->seed = std::random_device {}();
+
+	std::atomic_store(&_ids, std::shared_ptr<const Ids> {ids});
+
+	LMS_LOG(DBUPDATER, DEBUG) << "Random sampler refreshed: " << ids->tracks.size() << " tracks, " << ids->releases.size() << " releases";
+}
+
+} // namespace Random
+
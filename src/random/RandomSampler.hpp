@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+#include "database/DatabaseHandler.hpp"
+#include "database/Types.hpp"
+#include "scanner/MediaScannerAddon.hpp"
+
+namespace Random {
+
+// Random selection of tracks and releases, in O(size) for size results
+// Keeps the dense array of the ids, reloaded each time a scan completes
+class Sampler final : public Scanner::MediaScannerAddon
+{
+	public:
+
+		Sampler(Wt::Dbo::SqlConnectionPool& connectionPool);
+
+		// Renewed each time a scan completes
+		// Paginated requests using it get a stable order until the next scan
+		std::uint64_t getSeed() const;
+
+		// Ids at [offset, offset + size) in the pseudo random order given by seed
+		std::vector<Database::IdType> getTrackIds(std::uint64_t seed, std::size_t offset, std::size_t size) const;
+		std::vector<Database::IdType> getReleaseIds(std::uint64_t seed, std::size_t offset, std::size_t size) const;
+
+	private:
+
+		void refreshSettings() override {}
+		void requestStop() override {}
+		void trackAdded(Database::IdType trackId) override {}
+		void trackToRemove(Database::IdType trackId) override {}
+		void trackUpdated(Database::IdType trackId) override {}
+		void preScanComplete() override;
+		void databaseReplaced() override;
+
+		void refreshIds();
+
+		struct Ids
+		{
+			std::vector<Database::IdType>	tracks;
+			std::vector<Database::IdType>	releases;
+			std::uint64_t			seed;
+		};
+
+		Database::Handler		_db;
+		std::shared_ptr<const Ids>	_ids;
+};
+
+} // namespace Random
+
@@ -29,9 +29,11 @@
 #include "cover/CoverArtGrabber.hpp"
 #include "database/Artist.hpp"
 #include "database/Cluster.hpp"
+#include "database/Maintenance.hpp"
 #include "database/Release.hpp"
 #include "database/ScanSettings.hpp"
 #include "database/Track.hpp"
+#include "database/WriteTransaction.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Path.hpp"
 #include "utils/Utils.hpp"
@@ -193,8 +195,10 @@ getOrCreateClusters(Wt::Dbo::Session& session, const MetaData::Clusters& cluster
 
 namespace Scanner {
 
-MediaScanner::MediaScanner(Wt::Dbo::SqlConnectionPool& connectionPool)
-: _db {connectionPool}
+MediaScanner::MediaScanner(Wt::Dbo::SqlConnectionPool& connectionPool, std::chrono::hours maintenancePeriod)
+: _maintenancePeriod {maintenancePeriod},
+_connectionPool {connectionPool},
+_db {connectionPool}
 {
 	_ioService.setThreadCount(1);
 
@@ -220,6 +224,7 @@ MediaScanner::start(void)
 	_running = true;
 
 	scheduleNextScan();
+	scheduleMaintenance();
 
 	_ioService.start();
 }
@@ -233,6 +238,7 @@ MediaScanner::stop(void)
 		addon->requestStop();
 
 	_scheduleTimer.cancel();
+	_maintenanceTimer.cancel();
 
 	_ioService.stop();
 }
@@ -431,6 +437,9 @@ MediaScanner::scan(boost::system::error_code err)
 		scheduleNextScan();
 
 		scanComplete().emit(stats);
+
+		if (stats.nbChanges() > 0)
+			runMaintenance();
 	}
 	else
 	{
@@ -440,6 +449,33 @@ MediaScanner::scan(boost::system::error_code err)
 	}
 }
 
+void
+MediaScanner::scheduleMaintenance()
+{
+	if (_maintenancePeriod.count() == 0)
+		return;
+
+	_maintenanceTimer.expires_from_now(_maintenancePeriod);
+	_maintenanceTimer.async_wait([=](boost::system::error_code ec)
+	{
+		if (ec)
+			return;
+
+		runMaintenance();
+	});
+}
+
+void
+MediaScanner::runMaintenance()
+{
+	LMS_LOG(DBUPDATER, INFO) << "Running database maintenance...";
+
+	Database::Maintenance::run(_connectionPool);
+
+	// Restart the period from now, a maintenance just occurred
+	scheduleMaintenance();
+}
+
 void
 MediaScanner::refreshScanSettings()
 {
@@ -515,7 +551,7 @@ MediaScanner::scanAudioFile(const boost::filesystem::path& file, bool forceScan,
 	std::vector<unsigned char> checksum ;
 	computeCrc(file, checksum);
 
-	Wt::Dbo::Transaction transaction {_db.getSession()};
+	Database::WriteTransaction transaction {_db.getSession()};
 
 	Wt::Dbo::ptr<Track> track {Track::getByPath(_db.getSession(), file) };
 
@@ -726,7 +762,7 @@ MediaScanner::removeMissingTracks(Stats& stats)
 
 		if (!checkFile(trackPath, _mediaDirectory, _fileExtensions))
 		{
-			Wt::Dbo::Transaction transaction(_db.getSession());
+			Database::WriteTransaction transaction(_db.getSession());
 
 			Track::pointer track = Track::getByPath(_db.getSession(), trackPath);
 			if (track)
@@ -743,7 +779,7 @@ MediaScanner::removeOrphanEntries()
 {
 	LMS_LOG(DBUPDATER, DEBUG) << "Checking orphan clusters...";
 	{
-		Wt::Dbo::Transaction transaction(_db.getSession());
+		Database::WriteTransaction transaction(_db.getSession());
 
 		// Now process orphan Cluster (no track)
 		auto clusters = Cluster::getAllOrphans(_db.getSession());
@@ -756,7 +792,7 @@ MediaScanner::removeOrphanEntries()
 
 	LMS_LOG(DBUPDATER, DEBUG) << "Checking orphan artists...";
 	{
-		Wt::Dbo::Transaction transaction(_db.getSession());
+		Database::WriteTransaction transaction(_db.getSession());
 
 		auto artists = Artist::getAllOrphans(_db.getSession());
 		for (auto artist : artists)
@@ -768,7 +804,7 @@ MediaScanner::removeOrphanEntries()
 
 	LMS_LOG(DBUPDATER, DEBUG) << "Checking orphan releases...";
 	{
-		Wt::Dbo::Transaction transaction(_db.getSession());
+		Database::WriteTransaction transaction(_db.getSession());
 
 		auto releases = Release::getAllOrphans(_db.getSession());
 		for (auto release : releases)
@@ -26,6 +26,7 @@
 #include <Wt/WIOService.h>
 #include <Wt/WSignal.h>
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/system_timer.hpp>
 
 #include "database/ScanSettings.hpp"
@@ -39,7 +40,8 @@ namespace Scanner {
 class MediaScanner
 {
 	public:
-		MediaScanner(Wt::Dbo::SqlConnectionPool& connectionPool);
+		// Database maintenance is run after each scan and every maintenancePeriod, 0 to only run it after scans
+		MediaScanner(Wt::Dbo::SqlConnectionPool& connectionPool, std::chrono::hours maintenancePeriod = {});
 
 		void setAddon(MediaScannerAddon& addon);
 
@@ -110,6 +112,10 @@ class MediaScanner
 		// Update database (scheduled callback)
 		void scan(boost::system::error_code ec);
 
+		// Shares the scan thread, so that it never runs during a scan
+		void scheduleMaintenance();
+		void runMaintenance();
+
 		void scanMediaDirectory( boost::filesystem::path mediaDirectory, bool forceScan, Stats& stats);
 
 		// Helpers
@@ -125,6 +131,9 @@ class MediaScanner
 		bool			_running {false};
 		Wt::WIOService		_ioService;
 		boost::asio::system_timer _scheduleTimer {_ioService};
+		boost::asio::steady_timer _maintenanceTimer {_ioService};
+		const std::chrono::hours _maintenancePeriod;
+		Wt::Dbo::SqlConnectionPool& _connectionPool;
 		Wt::Signal<Stats>	_sigScanComplete;
 		Wt::Signal<Stats>	_sigScanInProgress;
 		std::chrono::system_clock::time_point _lastScanInProgressEmit {};
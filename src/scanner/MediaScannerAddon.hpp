@@ -34,6 +34,9 @@ class MediaScannerAddon
 		virtual void trackToRemove(Database::IdType trackId) = 0;
 		virtual void trackUpdated(Database::IdType trackId) = 0;
 		virtual void preScanComplete() = 0;
+
+		// The whole database has been replaced by another one, no scan involved
+		virtual void databaseReplaced() = 0;
 };
 
 } // ns Scanner
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotWatcher.hpp"
+
+#include <algorithm>
+
+#include "database/DatabaseHandler.hpp"
+#include "database/Snapshot.hpp"
+#include "similarity/features/SimilarityFeaturesCache.hpp"
+#include "utils/Config.hpp"
+#include "utils/Exception.hpp"
+#include "utils/Logger.hpp"
+
+namespace Scanner {
+
+SnapshotWatcher::SnapshotWatcher(Database::SwappableConnectionPool& connectionPool,
+		const boost::filesystem::path& publishDirectory,
+		std::chrono::seconds pollPeriod,
+		Database::StorageProfile storageProfile,
+		Database::QueryStats* queryStats,
+		std::size_t connectionPoolSize)
+: _connectionPool {connectionPool},
+_publishDirectory {publishDirectory},
+_replicaDirectory {Config::instance().getPath("working-dir") / "replica"},
+_pollPeriod {pollPeriod},
+_storageProfile {storageProfile},
+_queryStats {queryStats},
+_connectionPoolSize {connectionPoolSize}
+{
+	_ioService.setThreadCount(1);
+}
+
+void
+SnapshotWatcher::setAddon(MediaScannerAddon& addon)
+{
+	_addons.push_back(&addon);
+}
+
+void
+SnapshotWatcher::refresh()
+{
+	const boost::optional<std::string> snapshotId {Database::Snapshot::getPublishedId(_publishDirectory)};
+	if (!snapshotId)
+	{
+		if (_currentSnapshotId.empty())
+			throw LmsException {"No snapshot published in '" + _publishDirectory.string() + "'"};
+
+		return;
+	}
+
+	if (*snapshotId == _currentSnapshotId)
+		return;
+
+	LMS_LOG(DBUPDATER, INFO) << "New snapshot '" << *snapshotId << "' published";
+
+	const boost::filesystem::path replicaFile {getReplicaFile(*snapshotId)};
+	Database::Snapshot::install(_publishDirectory / *snapshotId, replicaFile, {Similarity::FeaturesCache::getDirectory()});
+
+	// Our own copy, so that it can be migrated if it comes from an older version
+	Database::Handler::prepareTables(*Database::Handler::createConnectionPool(replicaFile, nullptr, _storageProfile));
+
+	_connectionPool.swap(Database::Handler::createConnectionPool(replicaFile, _queryStats, _storageProfile, true, _connectionPoolSize));
+
+	_previousSnapshotId = _currentSnapshotId;
+	_currentSnapshotId = *snapshotId;
+
+	for (MediaScannerAddon* addon : _addons)
+		addon->databaseReplaced();
+
+	removeOldReplicaFiles();
+
+	LMS_LOG(DBUPDATER, INFO) << "Now serving snapshot '" << _currentSnapshotId << "'";
+}
+
+void
+SnapshotWatcher::start()
+{
+	schedulePoll();
+
+	_ioService.start();
+}
+
+void
+SnapshotWatcher::stop()
+{
+	_pollTimer.cancel();
+
+	_ioService.stop();
+}
+
+void
+SnapshotWatcher::schedulePoll()
+{
+	_pollTimer.expires_from_now(_pollPeriod);
+	_pollTimer.async_wait([=](boost::system::error_code ec)
+	{
+		if (ec)
+			return;
+
+		try
+		{
+			refresh();
+		}
+		catch (std::exception& e)
+		{
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot use snapshot: " << e.what();
+		}
+
+		schedulePoll();
+	});
+}
+
+boost::filesystem::path
+SnapshotWatcher::getReplicaFile(const std::string& snapshotId) const
+{
+	return _replicaDirectory / (snapshotId + ".db");
+}
+
+void
+SnapshotWatcher::removeOldReplicaFiles()
+{
+	// The previous one may still be in use by the requests in progress
+	std::vector<boost::filesystem::path> keptFiles {getReplicaFile(_currentSnapshotId)};
+	if (!_previousSnapshotId.empty())
+		keptFiles.push_back(getReplicaFile(_previousSnapshotId));
+
+	for (const boost::filesystem::directory_entry& entry : boost::filesystem::directory_iterator {_replicaDirectory})
+	{
+		const bool kept {std::any_of(std::cbegin(keptFiles), std::cend(keptFiles), [&](const boost::filesystem::path& keptFile)
+		{
+			return entry.path().string().compare(0, keptFile.string().size(), keptFile.string()) == 0;
+		})};
+
+		if (kept)
+			continue;
+
+		boost::system::error_code ec;
+		boost::filesystem::remove(entry.path(), ec);
+		if (ec)
+			LMS_LOG(DBUPDATER, ERROR) << "Cannot remove '" << entry.path().string() << "': " << ec.message();
+	}
+}
+
+} // namespace Scanner
+
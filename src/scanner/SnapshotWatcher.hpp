@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/filesystem.hpp>
+#include <Wt/WIOService.h>
+
+#include "database/Connection.hpp"
+#include "database/SwappableConnectionPool.hpp"
+
+#include "MediaScannerAddon.hpp"
+
+namespace Database {
+	class QueryStats;
+}
+
+namespace Scanner {
+
+// Read replica: serves the snapshots published by a primary instance instead of scanning
+// Each new snapshot is copied locally, then the pool is switched to it and the addons are notified
+class SnapshotWatcher
+{
+	public:
+		SnapshotWatcher(Database::SwappableConnectionPool& connectionPool,
+				const boost::filesystem::path& publishDirectory,
+				std::chrono::seconds pollPeriod,
+				Database::StorageProfile storageProfile,
+				Database::QueryStats* queryStats,
+				std::size_t connectionPoolSize);
+
+		void setAddon(MediaScannerAddon& addon);
+
+		// Switch to the last published snapshot, if not already done
+		// Throws LmsException if no snapshot can be used
+		void refresh();
+
+		// Periodically refresh
+		void start();
+		void stop();
+
+	private:
+		void schedulePoll();
+
+		boost::filesystem::path getReplicaFile(const std::string& snapshotId) const;
+		void removeOldReplicaFiles();
+
+		Database::SwappableConnectionPool&	_connectionPool;
+		const boost::filesystem::path		_publishDirectory;
+		const boost::filesystem::path		_replicaDirectory;
+		const std::chrono::seconds		_pollPeriod;
+		const Database::StorageProfile		_storageProfile;
+		Database::QueryStats*			_queryStats;
+		const std::size_t			_connectionPoolSize;
+
+		Wt::WIOService				_ioService;
+		boost::asio::steady_timer		_pollTimer {_ioService};
+		std::vector<MediaScannerAddon*>		_addons;
+
+		std::string				_currentSnapshotId;
+		std::string				_previousSnapshotId;
+};
+
+} // namespace Scanner
+
@@ -22,7 +22,9 @@
 #include "features/SimilarityFeaturesScannerAddon.hpp"
 #include "cluster/SimilarityClusterSearcher.hpp"
 
+#include "catalog/CatalogScannerAddon.hpp"
 #include "database/SimilaritySettings.hpp"
+#include "main/Service.hpp"
 
 namespace Similarity {
 
@@ -37,6 +39,13 @@ Database::SimilaritySettings::EngineType getEngineType(Wt::Dbo::Session& session
 	return Database::SimilaritySettings::get(session)->getEngineType();
 }
 
+static
+std::shared_ptr<const Catalog::Snapshot> getCatalogSnapshot()
+{
+	Catalog::ScannerAddon* catalog {getService<Catalog::ScannerAddon>()};
+	return catalog ? catalog->getSnapshot() : nullptr;
+}
+
 std::vector<Database::IdType>
 Searcher::getSimilarTracks(Wt::Dbo::Session& session, const std::set<Database::IdType>& trackIds, std::size_t maxCount)
 {
@@ -50,6 +59,8 @@ Searcher::getSimilarTracks(Wt::Dbo::Session& session, const std::set<Database::I
 	{
 		return somSearcher->getSimilarTracks(trackIds, maxCount);
 	}
+	else if (auto snapshot = getCatalogSnapshot())
+		return ClusterSearcher::getSimilarTracks(*snapshot, trackIds, maxCount);
 	else
 		return ClusterSearcher::getSimilarTracks(session, trackIds, maxCount);
 }
@@ -66,6 +77,8 @@ Searcher::getSimilarReleases(Wt::Dbo::Session& session, Database::IdType release
 	{
 		return somSearcher->getSimilarReleases(releaseId, maxCount);
 	}
+	else if (auto snapshot = getCatalogSnapshot())
+		return ClusterSearcher::getSimilarReleases(*snapshot, releaseId, maxCount);
 	else
 		return ClusterSearcher::getSimilarReleases(session, releaseId, maxCount);
 }
@@ -82,6 +95,8 @@ Searcher::getSimilarArtists(Wt::Dbo::Session& session, Database::IdType artistId
 	{
 		return somSearcher->getSimilarArtists(artistId, maxCount);
 	}
+	else if (auto snapshot = getCatalogSnapshot())
+		return ClusterSearcher::getSimilarArtists(*snapshot, artistId, maxCount);
 	else
 		return ClusterSearcher::getSimilarArtists(session, artistId, maxCount);
 }
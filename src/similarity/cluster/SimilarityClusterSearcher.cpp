@@ -22,6 +22,7 @@
 #include <random>
 #include <chrono>
 
+#include "catalog/CatalogSnapshot.hpp"
 #include "database/Artist.hpp"
 #include "database/Cluster.hpp"
 #include "database/Release.hpp"
@@ -171,5 +172,113 @@ getSimilarArtists(Wt::Dbo::Session& session, Database::IdType artistId, std::siz
 	return res;
 }
 
+std::vector<Database::IdType>
+getSimilarTracks(const Catalog::Snapshot& snapshot, const std::set<Database::IdType>& trackIds, std::size_t maxCount)
+{
+	std::vector<Database::IdType> res;
+
+	std::vector<Database::IdType> clusterIds;
+	for (auto trackId : trackIds)
+	{
+		const Catalog::Snapshot::Track* track {snapshot.getTrack(trackId)};
+		if (!track)
+			continue;
+
+		for (auto clusterId : snapshot.getClusterIds(*track))
+			clusterIds.push_back(clusterId);
+	}
+
+	for (auto clusterId : clusterIds)
+	{
+		const Catalog::Snapshot::Cluster* cluster {snapshot.getCluster(clusterId)};
+		if (!cluster)
+			continue;
+
+		// Cluster track ids are sorted
+		for (auto trackId : snapshot.getTrackIds(*cluster))
+		{
+			if (res.size() >= maxCount)
+				break;
+
+			if (trackIds.find(trackId) == trackIds.end())
+				res.push_back(trackId);
+		}
+
+		if (res.size() >= maxCount)
+			break;
+	}
+
+	return res;
+}
+
+std::vector<Database::IdType>
+getSimilarReleases(const Catalog::Snapshot& snapshot, Database::IdType releaseId, std::size_t maxCount)
+{
+	std::vector<Database::IdType> res;
+
+	const Catalog::Snapshot::Release* release {snapshot.getRelease(releaseId)};
+	if (!release)
+		return res;
+
+	const Catalog::Snapshot::IdRange releaseTrackIds {snapshot.getTrackIds(*release)};
+	auto trackIds = getSimilarTracks(snapshot, std::set<Database::IdType>(releaseTrackIds.begin(), releaseTrackIds.end()), maxCount * 5);
+
+	for (auto trackId : trackIds)
+	{
+		const Catalog::Snapshot::Track* track {snapshot.getTrack(trackId)};
+		if (!track)
+			continue;
+
+		if (!Database::IdIsValid(track->releaseId) || track->releaseId == releaseId)
+			continue;
+
+		if (std::find(res.begin(), res.end(), track->releaseId) != res.end())
+			continue;
+
+		res.push_back(track->releaseId);
+
+		if (res.size() == maxCount)
+			break;
+	}
+
+	return res;
+}
+
+std::vector<Database::IdType>
+getSimilarArtists(const Catalog::Snapshot& snapshot, Database::IdType artistId, std::size_t maxCount)
+{
+	std::vector<Database::IdType> res;
+
+	const Catalog::Snapshot::Artist* artist {snapshot.getArtist(artistId)};
+	if (!artist)
+		return res;
+
+	const Catalog::Snapshot::IdRange artistTrackIds {snapshot.getTrackIds(*artist)};
+	auto trackIds = getSimilarTracks(snapshot, std::set<Database::IdType>(artistTrackIds.begin(), artistTrackIds.end()), maxCount * 5);
+
+	for (auto trackId : trackIds)
+	{
+		const Catalog::Snapshot::Track* track {snapshot.getTrack(trackId)};
+		if (!track)
+			continue;
+
+		for (auto trackArtistId : snapshot.getArtistIds(*track))
+		{
+			if (trackArtistId == artistId)
+				continue;
+
+			if (std::find(res.begin(), res.end(), trackArtistId) != res.end())
+				continue;
+
+			res.push_back(trackArtistId);
+		}
+
+		if (res.size() == maxCount)
+			break;
+	}
+
+	return res;
+}
+
 } // namespace ClusterSearcher
 } // namespace Similarity
@@ -23,6 +23,10 @@
 
 #include "database/Types.hpp"
 
+namespace Catalog {
+	class Snapshot;
+}
+
 namespace Similarity {
 
 namespace ClusterSearcher
@@ -30,6 +34,11 @@ namespace ClusterSearcher
 	std::vector<Database::IdType> getSimilarTracks(Wt::Dbo::Session& session, const std::set<Database::IdType>& tracksId, std::size_t maxCount);
 	std::vector<Database::IdType> getSimilarReleases(Wt::Dbo::Session& session, Database::IdType releaseId, std::size_t maxCount);
 	std::vector<Database::IdType> getSimilarArtists(Wt::Dbo::Session& session, Database::IdType artistId, std::size_t maxCount);
+
+	// Same as above, using the catalog snapshot instead of the database
+	std::vector<Database::IdType> getSimilarTracks(const Catalog::Snapshot& snapshot, const std::set<Database::IdType>& tracksId, std::size_t maxCount);
+	std::vector<Database::IdType> getSimilarReleases(const Catalog::Snapshot& snapshot, Database::IdType releaseId, std::size_t maxCount);
+	std::vector<Database::IdType> getSimilarArtists(const Catalog::Snapshot& snapshot, Database::IdType artistId, std::size_t maxCount);
 };
 
 } // namespace Similarity
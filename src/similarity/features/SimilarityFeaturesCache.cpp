@@ -28,21 +28,14 @@
 
 namespace Similarity {
 
-
-static
-boost::filesystem::path getCacheDirectory()
-{
-	return Config::instance().getPath("working-dir") / "cache" / "features";
-}
-
 static boost::filesystem::path getCacheNetworkFilePath()
 {
-	return getCacheDirectory() / "network";
+	return FeaturesCache::getDirectory() / "network";
 };
 
 static boost::filesystem::path getCacheTrackPositionsFilePath()
 {
-	return getCacheDirectory() / "track_positions";
+	return FeaturesCache::getDirectory() / "track_positions";
 }
 
 static
@@ -209,6 +202,12 @@ createObjectPositionsFromCacheFile(boost::filesystem::path path)
 	}
 }
 
+boost::filesystem::path
+FeaturesCache::getDirectory()
+{
+	return Config::instance().getPath("working-dir") / "cache" / "features";
+}
+
 void
 FeaturesCache::invalidate()
 {
@@ -235,7 +234,7 @@ FeaturesCache::read()
 void
 FeaturesCache::write()
 {
-	boost::filesystem::create_directories(Config::instance().getPath("working-dir") / "cache" / "features");
+	boost::filesystem::create_directories(getDirectory());
 
 	if (!networkToCacheFile(_network, getCacheNetworkFilePath())
 		|| !objectPositionToCacheFile(_trackPositions, getCacheTrackPositionsFilePath()))
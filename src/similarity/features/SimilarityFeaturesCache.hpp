@@ -22,6 +22,8 @@
 #include <map>
 #include <set>
 
+#include <boost/filesystem.hpp>
+
 #include "database/Types.hpp"
 #include "som/Network.hpp"
 
@@ -31,6 +33,7 @@ class FeaturesCache
 {
 	public:
 
+		static boost::filesystem::path getDirectory();
 		static void invalidate();
 
 		static boost::optional<FeaturesCache> read();
@@ -54,15 +54,10 @@ getTracksWithMBIDAndMissingFeatures(Wt::Dbo::Session& session)
 } // namespace
 
 FeaturesScannerAddon::FeaturesScannerAddon(Wt::Dbo::SqlConnectionPool& connectionPool)
-: _db(connectionPool)
+: _db(connectionPool),
+_keepSourceFeatures {Config::instance().getBool("similarity-features-keep-source", false)}
 {
-	boost::optional<Similarity::FeaturesCache> cache {Similarity::FeaturesCache::read()};
-	if (cache)
-	{
-		auto searcher {std::make_shared<Similarity::FeaturesSearcher>(_db.getSession(), *cache)};
-		if (searcher->isValid())
-			std::atomic_store(&_searcher, searcher);
-	}
+	loadSearcherFromCache();
 }
 
 std::shared_ptr<Similarity::FeaturesSearcher>
@@ -102,17 +97,50 @@ FeaturesScannerAddon::preScanComplete()
 		}
 	}
 
+	Database::TrackFeatures::FeatureDimensions dimensions;
+	{
+		Wt::Dbo::Transaction transaction {_db.getSession()};
+
+		dimensions = Database::SimilaritySettings::get(_db.getSession())->getFeatureDimensions();
+
+		if (!_keepSourceFeatures)
+			Database::TrackFeatures::removeAllSources(_db.getSession());
+	}
+
 	LMS_LOG(DBUPDATER, DEBUG) << "Getting tracks with missing Features...";
 	std::vector<TrackInfo> tracksInfo {getTracksWithMBIDAndMissingFeatures(_db.getSession())};
 	LMS_LOG(DBUPDATER, DEBUG) << "Getting tracks with missing Features DONE (found " << tracksInfo.size() << ")";
 
 	for (const TrackInfo& trackInfo : tracksInfo)
-		fetchFeatures(trackInfo.id, trackInfo.mbid);
+		fetchFeatures(trackInfo.id, trackInfo.mbid, dimensions);
 
 	Similarity::FeaturesCache::invalidate();
 	updateSearcher();
 }
 
+void
+FeaturesScannerAddon::databaseReplaced()
+{
+	// The cache comes along with the database, only rebuild the searcher if it is missing
+	if (!loadSearcherFromCache())
+		updateSearcher();
+}
+
+bool
+FeaturesScannerAddon::loadSearcherFromCache()
+{
+	boost::optional<Similarity::FeaturesCache> cache {Similarity::FeaturesCache::read()};
+	if (!cache)
+		return false;
+
+	auto searcher {std::make_shared<Similarity::FeaturesSearcher>(_db.getSession(), *cache)};
+	if (!searcher->isValid())
+		return false;
+
+	std::atomic_store(&_searcher, searcher);
+	return true;
+}
+
 void
 FeaturesScannerAddon::updateSearcher()
 {
@@ -142,10 +170,8 @@ FeaturesScannerAddon::updateSearcher()
 }
 
 bool
-FeaturesScannerAddon::fetchFeatures(Database::IdType trackId, const std::string& MBID)
+FeaturesScannerAddon::fetchFeatures(Database::IdType trackId, const std::string& MBID, const Database::TrackFeatures::FeatureDimensions& dimensions)
 {
-	std::map<std::string, double> features;
-
 	LMS_LOG(DBUPDATER, DEBUG) << "Fetching low level features for track '" << MBID << "'";
 	std::string data {AcousticBrainz::extractLowLevelFeatures(MBID)};
 	if (data.empty())
@@ -154,6 +180,13 @@ FeaturesScannerAddon::fetchFeatures(Database::IdType trackId, const std::string&
 		return false;
 	}
 
+	const boost::optional<std::vector<float>> vector {Database::TrackFeatures::extractVector(data, dimensions)};
+	if (!vector)
+	{
+		LMS_LOG(DBUPDATER, ERROR) << "Cannot extract the configured features from the AcousticBrainz document of track '" << MBID << "'";
+		return false;
+	}
+
 	Wt::Dbo::Transaction transaction{_db.getSession()};
 
 	Wt::Dbo::ptr<Database::Track> track {Database::Track::getById(_db.getSession(), trackId)};
@@ -162,7 +195,7 @@ FeaturesScannerAddon::fetchFeatures(Database::IdType trackId, const std::string&
 
 	LMS_LOG(DBUPDATER, DEBUG) << "Successfully extracted AcousticBrainz lowlevel features for track '" << track->getPath().string() << "'";
 
-	Database::TrackFeatures::create(_db.getSession(), track, data);
+	Database::TrackFeatures::create(_db.getSession(), track, *vector, _keepSourceFeatures ? data : "");
 
 	return true;
 }
@@ -22,6 +22,7 @@
 #include <Wt/Dbo/SqlConnectionPool.h>
 
 #include "database/DatabaseHandler.hpp"
+#include "database/TrackFeatures.hpp"
 #include "scanner/MediaScannerAddon.hpp"
 
 #include "SimilarityFeaturesSearcher.hpp"
@@ -44,12 +45,15 @@ class FeaturesScannerAddon final : public Scanner::MediaScannerAddon
 		void trackToRemove(Database::IdType trackId) override {}
 		void trackUpdated(Database::IdType trackId) override;
 		void preScanComplete() override;
+		void databaseReplaced() override;
 
-		bool fetchFeatures(Database::IdType trackId, const std::string& MBID);
+		bool fetchFeatures(Database::IdType trackId, const std::string& MBID, const Database::TrackFeatures::FeatureDimensions& dimensions);
 
+		bool loadSearcherFromCache();
 		void updateSearcher();
 
 		Database::Handler			_db;
+		const bool				_keepSourceFeatures;
 		std::shared_ptr<FeaturesSearcher>	_searcher;
 		bool					_stopRequested{false};
 };
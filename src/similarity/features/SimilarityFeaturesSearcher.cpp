@@ -66,44 +66,6 @@ getFeatureInfoMapNbDimensions(const FeatureInfoMap& featureInfoMap)
 	return std::accumulate(featureInfoMap.begin(), featureInfoMap.end(), 0, [](std::size_t sum, auto it) { return sum + it.second.nbDimensions; });
 }
 
-static
-boost::optional<SOM::InputVector>
-getInputVectorFromTrack(Wt::Dbo::Session& session, Database::IdType trackId, const FeatureInfoMap& featuresInfo, std::size_t nbDimensions)
-{
-	boost::optional<SOM::InputVector> res {SOM::InputVector {nbDimensions}};
-
-	std::map<std::string, std::vector<double>> features;
-	for (auto itFeatureInfo : featuresInfo)
-		features[itFeatureInfo.first] = {};
-
-	Wt::Dbo::Transaction transaction {session};
-
-	Database::Track::pointer track {Database::Track::getById(session, trackId)};
-	if (!track)
-		return res;
-
-	if (!track->getTrackFeatures()->getFeatures(features))
-		return res;
-
-	std::size_t i {};
-	for (const auto& feature : features)
-	{
-		// Check dimensions for each feature
-		auto it {featuresInfo.find(feature.first)};
-		if (it == featuresInfo.end() || it->second.nbDimensions != feature.second.size())
-		{
-			LMS_LOG(SIMILARITY, WARNING) << "Dimension mismatch for feature '" << feature.first << "'. Expected " << it->second.nbDimensions << ", got " << feature.second.size();
-			res.reset();
-			break;
-		}
-
-		for (double val : feature.second)
-			(*res)[i++] = val;
-	}
-
-	return res;
-}
-
 static
 SOM::InputVector
 getInputVectorWeights(const FeatureInfoMap& featuresInfo, std::size_t nbDimensions)
@@ -128,32 +90,41 @@ FeaturesSearcher::FeaturesSearcher(Wt::Dbo::Session& session, bool& stopRequeste
 
 	LMS_LOG(SIMILARITY, DEBUG) << "Features dimension = " << nbDimensions;
 
-	LMS_LOG(SIMILARITY, DEBUG) << "Getting Tracks with features...";
-	std::vector<Database::IdType> trackIds {Database::Track::getAllIdsWithFeatures(session)};
-	LMS_LOG(SIMILARITY, DEBUG) << "Getting Tracks with features DONE";
+	LMS_LOG(SIMILARITY, DEBUG) << "Getting features...";
+	const std::vector<std::pair<Database::IdType, std::vector<float>>> trackVectors {Database::TrackFeatures::getAllVectors(session)};
+	LMS_LOG(SIMILARITY, DEBUG) << "Getting features DONE (found " << trackVectors.size() << ")";
 
 	transaction.commit();
 
+	if (stopRequested)
+		return;
+
 	std::vector<SOM::InputVector> samples;
 	std::vector<Database::IdType> samplesTrackIds;
 
-	samples.reserve(trackIds.size());
-	samplesTrackIds.reserve(trackIds.size());
+	samples.reserve(trackVectors.size());
+	samplesTrackIds.reserve(trackVectors.size());
 
-	LMS_LOG(SIMILARITY, DEBUG) << "Extracting features...";
-	for (Database::IdType trackId : trackIds)
+	std::size_t nbMismatches {};
+	for (const auto& trackVector : trackVectors)
 	{
-		if (stopRequested)
-			return;
-
-		boost::optional<SOM::InputVector> inputVector {getInputVectorFromTrack(session, trackId, featuresInfo, nbDimensions)};
-		if (!inputVector)
+		const std::vector<float>& vector {trackVector.second};
+		if (vector.size() != nbDimensions)
+		{
+			nbMismatches++;
 			continue;
+		}
+
+		SOM::InputVector inputVector {nbDimensions};
+		for (std::size_t i {}; i < nbDimensions; ++i)
+			inputVector[i] = vector[i];
 
-		samples.emplace_back(std::move(*inputVector));
-		samplesTrackIds.emplace_back(trackId);
+		samples.emplace_back(std::move(inputVector));
+		samplesTrackIds.emplace_back(trackVector.first);
 	}
-	LMS_LOG(SIMILARITY, DEBUG) << "Extracting features DONE";
+
+	if (nbMismatches > 0)
+		LMS_LOG(SIMILARITY, WARNING) << "Skipped " << nbMismatches << " tracks: features do not have the expected dimension " << nbDimensions;
 
 	if (samples.empty())
 	{
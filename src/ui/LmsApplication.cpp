@@ -37,11 +37,14 @@
 #include "database/Release.hpp"
 #include "explore/Explore.hpp"
 #include "main/Service.hpp"
+#include "utils/Config.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Utils.hpp"
 
 #include "admin/InitWizardView.hpp"
 #include "admin/DatabaseSettingsView.hpp"
+#include "admin/QueryStatsView.hpp"
+#include "admin/TranscodeStatsView.hpp"
 #include "admin/UserView.hpp"
 #include "admin/UsersView.hpp"
 #include "resource/ImageResource.hpp"
@@ -71,6 +74,7 @@ LmsApplication::LmsApplication(const Wt::WEnvironment& env,
 		LmsApplicationGroupContainer& appGroups)
 : Wt::WApplication(env),
   _db(connectionPool),
+  _userStateBuffer(_db, std::chrono::seconds(Config::instance().getULong("user-state-flush-period", 30)), Config::instance().getULong("play-history-max-entries", 0)),
   _appGroups(appGroups)
 {
 	auto  bootstrapTheme = std::make_unique<Wt::WBootstrapTheme>();
@@ -88,6 +92,8 @@ LmsApplication::LmsApplication(const Wt::WEnvironment& env,
 	messageResourceBundle().use(appRoot() + "admin-user");
 	messageResourceBundle().use(appRoot() + "admin-users");
 	messageResourceBundle().use(appRoot() + "admin-initwizard");
+	messageResourceBundle().use(appRoot() + "admin-querystats");
+	messageResourceBundle().use(appRoot() + "admin-transcodestats");
 	messageResourceBundle().use(appRoot() + "artist");
 	messageResourceBundle().use(appRoot() + "artistinfo");
 	messageResourceBundle().use(appRoot() + "artistlink");
@@ -149,6 +155,8 @@ LmsApplication::finalize()
 
 	getApplicationGroup().leave();
 
+	_userStateBuffer.flush();
+
 	preQuit().emit();
 }
 
@@ -233,6 +241,8 @@ enum IdxRoot
 	IdxAdminDatabase,
 	IdxAdminUsers,
 	IdxAdminUser,
+	IdxAdminQueryStats,
+	IdxAdminTranscodeStats,
 };
 
 static void
@@ -256,6 +266,8 @@ handlePathChange(Wt::WStackedWidget* stack, bool isAdmin)
 		{ "/admin/database",	IdxAdminDatabase,	true },
 		{ "/admin/users",	IdxAdminUsers,		true },
 		{ "/admin/user",	IdxAdminUser,		true },
+		{ "/admin/querystats",	IdxAdminQueryStats,	true },
+		{ "/admin/transcodestats",	IdxAdminTranscodeStats,	true },
 	};
 
 	LMS_LOG(UI, DEBUG) << "Internal path changed to '" << wApp->internalPath() << "'";
@@ -382,6 +394,14 @@ LmsApplication::createHome()
 		usersSettings->setLink(Wt::WLink(Wt::LinkType::InternalPath, "/admin/users"));
 		usersSettings->setSelectable(false);
 
+		auto queryStats = admin->insertItem(2, Wt::WString::tr("Lms.Admin.QueryStats.query-stats"));
+		queryStats->setLink(Wt::WLink(Wt::LinkType::InternalPath, "/admin/querystats"));
+		queryStats->setSelectable(false);
+
+		auto transcodeStats = admin->insertItem(3, Wt::WString::tr("Lms.Admin.TranscodeStats.transcode-stats"));
+		transcodeStats->setLink(Wt::WLink(Wt::LinkType::InternalPath, "/admin/transcodestats"));
+		transcodeStats->setSelectable(false);
+
 		menuItem->setMenu(std::move(admin));
 	}
 
@@ -415,6 +435,8 @@ LmsApplication::createHome()
 		mainStack->addNew<DatabaseSettingsView>();
 		mainStack->addNew<UsersView>();
 		mainStack->addNew<UserView>();
+		mainStack->addNew<QueryStatsView>();
+		mainStack->addNew<TranscodeStatsView>();
 	}
 
 	explore->tracksAdd.connect([=] (std::vector<Database::Track::pointer> tracks)
@@ -30,6 +30,7 @@
 
 #include "LmsApplicationGroup.hpp"
 #include "Auth.hpp"
+#include "UserStateBuffer.hpp"
 
 namespace Database {
 	class Artist;
@@ -88,6 +89,7 @@ class LmsApplication : public Wt::WApplication
 		const Wt::Auth::User& getAuthUser() { return _db.getLogin().user(); }
 		Database::User::pointer getUser() { return _db.getCurrentUser(); }
 		Wt::WString getUserIdentity() { return _userIdentity; }
+		UserStateBuffer& getUserStateBuffer() { return _userStateBuffer; }
 
 		Events& getEvents() { return _events; }
 
@@ -120,6 +122,7 @@ class LmsApplication : public Wt::WApplication
 
 		Wt::Signal<>		_preQuit;
 		Database::Handler	_db;
+		UserStateBuffer		_userStateBuffer;
 		LmsApplicationGroupContainer&   _appGroups;
 		Events			_events;
 		Wt::WString		_userIdentity;
@@ -86,10 +86,13 @@ PlayHistory::PlayHistory()
 
 	LmsApp->getEvents().trackLoaded.connect([=](Database::IdType trackId, bool /* play */)
 	{
+		LmsApp->getUserStateBuffer().addPlayedTrack(trackId);
+
 		Wt::Dbo::Transaction transaction (LmsApp->getDboSession());
 
-		auto trackEntry = LmsApp->getUser()->getPlayedTrackList().modify()->add(trackId);
-		_entriesContainer->insertWidget(0, createEntry(trackEntry->getTrack()));
+		auto track = Database::Track::getById(LmsApp->getDboSession(), trackId);
+		if (track)
+			_entriesContainer->insertWidget(0, createEntry(track));
 	});
 
 	addSome();
@@ -98,6 +101,9 @@ PlayHistory::PlayHistory()
 void
 PlayHistory::addSome()
 {
+	// Displayed entries must all be written to get the next ones
+	LmsApp->getUserStateBuffer().flush();
+
 	Wt::Dbo::Transaction transaction (LmsApp->getDboSession());
 
 	auto trackList = LmsApp->getUser()->getPlayedTrackList();
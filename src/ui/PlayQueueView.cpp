@@ -22,6 +22,7 @@
 #include <Wt/WText.h>
 
 #include "database/TrackList.hpp"
+#include "database/WriteTransaction.hpp"
 #include "main/Service.hpp"
 #include "similarity/SimilaritySearcher.hpp"
 #include "utils/Logger.hpp"
@@ -62,7 +63,7 @@ PlayQueue::PlayQueue()
 	shuffleBtn->clicked().connect([=]
 	{
 		{
-			Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+			Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 			getTrackList().modify()->shuffle();
 		}
@@ -80,7 +81,7 @@ PlayQueue::PlayQueue()
 		Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
 
 		if (!LmsApp->getUser()->isDemo())
-			LmsApp->getUser().modify()->setRepeatAll(_repeatAll);
+			LmsApp->getUserStateBuffer().setRepeatAll(_repeatAll);
 	});
 	updateRepeatBtn();
 
@@ -94,7 +95,7 @@ PlayQueue::PlayQueue()
 		Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
 
 		if (!LmsApp->getUser()->isDemo())
-			LmsApp->getUser().modify()->setRadio(_radioMode);
+			LmsApp->getUserStateBuffer().setRadio(_radioMode);
 	});
 	updateRadioBtn();
 
@@ -106,7 +107,7 @@ PlayQueue::PlayQueue()
 		{
 			LMS_LOG(UI, DEBUG) << "Removing tracklist id " << *_tracklistId;
 
-			Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+			Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 			auto tracklist = Database::TrackList::getById(LmsApp->getDboSession(), *_tracklistId);
 			if (tracklist)
@@ -168,7 +169,7 @@ PlayQueue::getTrackList()
 void
 PlayQueue::clearTracks()
 {
-	Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+	Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 	getTrackList().modify()->clear();
 	_showMore->setHidden(true);
@@ -219,7 +220,7 @@ PlayQueue::load(std::size_t pos, bool play)
 		updateCurrentTrack(true);
 
 		if (!LmsApp->getUser()->isDemo())
-			LmsApp->getUser().modify()->setCurPlayingTrackPos(pos);
+			LmsApp->getUserStateBuffer().setCurPlayingTrackPos(pos);
 	}
 
 	loadTrack.emit(trackId, play);
@@ -252,7 +253,7 @@ PlayQueue::playNext()
 void
 PlayQueue::updateInfo()
 {
-	Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+	Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 	_nbTracks->setText(Wt::WString::tr("Lms.PlayQueue.nb-tracks").arg(static_cast<unsigned>(getTrackList()->getCount())));
 }
@@ -281,8 +282,11 @@ PlayQueue::enqueueTracks(const std::vector<Database::Track::pointer>& tracks)
 
 	auto tracklist = getTrackList();
 
+	std::vector<Database::IdType> trackIds;
 	for (auto track : tracks)
-		Database::TrackListEntry::create(LmsApp->getDboSession(), track, tracklist);
+		trackIds.push_back(track.id());
+
+	tracklist.modify()->add(trackIds);
 
 	updateInfo();
 	addSome();
@@ -367,7 +371,7 @@ PlayQueue::addSome()
 		{
 			// Remove the entry n both the widget tree and the playqueue
 			{
-				Wt::Dbo::Transaction transaction (LmsApp->getDboSession());
+				Database::WriteTransaction transaction (LmsApp->getDboSession());
 
 				auto entryToRemove = Database::TrackListEntry::getById(LmsApp->getDboSession(), tracklistEntryId);
 				entryToRemove.remove();
@@ -24,12 +24,14 @@
 #include <Wt/WCheckBox.h>
 #include <Wt/WComboBox.h>
 #include <Wt/WLineEdit.h>
+#include <Wt/WRandom.h>
 
 #include <Wt/WFormModel.h>
 
 #include "common/Validators.hpp"
 #include "common/ValueStringModel.hpp"
 
+#include "database/WriteTransaction.hpp"
 #include "utils/Logger.hpp"
 #include "LmsApplication.hpp"
 
@@ -69,7 +71,7 @@ class SettingsModel : public Wt::WFormModel
 
 		void saveData()
 		{
-			Wt::Dbo::Transaction transaction {LmsApp->getDboSession()};
+			Database::WriteTransaction transaction {LmsApp->getDboSession()};
 
 			LmsApp->getUser().modify()->setAudioTranscodeEnable(Wt::asNumber(value(TranscodeEnableField)));
 
@@ -211,6 +213,32 @@ SettingsView::refreshView()
 	passwordConfirm->setEchoMode(Wt::EchoMode::Password);
 	t->setFormWidget(SettingsModel::PasswordConfirmField, std::move(passwordConfirm));
 
+	// Subsonic API secret, not part of the model: generated on demand
+	Wt::WLineEdit* subsonicApiSecret {t->bindWidget("subsonic-api-secret", std::make_unique<Wt::WLineEdit>())};
+	subsonicApiSecret->setReadOnly(true);
+	{
+		Wt::Dbo::Transaction transaction {LmsApp->getDboSession()};
+		subsonicApiSecret->setText(Wt::WString::fromUTF8(LmsApp->getUser()->getSubsonicApiSecret()));
+	}
+
+	Wt::WPushButton* subsonicApiSecretBtn {t->bindWidget("subsonic-api-secret-btn", std::make_unique<Wt::WPushButton>(Wt::WString::tr("Lms.Settings.subsonic-api-secret-generate")))};
+	subsonicApiSecretBtn->clicked().connect([=]
+	{
+		Database::WriteTransaction transaction {LmsApp->getDboSession()};
+
+		if (LmsApp->getUser()->isDemo())
+		{
+			LmsApp->notifyMsg(MsgType::Warning, Wt::WString::tr("Lms.Settings.demo-cannot-save"));
+			return;
+		}
+
+		const std::string secret {Wt::WRandom::generateId(32)};
+		LmsApp->getUser().modify()->setSubsonicApiSecret(secret);
+		subsonicApiSecret->setText(Wt::WString::fromUTF8(secret));
+
+		LmsApp->notifyMsg(MsgType::Success, Wt::WString::tr("Lms.Settings.subsonic-api-secret-generated"));
+	});
+
 	// Transcoding
 	auto transcode {std::make_unique<Wt::WCheckBox>()};
 	auto* transcodeRaw {transcode.get()};
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UserStateBuffer.hpp"
+
+#include "database/PlayStats.hpp"
+#include "database/Track.hpp"
+#include "database/TrackList.hpp"
+#include "database/User.hpp"
+#include "database/WriteTransaction.hpp"
+#include "utils/Logger.hpp"
+
+namespace UserInterface {
+
+UserStateBuffer::UserStateBuffer(Database::Handler& db, std::chrono::seconds flushPeriod, std::size_t maxHistoryEntries)
+: _db {db},
+_flushPeriod {flushPeriod},
+_maxHistoryEntries {maxHistoryEntries}
+{
+	if (_flushPeriod.count() > 0)
+	{
+		_timer = std::make_unique<Wt::WTimer>();
+		_timer->setSingleShot(true);
+		_timer->setInterval(_flushPeriod);
+		_timer->timeout().connect([=]
+		{
+			flush();
+		});
+	}
+}
+
+UserStateBuffer::~UserStateBuffer()
+{
+	if (!flush())
+		LMS_LOG(UI, ERROR) << "Discarding user state updates";
+}
+
+void
+UserStateBuffer::setCurPlayingTrackPos(std::size_t pos)
+{
+	prepareUpdate();
+	_curPlayingTrackPos = pos;
+	scheduleFlush();
+}
+
+void
+UserStateBuffer::setRepeatAll(bool repeatAll)
+{
+	prepareUpdate();
+	_repeatAll = repeatAll;
+	scheduleFlush();
+}
+
+void
+UserStateBuffer::setRadio(bool radio)
+{
+	prepareUpdate();
+	_radio = radio;
+	scheduleFlush();
+}
+
+void
+UserStateBuffer::addPlayedTrack(Database::IdType trackId)
+{
+	prepareUpdate();
+	_playedTracks.push_back({trackId, Wt::WDateTime::currentDateTime()});
+	scheduleFlush();
+}
+
+void
+UserStateBuffer::prepareUpdate()
+{
+	Database::IdType userId;
+	{
+		Wt::Dbo::Transaction transaction {_db.getSession()};
+		userId = _db.getCurrentUser().id();
+	}
+
+	if (_userId && *_userId != userId && !flush())
+	{
+		LMS_LOG(UI, ERROR) << "Discarding state updates of user " << *_userId;
+		clear();
+	}
+
+	_userId = userId;
+}
+
+void
+UserStateBuffer::scheduleFlush()
+{
+	if (!_timer)
+	{
+		flush();
+		return;
+	}
+
+	// Do not postpone the pending updates
+	if (!_timer->isActive())
+		_timer->start();
+}
+
+bool
+UserStateBuffer::flush()
+{
+	if (_timer)
+		_timer->stop();
+
+	if (!_userId)
+		return true;
+
+	// The buffer is only cleared once the updates are committed
+	try
+	{
+		write();
+	}
+	catch (std::exception& e)
+	{
+		LMS_LOG(UI, ERROR) << "Cannot write user state: " << e.what();
+
+		if (_timer)
+			_timer->start();
+
+		return false;
+	}
+
+	clear();
+
+	return true;
+}
+
+void
+UserStateBuffer::write()
+{
+	const Database::IdType userId {*_userId};
+
+	Wt::Dbo::Session& session {_db.getSession()};
+	Database::WriteTransaction transaction {session};
+
+	Database::User::pointer user {Database::User::getById(session, userId)};
+	if (!user)
+	{
+		LMS_LOG(UI, DEBUG) << "User " << userId << " removed, discarding state updates";
+		return;
+	}
+
+	if (_curPlayingTrackPos)
+		user.modify()->setCurPlayingTrackPos(*_curPlayingTrackPos);
+	if (_repeatAll)
+		user.modify()->setRepeatAll(*_repeatAll);
+	if (_radio)
+		user.modify()->setRadio(*_radio);
+
+	if (!_playedTracks.empty())
+	{
+		Database::TrackList::pointer history {user->getPlayedTrackList()};
+
+		std::vector<Database::IdType> trackIds;
+		for (const PlayedTrack& playedTrack : _playedTracks)
+		{
+			Database::Track::pointer track {Database::Track::getById(session, playedTrack.trackId)};
+			if (!track)
+				continue;
+
+			trackIds.push_back(playedTrack.trackId);
+			Database::PlayStats::addPlay(session, user, track, playedTrack.time);
+		}
+		history.modify()->add(trackIds);
+
+		if (_maxHistoryEntries > 0)
+			Database::PlayStats::compactHistory(session, history, _maxHistoryEntries);
+
+		LMS_LOG(UI, DEBUG) << "Writing " << _playedTracks.size() << " played tracks for user " << userId;
+	}
+
+	// Throws if the commit fails, the destructor would only log it
+	transaction.commit();
+}
+
+void
+UserStateBuffer::clear()
+{
+	_userId.reset();
+	_curPlayingTrackPos.reset();
+	_repeatAll.reset();
+	_radio.reset();
+	_playedTracks.clear();
+}
+
+} // namespace UserInterface
+
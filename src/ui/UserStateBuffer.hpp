@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <Wt/WDateTime.h>
+#include <Wt/WTimer.h>
+
+#include "database/DatabaseHandler.hpp"
+#include "database/Types.hpp"
+
+namespace UserInterface {
+
+// Coalesces the frequent updates of the user state (play queue position, play
+// modes, play history) and writes them in a single transaction
+// Pending updates are written once flushPeriod has elapsed since the first one,
+// when flush() is called or when the buffer is destroyed
+// A zero flushPeriod writes each update immediately
+class UserStateBuffer
+{
+	public:
+		UserStateBuffer(Database::Handler& db, std::chrono::seconds flushPeriod, std::size_t maxHistoryEntries);
+		~UserStateBuffer();
+
+		UserStateBuffer(const UserStateBuffer&) = delete;
+		UserStateBuffer& operator=(const UserStateBuffer&) = delete;
+
+		// Must be called with the user logged in
+		void setCurPlayingTrackPos(std::size_t pos);
+		void setRepeatAll(bool repeatAll);
+		void setRadio(bool radio);
+		void addPlayedTrack(Database::IdType trackId);
+
+		// Pending updates are kept for the next flush if they cannot be written
+		bool flush();
+
+	private:
+		// Updates are bound to a single user, pending ones are written on user change
+		void prepareUpdate();
+		void scheduleFlush();
+		void write();
+		void clear();
+
+		struct PlayedTrack
+		{
+			Database::IdType	trackId;
+			Wt::WDateTime		time;
+		};
+
+		Database::Handler&		_db;
+		const std::chrono::seconds	_flushPeriod;
+		const std::size_t		_maxHistoryEntries;
+		std::unique_ptr<Wt::WTimer>	_timer;
+
+		boost::optional<Database::IdType>	_userId;
+		boost::optional<std::size_t>		_curPlayingTrackPos;
+		boost::optional<bool>			_repeatAll;
+		boost::optional<bool>			_radio;
+		std::vector<PlayedTrack>		_playedTracks;
+};
+
+} // namespace UserInterface
+
@@ -32,6 +32,7 @@
 
 #include "database/Cluster.hpp"
 #include "database/SimilaritySettings.hpp"
+#include "database/WriteTransaction.hpp"
 #include "main/Service.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Utils.hpp"
@@ -115,7 +116,7 @@ class DatabaseSettingsModel : public Wt::WFormModel
 
 		void saveData()
 		{
-			Wt::Dbo::Transaction transaction {LmsApp->getDboSession()};
+			Database::WriteTransaction transaction {LmsApp->getDboSession()};
 
 			auto scanSettings {ScanSettings::get(LmsApp->getDboSession())};
 			auto similaritySettings {SimilaritySettings::get(LmsApp->getDboSession())};
@@ -24,6 +24,7 @@
 #include <Wt/WPushButton.h>
 #include <Wt/Auth/Identity.h>
 
+#include "database/WriteTransaction.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
 
@@ -54,7 +55,7 @@ class InitWizardModel : public Wt::WFormModel
 
 		void saveData()
 		{
-			Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+			Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 			// Check if a user already exist
 			// If it's the case, just do nothing
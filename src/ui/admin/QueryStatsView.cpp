@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "QueryStatsView.hpp"
+
+#include <Wt/WPushButton.h>
+#include <Wt/WText.h>
+
+#include "database/QueryStats.hpp"
+#include "main/Service.hpp"
+
+#include "LmsApplication.hpp"
+
+namespace UserInterface {
+
+static
+Wt::WString
+toMilliseconds(std::chrono::microseconds duration)
+{
+	return Wt::WString {"{1}"}.arg(duration.count() / 1000.);
+}
+
+QueryStatsView::QueryStatsView()
+ : Wt::WTemplate(Wt::WString::tr("Lms.Admin.QueryStats.template"))
+{
+	addFunction("tr", &Wt::WTemplate::Functions::tr);
+
+	_statementCache = bindNew<Wt::WText>("statement-cache");
+	_table = bindNew<Wt::WTable>("entries");
+	_table->setHeaderCount(1);
+
+	Wt::WPushButton* refreshBtn = bindNew<Wt::WPushButton>("refresh-btn", Wt::WString::tr("Lms.Admin.QueryStats.refresh"));
+	refreshBtn->clicked().connect(std::bind([=]
+	{
+		refreshView();
+	}));
+
+	Wt::WPushButton* resetBtn = bindNew<Wt::WPushButton>("reset-btn", Wt::WString::tr("Lms.Admin.QueryStats.reset"));
+	resetBtn->clicked().connect(std::bind([=]
+	{
+		if (Database::QueryStats* queryStats = getService<Database::QueryStats>())
+			queryStats->clear();
+
+		refreshView();
+	}));
+
+	wApp->internalPathChanged().connect(std::bind([=]
+	{
+		refreshView();
+	}));
+
+	refreshView();
+}
+
+void
+QueryStatsView::refreshView()
+{
+	if (!wApp->internalPathMatches("/admin/querystats"))
+		return;
+
+	_table->clear();
+	_statementCache->setText("");
+
+	Database::QueryStats* queryStats {getService<Database::QueryStats>()};
+	if (!queryStats)
+	{
+		_table->elementAt(0, 0)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.not-available"));
+		return;
+	}
+
+	const Database::QueryStats::StatementCacheStats statementCacheStats {queryStats->getStatementCacheStats()};
+	const std::size_t lookups {statementCacheStats.hits + statementCacheStats.misses};
+	_statementCache->setText(Wt::WString::tr("Lms.Admin.QueryStats.statement-cache")
+			.arg(statementCacheStats.hits)
+			.arg(statementCacheStats.misses)
+			.arg(lookups ? (statementCacheStats.hits * 100) / lookups : 0));
+
+	_table->elementAt(0, 0)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.query"));
+	_table->elementAt(0, 1)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.count"));
+	_table->elementAt(0, 2)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.total"));
+	_table->elementAt(0, 3)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.p50"));
+	_table->elementAt(0, 4)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.p99"));
+	_table->elementAt(0, 5)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.QueryStats.rows"));
+
+	int row {1};
+	for (const Database::QueryStats::Entry& entry : queryStats->getEntries())
+	{
+		_table->elementAt(row, 0)->addNew<Wt::WText>(Wt::WString::fromUTF8(entry.query), Wt::TextFormat::Plain);
+		_table->elementAt(row, 1)->addNew<Wt::WText>(std::to_string(entry.count));
+		_table->elementAt(row, 2)->addNew<Wt::WText>(toMilliseconds(entry.total));
+		_table->elementAt(row, 3)->addNew<Wt::WText>(toMilliseconds(entry.p50));
+		_table->elementAt(row, 4)->addNew<Wt::WText>(toMilliseconds(entry.p99));
+		_table->elementAt(row, 5)->addNew<Wt::WText>(std::to_string(entry.rows));
+		++row;
+	}
+}
+
+} // namespace UserInterface
+
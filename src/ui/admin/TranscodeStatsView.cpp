@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TranscodeStatsView.hpp"
+
+#include <Wt/WPushButton.h>
+#include <Wt/WText.h>
+
+#include "av/AvTranscodeCache.hpp"
+#include "av/AvTranscodeRegistry.hpp"
+#include "av/AvTranscodeScheduler.hpp"
+#include "main/Service.hpp"
+
+#include "LmsApplication.hpp"
+
+namespace UserInterface {
+
+TranscodeStatsView::TranscodeStatsView()
+ : Wt::WTemplate(Wt::WString::tr("Lms.Admin.TranscodeStats.template"))
+{
+	addFunction("tr", &Wt::WTemplate::Functions::tr);
+
+	_table = bindNew<Wt::WTable>("entries");
+
+	Wt::WPushButton* refreshBtn = bindNew<Wt::WPushButton>("refresh-btn", Wt::WString::tr("Lms.Admin.TranscodeStats.refresh"));
+	refreshBtn->clicked().connect(std::bind([=]
+	{
+		refreshView();
+	}));
+
+	wApp->internalPathChanged().connect(std::bind([=]
+	{
+		refreshView();
+	}));
+
+	refreshView();
+}
+
+void
+TranscodeStatsView::refreshView()
+{
+	if (!wApp->internalPathMatches("/admin/transcodestats"))
+		return;
+
+	_table->clear();
+
+	Av::TranscodeScheduler* scheduler {getService<Av::TranscodeScheduler>()};
+	if (!scheduler)
+	{
+		_table->elementAt(0, 0)->addNew<Wt::WText>(Wt::WString::tr("Lms.Admin.TranscodeStats.not-available"));
+		return;
+	}
+
+	const Av::TranscodeScheduler::Stats stats {scheduler->getStats()};
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.running"), std::to_string(stats.running));
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.queued"), std::to_string(stats.queued));
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.admitted"), std::to_string(stats.admitted));
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.rejected"), std::to_string(stats.rejected));
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.average-wait"), std::to_string(stats.averageWait.count()));
+	addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.max-wait"), std::to_string(stats.maxWait.count()));
+
+	if (Av::TranscodeRegistry* registry {getService<Av::TranscodeRegistry>()})
+	{
+		const Av::TranscodeRegistry::Stats registryStats {registry->getStats()};
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.in-progress"), std::to_string(registryStats.inProgress));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.started"), std::to_string(registryStats.started));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.joined"), std::to_string(registryStats.joined));
+	}
+
+	if (Av::TranscodeCache* cache {getService<Av::TranscodeCache>()})
+	{
+		const Av::TranscodeCache::Stats cacheStats {cache->getStats()};
+		const std::size_t lookups {cacheStats.hits + cacheStats.misses};
+
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-hits"), std::to_string(cacheStats.hits));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-misses"), std::to_string(cacheStats.misses));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-hit-ratio"), std::to_string(lookups > 0 ? (cacheStats.hits * 100) / lookups : 0));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-entries"), std::to_string(cacheStats.entries));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-size"), std::to_string(cacheStats.size / (1024 * 1024)) + " / " + std::to_string(cacheStats.maxSize / (1024 * 1024)));
+		addEntry(Wt::WString::tr("Lms.Admin.TranscodeStats.cache-evictions"), std::to_string(cacheStats.evictions));
+	}
+}
+
+void
+TranscodeStatsView::addEntry(const Wt::WString& name, const Wt::WString& value)
+{
+	const int row {_table->rowCount()};
+
+	_table->elementAt(row, 0)->addNew<Wt::WText>(name);
+	_table->elementAt(row, 1)->addNew<Wt::WText>(value);
+}
+
+} // namespace UserInterface
+
@@ -29,6 +29,7 @@
 #include <Wt/WFormModel.h>
 
 #include "database/User.hpp"
+#include "database/WriteTransaction.hpp"
 #include "utils/Config.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Logger.hpp"
@@ -78,7 +79,7 @@ class UserModel : public Wt::WFormModel
 
 		void saveData()
 		{
-			Wt::Dbo::Transaction transaction {LmsApp->getDboSession()};
+			Database::WriteTransaction transaction {LmsApp->getDboSession()};
 
 			if (_userId)
 			{
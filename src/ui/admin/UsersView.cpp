@@ -24,6 +24,7 @@
 #include <Wt/WTemplate.h>
 
 #include "database/User.hpp"
+#include "database/WriteTransaction.hpp"
 #include "utils/Logger.hpp"
 
 #include "LmsApplication.hpp"
@@ -106,7 +107,7 @@ UsersView::refreshView()
 			{
 				if (btn == Wt::StandardButton::Yes)
 				{
-					Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
+					Database::WriteTransaction transaction(LmsApp->getDboSession());
 
 					auto authUser = LmsApp->getDb().getUserDatabase().findWithId(userId);
 					auto user = LmsApp->getDb().getUser(authUser);
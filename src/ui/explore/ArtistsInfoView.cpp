@@ -22,7 +22,7 @@
 #include <Wt/WLocalDateTime.h>
 
 #include "database/Artist.hpp"
-#include "database/TrackList.hpp"
+#include "database/PlayStats.hpp"
 #include "utils/Utils.hpp"
 #include "ArtistLink.hpp"
 #include "LmsApplication.hpp"
@@ -70,7 +70,7 @@ void
 ArtistsInfo::refreshMostPlayed()
 {
 	Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
-	auto artists = LmsApp->getUser()->getPlayedTrackList()->getTopArtists(5);
+	auto artists = Database::PlayStats::getTopArtists(LmsApp->getDboSession(), LmsApp->getUser(), 5);
 
 	_mostPlayedContainer->clear();
 	for (auto artist : artists)
@@ -22,7 +22,7 @@
 #include <Wt/WLocalDateTime.h>
 
 #include "database/Release.hpp"
-#include "database/TrackList.hpp"
+#include "database/PlayStats.hpp"
 #include "resource/ImageResource.hpp"
 #include "ReleaseLink.hpp"
 #include "LmsApplication.hpp"
@@ -72,7 +72,7 @@ ReleasesInfo::refreshMostPlayed()
 {
 	Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
 
-	auto releases = LmsApp->getUser()->getPlayedTrackList()->getTopReleases(5);
+	auto releases = Database::PlayStats::getTopReleases(LmsApp->getDboSession(), LmsApp->getUser(), 5);
 
 	_mostPlayedContainer->clear();
 	for (auto release : releases)
@@ -22,8 +22,8 @@
 #include <Wt/WAnchor.h>
 #include <Wt/WLocalDateTime.h>
 
+#include "database/PlayStats.hpp"
 #include "database/Track.hpp"
-#include "database/TrackList.hpp"
 
 #include "utils/Utils.hpp"
 
@@ -87,7 +87,7 @@ void
 TracksInfo::refreshMostPlayed()
 {
 	Wt::Dbo::Transaction transaction(LmsApp->getDboSession());
-	auto tracks = LmsApp->getUser()->getPlayedTrackList()->getTopTracks(5);
+	auto tracks = Database::PlayStats::getTopTracks(LmsApp->getDboSession(), LmsApp->getUser(), 5);
 
 	_mostPlayedContainer->clear();
 	addEntries(_mostPlayedContainer, tracks);
@@ -21,6 +21,10 @@
 
 #include <Wt/Http/Response.h>
 
+#include "av/AvTranscodeCache.hpp"
+#include "av/AvTranscodeRegistry.hpp"
+#include "av/AvTranscodeResourceHandler.hpp"
+#include "main/Service.hpp"
 #include "utils/Logger.hpp"
 
 #include "database/Track.hpp"
@@ -47,17 +51,20 @@ void
 AudioResource::handleRequest(const Wt::Http::Request& request,
 		Wt::Http::Response& response)
 {
-	std::shared_ptr<Av::Transcoder> transcoder;
+	std::shared_ptr<ResourceHandler> resourceHandler;
 
 	// First, see if this request is for a continuation
 	Wt::Http::ResponseContinuation *continuation = request.continuation();
 	if (continuation)
 	{
 		LMS_LOG(UI, DEBUG) << "Continuation! " << continuation ;
-		transcoder = Wt::cpp17::any_cast<std::shared_ptr<Av::Transcoder>>(continuation->data());
+		resourceHandler = Wt::cpp17::any_cast<std::shared_ptr<ResourceHandler>>(continuation->data());
 	}
 	else
 	{
+		boost::filesystem::path trackPath;
+		std::vector<unsigned char> trackChecksum;
+		std::string userName;
 		Database::IdType trackId;
 		Av::TranscodeParameters parameters {};
 		parameters.stripMetadata = true;
@@ -122,47 +129,28 @@ AudioResource::handleRequest(const Wt::Http::Request& request,
 			else
 				parameters.bitrate = 0;
 
-			transcoder = std::make_shared<Av::Transcoder>(track->getPath(), parameters);
+			trackPath = track->getPath();
+			trackChecksum = track->getChecksum();
+			userName = LmsApp->getUserIdentity().toUTF8();
 		}
 
-
-		if (!transcoder->start())
+		Av::TranscodeRegistry* registry {getService<Av::TranscodeRegistry>()};
+		if (!registry)
 		{
-			LMS_LOG(UI, ERROR) << "Cannot start transcoder";
+			response.setStatus(500);
 			return;
 		}
 
-		LMS_LOG(UI, DEBUG) << "Transcoder started";
-
-		std::string mimeType {transcoder->getOutputMimeType()};
-		response.setMimeType(mimeType);
-		LMS_LOG(UI, DEBUG) << "Mime type set to '" << mimeType << "'";
-
-	}
-
-	if (!transcoder->isComplete())
-	{
-		std::vector<unsigned char> data;
-		data.reserve(_chunkSize);
-
-		transcoder->process(data, _chunkSize);
-
-		response.out().write(reinterpret_cast<char*>(&data[0]), data.size());
-		LMS_LOG(UI, DEBUG) << "Written " << data.size() << " bytes! complete = " << (transcoder->isComplete() ? "true" : "false");
-
-		if (!response.out())
+		// The web player only requests the track being played
+		resourceHandler = Av::createTranscodeResourceHandler(*registry, getService<Av::TranscodeCache>(), trackPath, trackChecksum, parameters, userName, Av::TranscodeScheduler::Priority::Playing);
+		if (!resourceHandler)
 		{
-			LMS_LOG(UI, ERROR) << "Write failed!";
+			response.setStatus(503);
+			return;
 		}
 	}
 
-	if (!transcoder->isComplete() && response.out())
-	{
-		continuation = response.createContinuation();
-		continuation->setData(transcoder);
-	}
-	else
-		LMS_LOG(UI, DEBUG) << "No more data!";
+	resourceHandler->processRequest(request, response);
 }
 
 } // namespace UserInterface
@@ -38,10 +38,6 @@ class AudioResource : public Wt::WResource
 
 		void handleRequest(const Wt::Http::Request& request,
 				Wt::Http::Response& response);
-
-	private:
-
-		static const std::size_t	_chunkSize = 65536*4;
 };
 
 } // namespace UserInterface
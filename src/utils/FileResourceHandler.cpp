@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileResourceHandler.hpp"
+
+#include <ctime>
+#include <vector>
+
+#include "Logger.hpp"
+#include "Utils.hpp"
+
+namespace {
+
+std::string
+toHttpDate(std::time_t time)
+{
+	std::tm tm;
+	gmtime_r(&time, &tm);
+
+	char buffer[64];
+	const std::size_t size {std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm)};
+
+	return std::string(buffer, size);
+}
+
+} // namespace
+
+std::shared_ptr<FileResourceHandler>
+FileResourceHandler::create(const boost::filesystem::path& path, const std::string& mimeType)
+{
+	return std::make_shared<FileResourceHandler>(path, mimeType);
+}
+
+std::shared_ptr<FileResourceHandler>
+FileResourceHandler::create(std::ifstream ifs, const boost::filesystem::path& path, std::uintmax_t fileSize, std::time_t lastWriteTime, const std::string& mimeType)
+{
+	return std::make_shared<FileResourceHandler>(std::move(ifs), path, fileSize, lastWriteTime, mimeType);
+}
+
+FileResourceHandler::FileResourceHandler(const boost::filesystem::path& path, const std::string& mimeType)
+: _path {path},
+_mimeType {mimeType}
+{
+}
+
+FileResourceHandler::FileResourceHandler(std::ifstream ifs, const boost::filesystem::path& path, std::uintmax_t fileSize, std::time_t lastWriteTime, const std::string& mimeType)
+: _path {path},
+_mimeType {mimeType},
+_ifs {std::move(ifs)},
+_fileSize {fileSize},
+_lastWriteTime {lastWriteTime}
+{
+}
+
+void
+FileResourceHandler::processRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	if (!request.continuation() && !processFirstRequest(request, response))
+		return;
+
+	writeChunk(response);
+
+	if (_remaining > 0 && response.out())
+		response.createContinuation()->setData(shared_from_this());
+}
+
+// Returns false if there is no content to send
+bool
+FileResourceHandler::processFirstRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+	if (!_ifs.is_open())
+	{
+		boost::system::error_code ec;
+
+		_fileSize = boost::filesystem::file_size(_path, ec);
+		if (ec)
+		{
+			LMS_LOG(UTILS, ERROR) << "Cannot get size of file '" << _path.string() << "': " << ec.message();
+			response.setStatus(404);
+			return false;
+		}
+
+		_lastWriteTime = boost::filesystem::last_write_time(_path, ec);
+		if (ec)
+		{
+			LMS_LOG(UTILS, ERROR) << "Cannot get last write time of file '" << _path.string() << "': " << ec.message();
+			response.setStatus(404);
+			return false;
+		}
+	}
+
+	const std::uintmax_t fileSize {_fileSize};
+	const std::time_t lastWriteTime {_lastWriteTime};
+
+	const std::string etag {"\"" + std::to_string(fileSize) + "-" + std::to_string(lastWriteTime) + "\""};
+	const std::string lastModified {toHttpDate(lastWriteTime)};
+
+	response.addHeader("Accept-Ranges", "bytes");
+	response.addHeader("ETag", etag);
+	response.addHeader("Last-Modified", lastModified);
+
+	// Clients usually send back the exact Last-Modified value they got
+	const std::string ifNoneMatch {request.headerValue("If-None-Match")};
+	if ((!ifNoneMatch.empty() && matchesETag(ifNoneMatch, etag))
+			|| (ifNoneMatch.empty() && request.headerValue("If-Modified-Since") == lastModified))
+	{
+		response.setStatus(304);
+		return false;
+	}
+
+	ByteRange range {0, fileSize > 0 ? fileSize - 1 : 0};
+	RangeStatus rangeStatus {parseRange(request.headerValue("Range"), fileSize, range)};
+
+	// The range is only valid for the given version of the file
+	const std::string ifRange {request.headerValue("If-Range")};
+	if (rangeStatus != RangeStatus::None && !ifRange.empty() && ifRange != etag && ifRange != lastModified)
+	{
+		rangeStatus = RangeStatus::None;
+		range = {0, fileSize > 0 ? fileSize - 1 : 0};
+	}
+
+	if (rangeStatus == RangeStatus::Unsatisfiable)
+	{
+		response.setStatus(416);
+		response.addHeader("Content-Range", "bytes */" + std::to_string(fileSize));
+		return false;
+	}
+
+	if (!_ifs.is_open())
+	{
+		_ifs.open(_path.string(), std::ios::binary);
+		if (!_ifs)
+		{
+			LMS_LOG(UTILS, ERROR) << "Cannot open file '" << _path.string() << "'";
+			response.setStatus(404);
+			return false;
+		}
+	}
+
+	_offset = range.first;
+	_remaining = fileSize > 0 ? range.last - range.first + 1 : 0;
+
+	if (rangeStatus == RangeStatus::Valid)
+	{
+		response.setStatus(206);
+		response.addHeader("Content-Range", "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(fileSize));
+	}
+
+	response.setMimeType(_mimeType);
+	response.setContentLength(_remaining);
+
+	if (_offset > 0)
+		_ifs.seekg(static_cast<std::streamoff>(_offset));
+
+	return true;
+}
+
+void
+FileResourceHandler::writeChunk(Wt::Http::Response& response)
+{
+	if (_remaining == 0)
+		return;
+
+	std::vector<char> buffer(static_cast<std::size_t>(std::min<std::uintmax_t>(chunkSize, _remaining)));
+
+	_ifs.read(buffer.data(), buffer.size());
+	const std::streamsize nbReadBytes {_ifs.gcount()};
+	if (nbReadBytes <= 0)
+	{
+		LMS_LOG(UTILS, ERROR) << "Cannot read file '" << _path.string() << "' at offset " << _offset;
+		_remaining = 0;
+		return;
+	}
+
+	response.out().write(buffer.data(), nbReadBytes);
+	if (!response.out())
+	{
+		LMS_LOG(UTILS, ERROR) << "Write failed!";
+		_remaining = 0;
+		return;
+	}
+
+	_offset += nbReadBytes;
+	_remaining -= nbReadBytes;
+}
+
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "ResourceHandler.hpp"
+
+// Serves a file as is, in chunks written using response continuations
+// Handles single range requests (206), and conditional requests using ETag/Last-Modified (304)
+class FileResourceHandler final : public ResourceHandler
+{
+	public:
+		// Extra headers, such as Content-Disposition, may be added to the response before the first call
+		static std::shared_ptr<FileResourceHandler> create(const boost::filesystem::path& path, const std::string& mimeType);
+
+		// Serves an already opened file, that remains readable even if removed in the meantime
+		static std::shared_ptr<FileResourceHandler> create(std::ifstream ifs, const boost::filesystem::path& path, std::uintmax_t fileSize, std::time_t lastWriteTime, const std::string& mimeType);
+
+		void processRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+		FileResourceHandler(const boost::filesystem::path& path, const std::string& mimeType);
+		FileResourceHandler(std::ifstream ifs, const boost::filesystem::path& path, std::uintmax_t fileSize, std::time_t lastWriteTime, const std::string& mimeType);
+
+	private:
+		bool processFirstRequest(const Wt::Http::Request& request, Wt::Http::Response& response);
+		void writeChunk(Wt::Http::Response& response);
+
+		static constexpr std::size_t	chunkSize {65536 * 4};
+
+		const boost::filesystem::path	_path;
+		const std::string		_mimeType;
+
+		std::ifstream			_ifs;	// opened on the first request, unless given
+		std::uintmax_t			_fileSize {};
+		std::time_t			_lastWriteTime {};
+		std::uintmax_t			_offset {};
+		std::uintmax_t			_remaining {};
+};
+
@@ -36,6 +36,7 @@ std::string getModuleName(Module mod)
 		case Module::SIMILARITY:	return "SIMILARITY";
 		case Module::TRANSCODE:		return "TRANSCODE";
 		case Module::UI:		return "UI";
+		case Module::UTILS:		return "UTILS";
 	}
 	return "";
 }
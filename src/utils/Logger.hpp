@@ -48,6 +48,7 @@ enum class Module
 	SIMILARITY,
 	TRANSCODE,
 	UI,
+	UTILS,
 };
 
 std::string getModuleName(Module mod);
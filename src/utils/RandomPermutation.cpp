@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RandomPermutation.hpp"
+
+// splitmix64 finalizer
+static
+std::uint64_t
+mix(std::uint64_t value)
+{
+	value += 0x9e3779b97f4a7c15ULL;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+RandomPermutation::RandomPermutation(std::size_t size, std::uint64_t seed)
+: _size {size}
+{
+	// Balanced Feistel network on the smallest even number of bits that covers size
+	while (_halfBits < 32 && (std::uint64_t {1} << (2 * _halfBits)) < _size)
+		++_halfBits;
+
+	_halfMask = (std::uint64_t {1} << _halfBits) - 1;
+
+	for (std::uint64_t& key : _keys)
+	{
+		seed = mix(seed);
+		key = seed;
+	}
+}
+
+std::size_t
+RandomPermutation::operator[](std::size_t index) const
+{
+	// Cycle walking: the network is a permutation of [0, 4^halfBits), which is less than 4 times size
+	std::uint64_t value {index};
+	do
+	{
+		value = encrypt(value);
+	}
+	while (value >= _size);
+
+	return static_cast<std::size_t>(value);
+}
+
+std::uint64_t
+RandomPermutation::encrypt(std::uint64_t value) const
+{
+	std::uint64_t left {value >> _halfBits};
+	std::uint64_t right {value & _halfMask};
+
+	for (std::uint64_t key : _keys)
+	{
+		const std::uint64_t newRight {left ^ (mix(right ^ key) & _halfMask)};
+		left = right;
+		right = newRight;
+	}
+
+	return (left << _halfBits) | right;
+}
+
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Pseudo random permutation of [0, size)
+// Each element is computed on demand in constant time, without storing the whole permutation
+// The same seed always gives the same order, so that random results can be paginated
+class RandomPermutation
+{
+	public:
+		RandomPermutation(std::size_t size, std::uint64_t seed);
+
+		std::size_t size() const { return _size; }
+
+		// index must be lower than size()
+		std::size_t operator[](std::size_t index) const;
+
+	private:
+		std::uint64_t encrypt(std::uint64_t value) const;
+
+		static constexpr std::size_t nbRounds {4};
+
+		std::size_t	_size;
+		unsigned	_halfBits {1};
+		std::uint64_t	_halfMask;
+		std::array<std::uint64_t, nbRounds> _keys;
+};
+
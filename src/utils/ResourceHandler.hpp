@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+
+// Produces a response that may span several continuations
+// The handler is stored as continuation data, as a std::shared_ptr<ResourceHandler>
+class ResourceHandler : public std::enable_shared_from_this<ResourceHandler>
+{
+	public:
+		virtual ~ResourceHandler() = default;
+
+		// To be called for the first request and then for each continuation
+		virtual void processRequest(const Wt::Http::Request& request, Wt::Http::Response& response) = 0;
+};
+
@@ -155,4 +155,89 @@ stringFromHex(const std::string& str)
 
 }
 
+bool
+matchesETag(const std::string& ifNoneMatch, const std::string& etag)
+{
+	for (std::string tag : splitString(ifNoneMatch, ","))
+	{
+		tag = stringTrim(tag);
+		if (tag == "*")
+			return true;
+
+		// Weak comparison
+		if (tag.compare(0, 2, "W/") == 0)
+			tag = tag.substr(2);
+
+		if (tag == etag)
+			return true;
+	}
+
+	return false;
+}
+
+// Stricter than readAs: no sign, no trailing characters
+static
+boost::optional<std::uintmax_t>
+readByteOffset(const std::string& str)
+{
+	if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+		return boost::none;
+
+	return readAs<std::uintmax_t>(str);
+}
+
+RangeStatus
+parseRange(const std::string& header, std::uintmax_t fileSize, ByteRange& range)
+{
+	static const std::string prefix {"bytes="};
+
+	if (header.compare(0, prefix.size(), prefix) != 0)
+		return RangeStatus::None;
+
+	const std::string spec {stringTrim(header.substr(prefix.size()))};
+	if (spec.find(',') != std::string::npos)
+		return RangeStatus::None;
+
+	const std::size_t dash {spec.find('-')};
+	if (dash == std::string::npos)
+		return RangeStatus::None;
+
+	const std::string firstStr {stringTrim(spec.substr(0, dash))};
+	const std::string lastStr {stringTrim(spec.substr(dash + 1))};
+
+	if (firstStr.empty())
+	{
+		// Suffix: last N bytes
+		boost::optional<std::uintmax_t> suffix {readByteOffset(lastStr)};
+		if (!suffix)
+			return RangeStatus::None;
+		if (*suffix == 0 || fileSize == 0)
+			return RangeStatus::Unsatisfiable;
+
+		range.first = *suffix >= fileSize ? 0 : fileSize - *suffix;
+		range.last = fileSize - 1;
+		return RangeStatus::Valid;
+	}
+
+	boost::optional<std::uintmax_t> first {readByteOffset(firstStr)};
+	if (!first)
+		return RangeStatus::None;
+	if (*first >= fileSize)
+		return RangeStatus::Unsatisfiable;
+
+	range.first = *first;
+	range.last = fileSize - 1;
+
+	if (!lastStr.empty())
+	{
+		boost::optional<std::uintmax_t> last {readByteOffset(lastStr)};
+		if (!last || *last < *first)
+			return RangeStatus::None;
+
+		if (*last < range.last)
+			range.last = *last;
+	}
+
+	return RangeStatus::Valid;
+}
 
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <string>
@@ -67,6 +70,28 @@ replaceInString(std::string str, const std::string& from, const std::string& to)
 boost::optional<std::string>
 stringFromHex(const std::string& str);
 
+// Whether the value of an If-None-Match header matches the given ETag, using the weak comparison
+bool
+matchesETag(const std::string& ifNoneMatch, const std::string& etag);
+
+struct ByteRange
+{
+	std::uintmax_t	first;
+	std::uintmax_t	last;	// included
+};
+
+enum class RangeStatus
+{
+	None,		// no range or not supported: the whole file is sent
+	Valid,
+	Unsatisfiable,
+};
+
+// Parses the value of a Range header, for a file of the given size
+// Only single ranges are handled, multiple ranges are answered with the whole file
+RangeStatus
+parseRange(const std::string& header, std::uintmax_t fileSize, ByteRange& range);
+
 // warning: not efficient
 template<class In, class Out, class U = typename std::iterator_traits<In>::value_type>
 void uniqueAndSortedByOccurence(In first, In last, Out out)
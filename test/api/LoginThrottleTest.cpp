@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "api/subsonic/SubsonicLoginThrottle.hpp"
+
+using namespace API::Subsonic;
+
+int main(int argc, char* argv[])
+{
+	// Refused once the max failures are reached, per user
+	{
+		LoginThrottle throttle {3, std::chrono::seconds {60}};
+
+		for (std::size_t i {}; i < 3; ++i)
+		{
+			assert(!throttle.isThrottled("user"));
+			throttle.addFailure("user");
+		}
+		assert(throttle.isThrottled("user"));
+		assert(!throttle.isThrottled("other"));
+
+		// Still refused, even though a later attempt would have succeeded
+		throttle.addFailure("user");
+		assert(throttle.isThrottled("user"));
+	}
+
+	// Successes clear the failures
+	{
+		LoginThrottle throttle {3, std::chrono::seconds {60}};
+
+		throttle.addFailure("user");
+		throttle.addFailure("user");
+		throttle.addSuccess("user");
+		throttle.addFailure("user");
+		throttle.addFailure("user");
+		assert(!throttle.isThrottled("user"));
+	}
+
+	// Failures older than the window are forgotten
+	{
+		LoginThrottle throttle {2, std::chrono::seconds {1}};
+
+		throttle.addFailure("user");
+		throttle.addFailure("user");
+		assert(throttle.isThrottled("user"));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds {1100});
+		assert(!throttle.isThrottled("user"));
+	}
+
+	// Disabled
+	{
+		LoginThrottle throttle {0, std::chrono::seconds {60}};
+
+		throttle.addFailure("user");
+		assert(!throttle.isEnabled());
+		assert(!throttle.isThrottled("user"));
+	}
+
+	return EXIT_SUCCESS;
+}
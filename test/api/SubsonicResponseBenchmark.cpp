@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+#include "api/subsonic/SubsonicResponse.hpp"
+
+// Measures the peak heap usage of a getArtists-like response, built as a tree or streamed
+// Usage: subsonicresponsebenchmark [nbArtists]
+
+using namespace API::Subsonic;
+
+static std::size_t currentHeapSize {};
+static std::size_t peakHeapSize {};
+
+// Each block is prefixed with its size
+static constexpr std::size_t blockHeaderSize {alignof(std::max_align_t)};
+
+void*
+operator new(std::size_t size)
+{
+	char* block {static_cast<char*>(std::malloc(size + blockHeaderSize))};
+	if (!block)
+		throw std::bad_alloc {};
+
+	*reinterpret_cast<std::size_t*>(block) = size;
+	currentHeapSize += size;
+	if (currentHeapSize > peakHeapSize)
+		peakHeapSize = currentHeapSize;
+
+	return block + blockHeaderSize;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+	if (!ptr)
+		return;
+
+	char* block {static_cast<char*>(ptr) - blockHeaderSize};
+	currentHeapSize -= *reinterpret_cast<std::size_t*>(block);
+	std::free(block);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+// Discards everything, to measure the serialization alone
+class NullBuffer final : public std::streambuf
+{
+	protected:
+		int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+		std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+static
+Response::Node
+createArtistNode(std::size_t i)
+{
+	Response::Node artistNode;
+
+	artistNode.setAttribute("id", "artist-" + std::to_string(i));
+	artistNode.setAttribute("name", "Some artist name #" + std::to_string(i));
+	artistNode.setAttribute("albumCount", std::to_string(i % 10));
+
+	return artistNode;
+}
+
+static
+void
+writeTreeResponse(std::ostream& os, ResponseFormat format, std::size_t nbArtists)
+{
+	Response response {Response::createOkResponse()};
+
+	Response::Node& artistsNode {response.createNode("artists")};
+	Response::Node& indexNode {artistsNode.createArrayChild("index")};
+	indexNode.setAttribute("name", "?");
+
+	for (std::size_t i {}; i < nbArtists; ++i)
+		indexNode.addArrayChild("artist", createArtistNode(i));
+
+	response.write(os, format);
+}
+
+static
+void
+writeStreamedResponse(std::ostream& os, ResponseFormat format, std::size_t nbArtists)
+{
+	ResponseWriter writer {os, format};
+
+	ResponseWriter::Node artistsNode {writer.createNode("artists")};
+	ResponseWriter::Node indexNode {artistsNode.createArrayChild("index")};
+	indexNode.setAttribute("name", "?");
+
+	for (std::size_t i {}; i < nbArtists; ++i)
+		indexNode.addArrayChild("artist", createArtistNode(i));
+
+	writer.finish();
+}
+
+template <typename WriteFunc>
+static
+std::size_t
+measurePeakHeapSize(WriteFunc writeFunc, bool discardOutput)
+{
+	const std::size_t baseHeapSize {currentHeapSize};
+	peakHeapSize = currentHeapSize;
+
+	if (discardOutput)
+	{
+		NullBuffer nullBuffer;
+		std::ostream os {&nullBuffer};
+		writeFunc(os);
+	}
+	else
+	{
+		std::ostringstream oss;
+		writeFunc(oss);
+	}
+
+	return peakHeapSize - baseHeapSize;
+}
+
+int main(int argc, char* argv[])
+{
+	const std::size_t nbArtists {argc > 1 ? static_cast<std::size_t>(std::atol(argv[1])) : std::size_t {5000}};
+
+	std::cout << "Peak heap usage for " << nbArtists << " artists, in KiB (serialization only / with the output buffered)" << std::endl;
+
+	for (ResponseFormat format : {ResponseFormat::xml, ResponseFormat::json})
+	{
+		for (bool streamed : {false, true})
+		{
+			const auto writeFunc {[&](std::ostream& os)
+			{
+				if (streamed)
+					writeStreamedResponse(os, format, nbArtists);
+				else
+					writeTreeResponse(os, format, nbArtists);
+			}};
+
+			const std::size_t serializationSize {measurePeakHeapSize(writeFunc, true)};
+			const std::size_t bufferedSize {measurePeakHeapSize(writeFunc, false)};
+
+			std::cout << std::setw(4) << (format == ResponseFormat::xml ? "xml" : "json")
+				<< std::setw(8) << (streamed ? "stream" : "tree")
+				<< std::setw(10) << serializationSize / 1024
+				<< std::setw(10) << bufferedSize / 1024 << std::endl;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
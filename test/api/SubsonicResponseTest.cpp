@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+
+#include "api/subsonic/SubsonicResponse.hpp"
+#include "utils/Exception.hpp"
+
+using namespace API::Subsonic;
+
+static
+std::string
+writeResponse(Response& response, ResponseFormat format)
+{
+	std::ostringstream oss;
+	response.write(oss, format);
+	return oss.str();
+}
+
+// Same content as the first test, written as it is built
+static
+std::string
+writeStreamedResponse(ResponseFormat format)
+{
+	std::ostringstream oss;
+	ResponseWriter writer {oss, format};
+
+	ResponseWriter::Node indexes {writer.createNode("indexes")};
+	indexes.setAttribute("lastModified", "0");
+
+	ResponseWriter::Node index {indexes.createArrayChild("index")};
+	index.setAttribute("name", "A&B \"<>\"");
+
+	Response::Node artist;
+	artist.setAttribute("name", "Artist\n1");
+	index.addArrayChild("artist", artist);
+
+	indexes.createArrayChild("index").setAttribute("name", "C");
+
+	writer.createNode("license").setValue("a<b");
+
+	writer.finish();
+
+	return oss.str();
+}
+
+template <typename Func>
+static
+bool
+throwsLmsException(Func func)
+{
+	try
+	{
+		func();
+	}
+	catch (const LmsException&)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	// Attributes, arrays, values and escaping
+	{
+		Response response {Response::createOkResponse()};
+
+		Response::Node& indexes {response.createNode("indexes")};
+		indexes.setAttribute("lastModified", "0");
+
+		Response::Node& index {indexes.createArrayChild("index")};
+		index.setAttribute("name", "A&B \"<>\"");
+		index.createArrayChild("artist").setAttribute("name", "Artist\n1");
+		indexes.createArrayChild("index").setAttribute("name", "C");
+
+		Response::Node license;
+		license.setValue("a<b");
+		response.addNode("license", std::move(license));
+
+		assert(writeResponse(response, ResponseFormat::xml) ==
+				"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+				"<subsonic-response status=\"ok\" version=\"1.13.0\">"
+				"<indexes lastModified=\"0\">"
+				"<index name=\"A&amp;B &quot;&lt;&gt;&quot;\"><artist name=\"Artist&#10;1\"/></index>"
+				"<index name=\"C\"/>"
+				"</indexes>"
+				"<license>a&lt;b</license>"
+				"</subsonic-response>");
+
+		assert(writeResponse(response, ResponseFormat::json) ==
+				"{\"subsonic-response\":{\"status\":\"ok\",\"version\":\"1.13.0\","
+				"\"indexes\":{\"lastModified\":\"0\",\"index\":["
+				"{\"name\":\"A&B \\\"<>\\\"\",\"artist\":[{\"name\":\"Artist\\n1\"}]},"
+				"{\"name\":\"C\"}"
+				"]},"
+				"\"license\":{\"value\":\"a<b\"}"
+				"}}");
+
+		assert(writeStreamedResponse(ResponseFormat::xml) == writeResponse(response, ResponseFormat::xml));
+		assert(writeStreamedResponse(ResponseFormat::json) == writeResponse(response, ResponseFormat::json));
+	}
+
+	// Streamed responses are only written once the first node is created
+	{
+		std::ostringstream oss;
+		ResponseWriter writer {oss, ResponseFormat::json};
+		assert(!writer.isStarted());
+		assert(oss.str().empty());
+
+		writer.finish();
+		assert(oss.str() == "{\"subsonic-response\":{\"status\":\"ok\",\"version\":\"1.13.0\"}}");
+	}
+
+	// Streamed nodes can only be modified while they are being written
+	{
+		std::ostringstream oss;
+		ResponseWriter writer {oss, ResponseFormat::json};
+
+		ResponseWriter::Node first {writer.createNode("first")};
+		ResponseWriter::Node child {first.createArrayChild("child")};
+		assert(throwsLmsException([&] { first.setAttribute("id", "1"); }));
+
+		child.setValue("value");
+		assert(throwsLmsException([&] { child.setAttribute("id", "1"); }));
+
+		// Array children must be contiguous in JSON
+		first.createChild("other");
+		assert(throwsLmsException([&] { first.createArrayChild("child"); }));
+
+		writer.createNode("second");
+		assert(throwsLmsException([&] { first.createChild("late"); }));
+	}
+
+	// Setting an attribute twice keeps the last value
+	{
+		Response response {Response::createOkResponse()};
+
+		Response::Node& node {response.createNode("node")};
+		node.setAttribute("id", "1");
+		node.setAttribute("id", "2");
+
+		assert(writeResponse(response, ResponseFormat::json) == "{\"subsonic-response\":{\"status\":\"ok\",\"version\":\"1.13.0\",\"node\":{\"id\":\"2\"}}}");
+	}
+
+	// Errors
+	{
+		Response response {Response::createFailedResponse(Error {Error::Code::RequiredParameterMissing})};
+
+		assert(writeResponse(response, ResponseFormat::xml) ==
+				"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+				"<subsonic-response status=\"failed\" version=\"1.13.0\"><error code=\"10\" message=\"Required parameter is missing.\"/></subsonic-response>");
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "av/AvTranscodeCache.hpp"
+
+using namespace Av;
+
+static
+void
+writeEntry(TranscodeCache& cache, const std::string& key, std::size_t size)
+{
+	const std::string data(size, 'x');
+
+	std::unique_ptr<TranscodeCache::Writer> writer {cache.createWriter(key)};
+	writer->write(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+	writer->commit();
+}
+
+int main(int argc, char* argv[])
+{
+	const boost::filesystem::path directory {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lms-transcodecache-%%%%-%%%%")};
+	const boost::filesystem::path sourceFile {directory / "source"};
+
+	boost::filesystem::create_directories(directory);
+	std::ofstream {sourceFile.string()} << "source";
+	boost::filesystem::last_write_time(sourceFile, std::time(nullptr) - 60);
+
+	const boost::filesystem::path cacheDirectory {directory / "cache"};
+
+	TranscodeParameters parameters {};
+	parameters.encoding = Encoding::MP3;
+	parameters.bitrate = 128000;
+
+	// Keys
+	{
+		assert(TranscodeCache::isCacheable(parameters));
+
+		TranscodeParameters offsetParameters {parameters};
+		offsetParameters.offset = std::chrono::seconds {10};
+		assert(!TranscodeCache::isCacheable(offsetParameters));
+
+		TranscodeParameters otherParameters {parameters};
+		otherParameters.bitrate = 64000;
+		assert(TranscodeCache::computeKey({1, 2, 3}, parameters) == TranscodeCache::computeKey({1, 2, 3}, parameters));
+		assert(TranscodeCache::computeKey({1, 2, 3}, parameters) != TranscodeCache::computeKey({1, 2, 4}, parameters));
+		assert(TranscodeCache::computeKey({1, 2, 3}, parameters) != TranscodeCache::computeKey({1, 2, 3}, otherParameters));
+	}
+
+	// Commit, discard and LRU eviction
+	{
+		TranscodeCache cache {cacheDirectory, 250};
+
+		assert(!cache.get("a", sourceFile));
+
+		writeEntry(cache, "a", 100);
+		writeEntry(cache, "b", 100);
+		{
+			std::unique_ptr<TranscodeCache::Writer> writer {cache.createWriter("discarded")};
+			writer->write(reinterpret_cast<const unsigned char*>("xx"), 2);
+		}
+		assert(!cache.get("discarded", sourceFile));
+
+		assert(cache.get("a", sourceFile));
+		std::unique_ptr<TranscodeCache::CachedFile> cachedFile {cache.get("a", sourceFile)};
+		assert(cachedFile->size == 100);
+		assert(boost::filesystem::file_size(cachedFile->path) == 100);
+
+		// "b" is the least recently used entry
+		writeEntry(cache, "c", 100);
+		assert(!cache.get("b", sourceFile));
+		assert(cache.get("a", sourceFile));
+		assert(cache.get("c", sourceFile));
+
+		// Larger than the whole cache
+		writeEntry(cache, "d", 300);
+		assert(!cache.get("d", sourceFile));
+
+		const TranscodeCache::Stats stats {cache.getStats()};
+		assert(stats.entries == 2);
+		assert(stats.size == 200);
+		assert(stats.evictions == 1);
+		assert(stats.hits == 4);
+		assert(stats.misses == 4);
+	}
+
+	// Reloaded at startup, invalidated once the source file has changed
+	{
+		TranscodeCache cache {cacheDirectory, 250};
+		assert(cache.getStats().entries == 2);
+		std::unique_ptr<TranscodeCache::CachedFile> cachedFile {cache.get("a", sourceFile)};
+		assert(cachedFile);
+
+		boost::filesystem::last_write_time(sourceFile, std::time(nullptr) + 60);
+		assert(!cache.get("a", sourceFile));
+		assert(cache.getStats().entries == 1);
+		assert(!boost::filesystem::exists(cacheDirectory / "a"));
+
+		// Still readable once removed
+		std::vector<char> buffer(200);
+		cachedFile->stream.read(buffer.data(), buffer.size());
+		assert(cachedFile->stream.gcount() == 100);
+	}
+
+	boost::filesystem::remove_all(directory);
+
+	return EXIT_SUCCESS;
+}
+
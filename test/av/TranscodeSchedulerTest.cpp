@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "av/AvTranscodeScheduler.hpp"
+
+using namespace Av;
+
+int main(int argc, char* argv[])
+{
+	// Global limit and priorities
+	{
+		TranscodeScheduler scheduler {2, 0, 0};
+
+		std::unique_ptr<TranscodeScheduler::Ticket> running1 {scheduler.enqueue("user1", TranscodeScheduler::Priority::Playing)};
+		std::unique_ptr<TranscodeScheduler::Ticket> running2 {scheduler.enqueue("user2", TranscodeScheduler::Priority::Playing)};
+		assert(running1 && running2);
+
+		bool running1Admitted {};
+		running1->setAdmittedCallback([&] { running1Admitted = true; });
+		assert(running1Admitted);
+
+		std::vector<std::string> admissions;
+
+		std::unique_ptr<TranscodeScheduler::Ticket> prefetch {scheduler.enqueue("user3", TranscodeScheduler::Priority::Prefetch)};
+		prefetch->setAdmittedCallback([&] { admissions.push_back("prefetch"); });
+		std::unique_ptr<TranscodeScheduler::Ticket> playing {scheduler.enqueue("user4", TranscodeScheduler::Priority::Playing)};
+		playing->setAdmittedCallback([&] { admissions.push_back("playing"); });
+
+		assert(admissions.empty());
+		assert(scheduler.getStats().running == 2);
+		assert(scheduler.getStats().queued == 2);
+
+		running1.reset();
+		assert(admissions == std::vector<std::string> {"playing"});
+
+		running2.reset();
+		assert((admissions == std::vector<std::string> {"playing", "prefetch"}));
+
+		const TranscodeScheduler::Stats stats {scheduler.getStats()};
+		assert(stats.running == 2);
+		assert(stats.queued == 0);
+		assert(stats.admitted == 4);
+		assert(stats.rejected == 0);
+	}
+
+	// Per user limit
+	{
+		TranscodeScheduler scheduler {4, 1, 0};
+
+		std::unique_ptr<TranscodeScheduler::Ticket> running {scheduler.enqueue("user1", TranscodeScheduler::Priority::Playing)};
+
+		bool queuedAdmitted {};
+		std::unique_ptr<TranscodeScheduler::Ticket> queued {scheduler.enqueue("user1", TranscodeScheduler::Priority::Prefetch)};
+		queued->setAdmittedCallback([&] { queuedAdmitted = true; });
+
+		bool otherAdmitted {};
+		std::unique_ptr<TranscodeScheduler::Ticket> other {scheduler.enqueue("user2", TranscodeScheduler::Priority::Prefetch)};
+		other->setAdmittedCallback([&] { otherAdmitted = true; });
+
+		assert(!queuedAdmitted);
+		assert(otherAdmitted);
+		assert(scheduler.getUserLoad("user1") == 2);
+		assert(scheduler.getUserLoad("user2") == 1);
+
+		running.reset();
+		assert(queuedAdmitted);
+		assert(scheduler.getUserLoad("user1") == 1);
+	}
+
+	// Queue size limit, leaving the queue
+	{
+		TranscodeScheduler scheduler {1, 0, 1};
+
+		std::unique_ptr<TranscodeScheduler::Ticket> running {scheduler.enqueue("user1", TranscodeScheduler::Priority::Playing)};
+		std::unique_ptr<TranscodeScheduler::Ticket> queued {scheduler.enqueue("user2", TranscodeScheduler::Priority::Playing)};
+		assert(queued);
+		assert(!scheduler.enqueue("user3", TranscodeScheduler::Priority::Playing));
+		assert(scheduler.getStats().rejected == 1);
+
+		queued.reset();
+		assert(scheduler.getStats().queued == 0);
+		assert(scheduler.getUserLoad("user2") == 0);
+
+		running.reset();
+		assert(scheduler.getStats().running == 0);
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "catalog/CatalogSnapshot.hpp"
+#include "database/Artist.hpp"
+#include "database/DatabaseHandler.hpp"
+
+using namespace Database;
+
+class ScopedFileDeleter final
+{
+	public:
+		ScopedFileDeleter(const boost::filesystem::path& path) : _path {path} {}
+		~ScopedFileDeleter() { boost::filesystem::remove(_path); }
+	private:
+		boost::filesystem::path _path;
+};
+
+#define CHECK(PRED)  \
+{ \
+	if (!(PRED)) \
+	{ \
+		std::string msg {"Predicate '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+		throw std::runtime_error(msg.c_str()); \
+	} \
+}
+
+// The snapshot must list the artists in the same order as the database
+static
+void
+testArtistOrder(Wt::Dbo::Session& session)
+{
+	// name, sort name
+	const std::vector<std::pair<std::string, std::string>> artists
+	{
+		{"The Beatles",	"Beatles, The"},
+		{"beck",	"beck"},
+		{"ABBA",	"ABBA"},
+		{"Zappa",	"Zappa"},
+		{"_Underscore",	"_Underscore"},
+		{"Élodie",	"Élodie"},	// not folded by NOCASE
+		{"élan",	"élan"},
+		{"The The",	"The The"},
+		{"10cc",	"10cc"},
+	};
+
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		for (const auto& artist : artists)
+		{
+			auto created {Artist::create(session, artist.first)};
+			session.flush();
+
+			session.execute("UPDATE artist SET sort_name = ? WHERE id = ?").bind(artist.second).bind(created.id());
+		}
+	}
+
+	bool stopRequested {};
+	std::shared_ptr<Catalog::Snapshot> snapshot {Catalog::Snapshot::build(session, stopRequested)};
+	CHECK(snapshot);
+
+	std::vector<IdType> snapshotIds;
+	for (const Catalog::Snapshot::Artist* artist : snapshot->getArtistsByName())
+		snapshotIds.push_back(artist->id);
+
+	std::vector<IdType> databaseIds;
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		for (const Artist::pointer& artist : Artist::getAll(session))
+			databaseIds.push_back(artist.id());
+	}
+
+	CHECK(snapshotIds.size() == artists.size());
+	CHECK(snapshotIds == databaseIds);
+
+	// Sorted on the sort name, not on the name
+	CHECK(snapshot->getString(snapshot->getArtistsByName()[3]->name) == "The Beatles");
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		boost::filesystem::path tmpFile {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()};
+		ScopedFileDeleter tmpFileDeleter {tmpFile};
+
+		std::unique_ptr<Wt::Dbo::SqlConnectionPool> connectionPool {Handler::createConnectionPool(tmpFile)};
+		Handler::prepareTables(*connectionPool);
+
+		Handler db {*connectionPool};
+
+		testArtistOrder(db.getSession());
+
+		std::cout << "Catalog snapshot test: SUCCESS" << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
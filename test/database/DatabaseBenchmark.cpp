@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+
+#include "database/Artist.hpp"
+#include "database/Cluster.hpp"
+#include "database/DatabaseHandler.hpp"
+#include "database/Release.hpp"
+#include "database/Track.hpp"
+#include "database/TrackArtistLink.hpp"
+
+// Measures the scan insertions and the browse queries throughput for each storage profile
+// Usage: dbbenchmark [nbTracks]
+
+using namespace Database;
+
+class ScopedFileDeleter final
+{
+	public:
+		ScopedFileDeleter(const boost::filesystem::path& path) : _path {path} {}
+		~ScopedFileDeleter()
+		{
+			boost::filesystem::remove(_path);
+			boost::filesystem::remove(_path.string() + "-wal");
+			boost::filesystem::remove(_path.string() + "-shm");
+		}
+	private:
+		boost::filesystem::path _path;
+};
+
+static constexpr std::size_t nbTracksPerRelease {12};
+static constexpr std::size_t nbReleasesPerArtist {5};
+static constexpr std::size_t nbGenres {20};
+static constexpr std::size_t nbBrowseQueries {2000};
+
+static
+double
+getRate(std::size_t count, std::chrono::steady_clock::duration duration)
+{
+	return count / std::chrono::duration<double>(duration).count();
+}
+
+// Same pattern as the scanner: one transaction per file, with lookups by path and MBID
+static
+double
+benchmarkScanInsertions(Wt::Dbo::Session& session, std::size_t nbTracks)
+{
+	std::vector<Cluster::pointer> genres;
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		auto clusterType {ClusterType::create(session, "GENRE")};
+		for (std::size_t i {}; i < nbGenres; ++i)
+			genres.push_back(Cluster::create(session, clusterType, "Genre" + std::to_string(i)));
+	}
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	for (std::size_t i {}; i < nbTracks; ++i)
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		const std::size_t releaseIndex {i / nbTracksPerRelease};
+		const std::size_t artistIndex {releaseIndex / nbReleasesPerArtist};
+		const boost::filesystem::path path {"/music/artist" + std::to_string(artistIndex) + "/release" + std::to_string(releaseIndex) + "/track" + std::to_string(i) + ".mp3"};
+
+		Track::pointer track {Track::getByPath(session, path)};
+		if (!track)
+			track = Track::create(session, path);
+
+		const std::string artistMBID {"artist-" + std::to_string(artistIndex)};
+		Artist::pointer artist {Artist::getByMBID(session, artistMBID)};
+		if (!artist)
+			artist = Artist::create(session, "Artist " + std::to_string(artistIndex), artistMBID);
+
+		const std::string releaseMBID {"release-" + std::to_string(releaseIndex)};
+		Release::pointer release {Release::getByMBID(session, releaseMBID)};
+		if (!release)
+			release = Release::create(session, "Release " + std::to_string(releaseIndex), releaseMBID);
+
+		track.modify()->setName("Track " + std::to_string(i));
+		track.modify()->setTrackNumber(i % nbTracksPerRelease + 1);
+		track.modify()->setRelease(release);
+		track.modify()->setClusters({genres[artistIndex % nbGenres]});
+		track.modify()->clearArtistLinks();
+		track.modify()->addArtistLink(TrackArtistLink::create(session, track, artist, TrackArtistLink::Type::Artist));
+	}
+
+	return getRate(nbTracks, std::chrono::steady_clock::now() - start);
+}
+
+// Mix of the queries run by the UI and the Subsonic API when browsing
+static
+double
+benchmarkBrowseQueries(Wt::Dbo::Session& session)
+{
+	Wt::Dbo::Transaction transaction {session};
+
+	const std::size_t nbReleases {std::max<std::size_t>(Release::getCount(session), 1)};
+	const std::vector<Cluster::pointer> genres {ClusterType::getByName(session, "GENRE")->getClusters()};
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	for (std::size_t i {}; i < nbBrowseQueries; ++i)
+	{
+		bool moreResults;
+
+		switch (i % 4)
+		{
+			case 0:
+				Release::getAll(session, (i * 50) % nbReleases, 50);
+				break;
+
+			case 1:
+				Artist::getByFilter(session, {}, {std::to_string(i % 100)}, 0, 50, moreResults);
+				break;
+
+			case 2:
+				Track::getByFilter(session, {genres[i % genres.size()].id()}, {}, 0, 50, moreResults);
+				break;
+
+			case 3:
+				if (Release::pointer release {Release::getByMBID(session, "release-" + std::to_string(i % nbReleases))})
+					release->getTracks();
+				break;
+		}
+	}
+
+	return getRate(nbBrowseQueries, std::chrono::steady_clock::now() - start);
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const std::size_t nbTracks {argc >= 2 ? std::stoul(argv[1]) : 20000};
+
+		const std::vector<std::pair<std::string, StorageProfile>> profiles
+		{
+			{"low-memory", StorageProfile::LowMemory},
+			{"balanced", StorageProfile::Balanced},
+			{"throughput", StorageProfile::Throughput},
+		};
+
+		std::cout << "Benchmarking with " << nbTracks << " tracks" << std::endl;
+
+		for (const auto& profile : profiles)
+		{
+			boost::filesystem::path tmpFile {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()};
+			ScopedFileDeleter tmpFileDeleter {tmpFile};
+
+			std::unique_ptr<Wt::Dbo::SqlConnectionPool> connectionPool {Handler::createConnectionPool(tmpFile, nullptr, profile.second)};
+			Handler::prepareTables(*connectionPool);
+
+			Handler db {*connectionPool};
+
+			const double insertRate {benchmarkScanInsertions(db.getSession(), nbTracks)};
+			const double browseRate {benchmarkBrowseQueries(db.getSession())};
+
+			std::cout << std::setw(12) << std::left << profile.first << std::fixed << std::setprecision(0)
+				<< "scan insertions: " << insertRate << " tracks/s, "
+				<< "browse queries: " << browseRate << " queries/s" << std::endl;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
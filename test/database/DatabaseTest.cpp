@@ -17,6 +17,7 @@
  * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cstdlib>
 
 #include <boost/filesystem.hpp>
@@ -24,9 +25,11 @@
 #include "database/Artist.hpp"
 #include "database/Cluster.hpp"
 #include "database/DatabaseHandler.hpp"
+#include "database/Maintenance.hpp"
 #include "database/TrackList.hpp"
 #include "database/Release.hpp"
 #include "database/Track.hpp"
+#include "database/User.hpp"
 
 using namespace Database;
 
@@ -964,6 +967,62 @@ testSingleTrackSingleReleaseSingleArtistMultiClusters(Wt::Dbo::Session& session)
 	}
 }
 
+static
+void
+testMultiTracksTrackList(Wt::Dbo::Session& session)
+{
+	std::vector<IdType> trackIds;
+	IdType userId {};
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		for (std::size_t i {}; i < 3; ++i)
+		{
+			auto track {Track::create(session, "MyTrackFile" + std::to_string(i))};
+			session.flush();
+			trackIds.push_back(track.id());
+		}
+
+		auto user {User::create(session)};
+		session.flush();
+		userId = user.id();
+	}
+
+	{
+		Wt::Dbo::Transaction transaction {session};
+
+		auto user {User::getById(session, userId)};
+		CHECK(user);
+		auto trackList {TrackList::create(session, "MyTrackList", TrackList::Type::Playlist, false, user)};
+
+		// Unknown tracks are skipped
+		trackList.modify()->add({trackIds[0], trackIds[1], trackIds[2], trackIds[0], trackIds[2] + 1});
+		CHECK(trackList->getCount() == 4);
+		CHECK(trackList->getTrackIds() == (std::vector<IdType> {trackIds[0], trackIds[1], trackIds[2], trackIds[0]}));
+		CHECK(trackList->getEntry(1)->getTrack().id() == trackIds[1]);
+		CHECK(trackList->getEntriesReverse(0, 1).front()->getTrack().id() == trackIds[0]);
+
+		trackList.modify()->remove({3, 1, 10});
+		CHECK(trackList->getTrackIds() == (std::vector<IdType> {trackIds[0], trackIds[2]}));
+
+		trackList.modify()->add(trackIds[1]);
+		CHECK(trackList->getTrackIds() == (std::vector<IdType> {trackIds[0], trackIds[2], trackIds[1]}));
+
+		trackList.modify()->shuffle();
+		std::vector<IdType> shuffledTrackIds {trackList->getTrackIds()};
+		std::sort(std::begin(shuffledTrackIds), std::end(shuffledTrackIds));
+		CHECK(shuffledTrackIds == trackIds);
+
+		trackList.modify()->clear();
+		CHECK(trackList->getCount() == 0);
+
+		trackList.remove();
+		user.remove();
+		for (IdType trackId : trackIds)
+			Track::getById(session, trackId).remove();
+	}
+}
+
 static
 void
 testDatabaseEmpty(Wt::Dbo::Session& session)
@@ -988,6 +1047,7 @@ int main(int argc, char* argv[])
 		std::cout << "Database test file: '" << tmpFile.string() << "'" << std::endl;
 
 		std::unique_ptr<Wt::Dbo::SqlConnectionPool> connectionPool{ Handler::createConnectionPool(tmpFile) };
+		Handler::prepareTables(*connectionPool);
 
 		Handler db {*connectionPool};
 		Wt::Dbo::Session& session {db.getSession()};
@@ -1025,6 +1085,12 @@ int main(int argc, char* argv[])
 		RUN_TEST(testSingleTrackSingleReleaseSingleArtistSingleCluster);
 		RUN_TEST(testSingleTrackSingleReleaseSingleArtistMultiClusters);
 
+		RUN_TEST(testMultiTracksTrackList);
+
+		std::cout << "Running database maintenance..." << std::endl;
+		Maintenance::run(*connectionPool);
+		CHECK(boost::filesystem::file_size(tmpFile.string() + "-wal") == 0);
+
 	}
 	catch (std::exception& e)
 	{
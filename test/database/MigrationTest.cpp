@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+
+#include <Wt/Dbo/backend/Sqlite3.h>
+
+#include "database/Artist.hpp"
+#include "database/Cluster.hpp"
+#include "database/DatabaseHandler.hpp"
+#include "database/Migration.hpp"
+#include "database/PlayStats.hpp"
+#include "database/Release.hpp"
+#include "database/Track.hpp"
+#include "database/TrackFeatures.hpp"
+#include "database/TrackList.hpp"
+
+using namespace Database;
+
+class ScopedFileDeleter final
+{
+	public:
+		ScopedFileDeleter(const boost::filesystem::path& path) : _path {path} {}
+		~ScopedFileDeleter() { boost::filesystem::remove(_path); }
+	private:
+		boost::filesystem::path _path;
+};
+
+#define CHECK(PRED)  \
+{ \
+	if (!(PRED)) \
+	{ \
+		std::string msg {"Predicate '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+		throw std::runtime_error(msg.c_str()); \
+	} \
+}
+
+// Execute the statements of a fixture, one statement ends with a ';' at the end of a line
+static
+void
+loadFixture(const boost::filesystem::path& fixture, const boost::filesystem::path& dbFile)
+{
+	std::ifstream ifs {fixture.string()};
+	if (!ifs)
+		throw std::runtime_error("Cannot open fixture '" + fixture.string() + "'");
+
+	Wt::Dbo::backend::Sqlite3 connection {dbFile.string()};
+
+	std::string statement;
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (line.empty() || line.compare(0, 2, "--") == 0)
+			continue;
+
+		statement += line + "\n";
+		if (line.back() == ';')
+		{
+			connection.executeSql(statement);
+			statement.clear();
+		}
+	}
+}
+
+// All the fixtures share the same data set
+static
+void
+checkMigratedData(Handler& db)
+{
+	Wt::Dbo::Session& session {db.getSession()};
+	Wt::Dbo::Transaction transaction {session};
+
+	CHECK(VersionInfo::get(session)->getVersion() == LMS_DATABASE_VERSION);
+
+	CHECK(Artist::getAll(session).size() == 2);
+	CHECK(Release::getAll(session).size() == 2);
+	CHECK(Track::getAll(session).size() == 3);
+	CHECK(Cluster::getAll(session).size() == 3);
+	CHECK(ClusterType::getAll(session).size() == 2);
+
+	{
+		auto track {Track::getByPath(session, "/music/A/A2.mp3")};
+		CHECK(track);
+		CHECK(track->getName() == "Track A2");
+		CHECK(track->getRelease());
+		CHECK(track->getRelease()->getName() == "Release A");
+		CHECK(track->getClusters().size() == 2);
+		CHECK(track->getArtists().size() == 1);
+		CHECK(track->getArtists().front()->getName() == "Artist A");
+	}
+
+	{
+		auto artist {Artist::getByMBID(session, "9c9f1380-2516-4fc9-a3e6-f9f61941d090")};
+		CHECK(artist);
+		CHECK(artist->getReleases().size() == 1);
+	}
+
+	{
+		auto track {Track::getByPath(session, "/music/B/B1.mp3")};
+		CHECK(track);
+		CHECK(track->hasTrackFeatures());
+		CHECK(track->getTrackFeatures()->getVector() == std::vector<float> {0.5f});
+
+		auto vectors {TrackFeatures::getAllVectors(session)};
+		CHECK(vectors.size() == 1);
+		CHECK(vectors.front().first == track.id());
+	}
+
+	{
+		auto user {db.getUser("admin")};
+		CHECK(user);
+		CHECK(user->isAdmin());
+		CHECK(user->getSubsonicApiSecret().empty());
+		CHECK(user->getPlayedTrackList()->getCount() == 3);
+		CHECK(user->getPlayedTrackList()->getTrackIds() == (std::vector<IdType> {1, 3, 1}));
+		CHECK(user->getQueuedTrackList()->getCount() == 2);
+
+		auto topTracks {PlayStats::getTopTracks(session, user, 5)};
+		CHECK(topTracks.size() == 2);
+		CHECK(topTracks.front()->getName() == "Track A1");
+
+		auto topReleases {PlayStats::getTopReleases(session, user, 5)};
+		CHECK(topReleases.size() == 2);
+		CHECK(topReleases.front()->getName() == "Release A");
+
+		auto topArtists {PlayStats::getTopArtists(session, user, 1)};
+		CHECK(topArtists.size() == 1);
+		CHECK(topArtists.front()->getName() == "Artist A");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// One fixture per database version that must still be migrated
+	const std::vector<std::string> fixtures
+	{
+		"lms-v3.sql",
+		"lms-v4.sql",
+		"lms-v5.sql",
+		"lms-v6.sql",
+	};
+
+	try
+	{
+		for (const std::string& fixture : fixtures)
+		{
+			std::cout << "Running migration test '" << fixture << "'..." << std::endl;
+
+			boost::filesystem::path tmpFile {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()};
+			ScopedFileDeleter tmpFileDeleter {tmpFile};
+
+			loadFixture(boost::filesystem::path {LMS_DATABASE_FIXTURES_DIR} / fixture, tmpFile);
+
+			std::unique_ptr<Wt::Dbo::SqlConnectionPool> connectionPool {Handler::createConnectionPool(tmpFile)};
+			Handler::prepareTables(*connectionPool);
+
+			{
+				Handler db {*connectionPool};
+				checkMigratedData(db);
+			}
+
+			// Must be idempotent
+			Handler::prepareTables(*connectionPool);
+
+			{
+				Handler db {*connectionPool};
+				checkMigratedData(db);
+			}
+
+			std::cout << "Running migration test '" << fixture << "': SUCCESS" << std::endl;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+
+#include <boost/filesystem.hpp>
+
+#include <Wt/Dbo/FixedSqlConnectionPool.h>
+#include <Wt/Dbo/SqlStatement.h>
+#include <Wt/Dbo/backend/Sqlite3.h>
+
+#include "database/Artist.hpp"
+#include "database/Cluster.hpp"
+#include "database/DatabaseHandler.hpp"
+#include "database/PlayStats.hpp"
+#include "database/TrackList.hpp"
+#include "database/Release.hpp"
+#include "database/Track.hpp"
+#include "database/User.hpp"
+
+// Make sure the queries used on the hot paths are served by indexes:
+// each statement prepared by the database layer is recorded, and its
+// plan is then checked for full scans of the tables that may be large,
+// including full scans of their indexes
+
+using namespace Database;
+
+class ScopedFileDeleter final
+{
+	public:
+		ScopedFileDeleter(const boost::filesystem::path& path) : _path {path} {}
+		~ScopedFileDeleter() { boost::filesystem::remove(_path); }
+	private:
+		boost::filesystem::path _path;
+};
+
+#define CHECK(PRED)  \
+{ \
+	if (!(PRED)) \
+	{ \
+		std::string msg {"Predicate '" + std::string {#PRED} + "' at " + __FUNCTION__ + "@l." + std::to_string(__LINE__)}; \
+		throw std::runtime_error(msg.c_str()); \
+	} \
+}
+
+class RecordingConnection : public Wt::Dbo::backend::Sqlite3
+{
+	public:
+		RecordingConnection(const std::string& db) : Wt::Dbo::backend::Sqlite3 {db} {}
+
+		std::unique_ptr<Wt::Dbo::SqlStatement> prepareStatement(const std::string& sql) override
+		{
+			if (_recording)
+			{
+				if (_fullScanAllowed)
+					_fullScanQueries.insert(sql);
+				else
+					_queries.insert(sql);
+			}
+
+			return Wt::Dbo::backend::Sqlite3::prepareStatement(sql);
+		}
+
+		void setRecording(bool recording) { _recording = recording; }
+		void setFullScanAllowed(bool allowed) { _fullScanAllowed = allowed; }
+
+		// Queries that are expected to use an index
+		std::set<std::string> getQueries() const
+		{
+			std::set<std::string> res;
+			for (const std::string& query : _queries)
+			{
+				if (_fullScanQueries.find(query) == _fullScanQueries.end())
+					res.insert(query);
+			}
+			return res;
+		}
+
+	private:
+		bool _recording {};
+		bool _fullScanAllowed {};
+		std::set<std::string> _queries;
+		std::set<std::string> _fullScanQueries;
+};
+
+// Full reads that are intentional: tables that do not grow with the
+// collection, with the aliases used in the queries
+static const std::set<std::string> fullScanAllowedTables
+{
+	"auth_identity", "auth_info", "auth_token",
+	"cluster_type", "c_type", "c_t",
+	"scan_settings",
+	"similarity_settings", "similarity_settings_feature",
+	"tracklist", "p",
+	"user",
+	"version_info",
+};
+
+// Returns the scanned table, or an empty string if the plan step is not a scan
+// Scans using an index ("SCAN t USING COVERING INDEX ...") still read the whole index
+static
+std::string
+getScannedTable(const std::string& detail)
+{
+	// "SCAN TABLE track AS t" on older versions, "SCAN t" on newer ones
+	static const std::string scanPrefix {"SCAN "};
+	static const std::string tablePrefix {"TABLE "};
+
+	if (detail.compare(0, scanPrefix.size(), scanPrefix) != 0)
+		return {};
+
+	std::string table {detail.substr(scanPrefix.size())};
+	if (table.compare(0, tablePrefix.size(), tablePrefix) == 0)
+		table = table.substr(tablePrefix.size());
+
+	return table.substr(0, table.find(' '));
+}
+
+// Subqueries ("SCAN SUBQUERY 1", "SCAN (subquery-1)") and constant rows
+// ("SCAN CONSTANT ROW", "SCAN 2 CONSTANT ROWS") are not tables
+static
+bool
+isTableScan(const std::string& table)
+{
+	if (table.empty() || table.front() == '(' || std::isdigit(static_cast<unsigned char>(table.front())))
+		return false;
+
+	return table != "SUBQUERY" && table != "CONSTANT";
+}
+
+static
+std::vector<std::string>
+getQueryPlan(Wt::Dbo::SqlConnection& connection, const std::string& sql)
+{
+	std::vector<std::string> res;
+
+	std::unique_ptr<Wt::Dbo::SqlStatement> statement {connection.prepareStatement("EXPLAIN QUERY PLAN " + sql)};
+	statement->execute();
+	while (statement->nextRow())
+	{
+		std::string detail;
+		if (statement->getResult(3, &detail, 0))
+			res.push_back(detail);
+	}
+
+	return res;
+}
+
+static
+void
+fillDatabase(Wt::Dbo::Session& session)
+{
+	Wt::Dbo::Transaction transaction {session};
+
+	auto user {User::create(session)};
+
+	auto genre {ClusterType::create(session, "GENRE")};
+	auto rock {Cluster::create(session, genre, "Rock")};
+	auto jazz {Cluster::create(session, genre, "Jazz")};
+
+	auto artist {Artist::create(session, "MyArtist", "9c9f1380-2516-4fc9-a3e6-f9f61941d090")};
+	auto release {Release::create(session, "MyRelease", "a9b0b0a5-4a25-4b2a-9f5a-4f0a1b2c3d4e")};
+
+	for (std::size_t i {}; i < 4; ++i)
+	{
+		auto track {Track::create(session, "/music/track" + std::to_string(i) + ".mp3")};
+		track.modify()->setName("MyTrack" + std::to_string(i));
+		track.modify()->setRelease(release);
+		track.modify()->setAddedTime(Wt::WDateTime::currentDateTime());
+
+		auto link {TrackArtistLink::create(session, track, artist, TrackArtistLink::Type::Artist)};
+		track.modify()->addArtistLink(link);
+
+		rock.modify()->addTrack(track);
+		if (i % 2)
+			jazz.modify()->addTrack(track);
+	}
+
+	session.flush();
+
+	auto tracks {release->getTracks()};
+	auto playedTracks {user->getPlayedTrackList()};
+	for (const Track::pointer& track : tracks)
+	{
+		playedTracks.modify()->add(track.id());
+		PlayStats::addPlay(session, user, track, Wt::WDateTime::currentDateTime());
+	}
+}
+
+static
+void
+runIndexedQueries(Wt::Dbo::Session& session)
+{
+	Wt::Dbo::Transaction transaction {session};
+
+	auto genre {ClusterType::getByName(session, "GENRE")};
+	CHECK(genre);
+	auto rock {genre->getCluster("Rock")};
+	CHECK(rock);
+	const std::set<IdType> clusterIds {rock.id()};
+	const Wt::WDateTime after {Wt::WDateTime::currentDateTime().addDays(-1)};
+
+	CHECK(genre->getClusters().size() == 2);
+	CHECK(ClusterType::getById(session, genre.id()));
+	CHECK(Cluster::getById(session, rock.id()));
+	CHECK(rock->getTracks(0, 10).size() == 4);
+	CHECK(rock->getTrackIds().size() == 4);
+	{
+		const auto stats {genre->getClustersStats()};
+		CHECK(stats.size() == 2);
+		CHECK(stats[0].name == "Jazz" && stats[0].trackCount == 2 && stats[0].releaseCount == 1);
+		CHECK(stats[1].name == "Rock" && stats[1].trackCount == 4 && stats[1].releaseCount == 1);
+	}
+
+	auto track {Track::getByPath(session, "/music/track0.mp3")};
+	CHECK(track);
+	CHECK(Track::getById(session, track.id()));
+	CHECK(!Track::getByMBID(session, "f2d5b5c2-5a6f-4f38-9e0b-8c1e6f7d5a3b"));
+	CHECK(Track::getByFilter(session, clusterIds).size() == 4);
+	CHECK(Track::getLastAdded(session, after, 2).size() == 2);
+	CHECK(track->getArtists().size() == 1);
+	CHECK(track->getArtistLinks().size() == 1);
+	CHECK(track->getClusters().size() == 1);
+	CHECK(!track->hasTrackFeatures());
+	CHECK(track->getClusterGroups({genre}, 1).size() == 1);
+
+	auto artist {Artist::getByMBID(session, "9c9f1380-2516-4fc9-a3e6-f9f61941d090")};
+	CHECK(artist);
+	CHECK(Artist::getById(session, artist.id()));
+	CHECK(Artist::getByFilter(session, clusterIds).size() == 1);
+	CHECK(Artist::getLastAdded(session, after).size() == 1);
+	CHECK(artist->getReleases().size() == 1);
+	CHECK(artist->getReleases(clusterIds).size() == 1);
+	CHECK(artist->getTracks().size() == 4);
+	CHECK(artist->getTracks(TrackArtistLink::Type::Artist).size() == 4);
+	CHECK(artist->getTracksWithRelease().size() == 4);
+	CHECK(artist->getRandomTracks(2).size() == 2);
+	CHECK(artist->getClusterGroups({genre}, 1).size() == 1);
+
+	auto release {Release::getByMBID(session, "a9b0b0a5-4a25-4b2a-9f5a-4f0a1b2c3d4e")};
+	CHECK(release);
+	CHECK(Release::getById(session, release.id()));
+	CHECK(Release::getByFilter(session, clusterIds).size() == 1);
+	CHECK(Release::getLastAdded(session, after).size() == 1);
+	CHECK(release->getTracks().size() == 4);
+	CHECK(release->getTracks(clusterIds).size() == 4);
+	CHECK(release->getDuration() == std::chrono::milliseconds {0});
+	CHECK(!release->getReleaseYear());
+	CHECK(!release->getCopyright());
+	CHECK(!release->getCopyrightURL());
+	CHECK(release->getArtists().size() == 1);
+	CHECK(release->getReleaseArtists().empty());
+	CHECK(!release->hasVariousArtists());
+	CHECK(release->getClusterGroups({genre}, 1).size() == 1);
+
+	auto users {User::getAll(session)};
+	CHECK(users.size() == 1);
+	auto user {users.front()};
+	CHECK(User::getById(session, user.id()));
+	auto playedTracks {user->getPlayedTrackList()};
+	CHECK(TrackList::getById(session, playedTracks.id()));
+	CHECK(TrackList::getAll(session, user, TrackList::Type::Internal).size() == 1);
+	CHECK(playedTracks->getCount() == 4);
+	CHECK(playedTracks->getEntry(1));
+	CHECK(playedTracks->getEntries(0, 2).size() == 2);
+	CHECK(playedTracks->getEntriesReverse(0, 2).size() == 2);
+	CHECK(playedTracks->getTrackIds().size() == 4);
+	CHECK(playedTracks->hasTrack(track.id()));
+	CHECK(playedTracks->getDuration() == std::chrono::milliseconds {0});
+	CHECK(playedTracks->getClusters().size() == 2);
+	CHECK(PlayStats::getTopArtists(session, user, 5).size() == 1);
+	CHECK(PlayStats::getTopReleases(session, user, 5).size() == 1);
+	CHECK(PlayStats::getTopTracks(session, user, 5, after).size() == 4);
+}
+
+// Listings of a whole table are not expected to use an index
+static
+void
+runListingQueries(Wt::Dbo::Session& session)
+{
+	Wt::Dbo::Transaction transaction {session};
+
+	CHECK(Track::getAll(session).size() == 4);
+	CHECK(Track::getAllRandom(session, 2).size() == 2);
+	CHECK(Track::getMBIDDuplicates(session).empty());
+	CHECK(Track::getChecksumDuplicates(session).empty());
+	CHECK(Artist::getAll(session).size() == 1);
+	CHECK(Artist::getAllOrphans(session).empty());
+	CHECK(Release::getAll(session).size() == 1);
+	CHECK(Release::getAllRandom(session, 1).size() == 1);
+	CHECK(Release::getAllOrphans(session).empty());
+	CHECK(Cluster::getAll(session).size() == 2);
+	CHECK(Cluster::getAllOrphans(session).empty());
+	CHECK(ClusterType::getAll(session).size() == 1);
+}
+
+static
+void
+checkQueryPlans(Wt::Dbo::SqlConnection& connection, const std::set<std::string>& queries)
+{
+	std::size_t nbErrors {};
+
+	for (const std::string& query : queries)
+	{
+		// Only SELECT statements have a query plan worth checking
+		if (query.compare(0, 6, "select") != 0 && query.compare(0, 6, "SELECT") != 0)
+			continue;
+
+		for (const std::string& detail : getQueryPlan(connection, query))
+		{
+			const std::string table {getScannedTable(detail)};
+			if (!isTableScan(table) || fullScanAllowedTables.find(table) != fullScanAllowedTables.end())
+				continue;
+
+			std::cerr << "Full scan of table '" << table << "' (" << detail << ") in query '" << query << "'" << std::endl;
+			++nbErrors;
+		}
+	}
+
+	CHECK(nbErrors == 0);
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		boost::filesystem::path tmpFile {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()};
+		ScopedFileDeleter tmpFileDeleter {tmpFile};
+
+		std::cout << "Query plan test file: '" << tmpFile.string() << "'" << std::endl;
+
+		auto connection {std::make_unique<RecordingConnection>(tmpFile.string())};
+		RecordingConnection& recorder {*connection};
+
+		Wt::Dbo::FixedSqlConnectionPool connectionPool {std::move(connection), 1};
+		Handler::prepareTables(connectionPool);
+
+		Handler db {connectionPool};
+		Wt::Dbo::Session& session {db.getSession()};
+
+		recorder.setRecording(true);
+
+		fillDatabase(session);
+		runIndexedQueries(session);
+
+		recorder.setFullScanAllowed(true);
+		runListingQueries(session);
+
+		recorder.setRecording(false);
+
+		// Use a separate connection to inspect the plans
+		Wt::Dbo::backend::Sqlite3 planConnection {tmpFile.string()};
+		checkQueryPlans(planConnection, recorder.getQueries());
+
+		std::cout << "Checked " << recorder.getQueries().size() << " queries: SUCCESS" << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,276 @@
+-- LMS database, version 6
+-- Schema as created by Wt::Dbo, with a small data set used to check migrations
+
+create table "version_info" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "db_version" integer not null
+);
+
+create table "artist" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "sort_name" text not null,
+  "mbid" text not null
+);
+
+create table "cluster" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "cluster_type_id" bigint,
+  constraint "fk_cluster_cluster_type" foreign key ("cluster_type_id") references "cluster_type" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "cluster_type" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "scan_settings_id" bigint,
+  constraint "fk_cluster_type_scan_settings" foreign key ("scan_settings_id") references "scan_settings" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "tracklist" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "type" integer not null,
+  "public" boolean not null,
+  "user_id" bigint,
+  constraint "fk_tracklist_user" foreign key ("user_id") references "user" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "tracklist_entry" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "position" bigint not null,
+  "track_id" bigint,
+  "tracklist_id" bigint,
+  constraint "fk_tracklist_entry_track" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred,
+  constraint "fk_tracklist_entry_tracklist" foreign key ("tracklist_id") references "tracklist" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "release" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "mbid" text not null,
+  "total_disc_number" integer not null,
+  "total_track_number" integer not null
+);
+
+create table "track" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "scan_version" integer not null,
+  "track_number" integer not null,
+  "disc_number" integer not null,
+  "name" text not null,
+  "duration" integer not null,
+  "year" integer not null,
+  "original_year" integer not null,
+  "file_path" text not null,
+  "file_last_write" text,
+  "file_added" text,
+  "checksum" blob not null,
+  "has_cover" boolean not null,
+  "mbid" text not null,
+  "copyright" text not null,
+  "copyright_url" text not null,
+  "release_id" bigint,
+  constraint "fk_track_release" foreign key ("release_id") references "release" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "track_artist_link" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "type" integer not null,
+  "name" integer not null,
+  "track_id" bigint,
+  "artist_id" bigint,
+  constraint "fk_track_artist_link_track" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred,
+  constraint "fk_track_artist_link_artist" foreign key ("artist_id") references "artist" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "track_features" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "data" text not null,
+  "track_id" bigint, vector BLOB NOT NULL DEFAULT x'',
+  constraint "fk_track_features_track" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "scan_settings" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "scan_version" integer not null,
+  "media_directory" text not null,
+  "start_time" text,
+  "update_period" integer not null,
+  "audio_file_extensions" text not null
+);
+
+create table "similarity_settings" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "settings_version" integer not null,
+  "engine_type" integer not null
+);
+
+create table "similarity_settings_feature" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "name" text not null,
+  "dimension_count" integer not null,
+  "weight" real not null,
+  "similarity_settings_id" bigint,
+  constraint "fk_similarity_settings_feature_similarity_settings" foreign key ("similarity_settings_id") references "similarity_settings" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "auth_info" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "user_id" bigint,
+  "password_hash" varchar(100) not null,
+  "password_method" varchar(20) not null,
+  "password_salt" varchar(20) not null,
+  "status" integer not null,
+  "failed_login_attempts" integer not null,
+  "last_login_attempt" text,
+  "email" varchar(256) not null,
+  "unverified_email" varchar(256) not null,
+  "email_token" varchar(64) not null,
+  "email_token_expires" text,
+  "email_token_role" integer not null,
+  constraint "fk_auth_info_user" foreign key ("user_id") references "user" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "auth_identity" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "auth_info_id" bigint,
+  "provider" varchar(64) not null,
+  "identity" varchar(512) not null,
+  constraint "fk_auth_identity_auth_info" foreign key ("auth_info_id") references "auth_info" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "auth_token" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "auth_info_id" bigint,
+  "value" varchar(64) not null,
+  "expires" text,
+  constraint "fk_auth_token_auth_info" foreign key ("auth_info_id") references "auth_info" ("id") on delete cascade deferrable initially deferred
+);
+
+create table "user" (
+  "id" integer primary key autoincrement,
+  "version" integer not null,
+  "type" integer not null,
+  "max_audio_bitrate" integer not null,
+  "audio_transcode_enable" boolean not null,
+  "audio_transcode_bitrate" integer not null,
+  "audio_transcode_format" integer not null,
+  "cur_playing_track_pos" integer not null,
+  "repeat_all" boolean not null,
+  "radio" boolean not null
+);
+
+create table "track_cluster" (
+  "track_id" bigint,
+  "cluster_id" bigint,
+  primary key ("track_id", "cluster_id"),
+  constraint "fk_track_cluster_key1" foreign key ("track_id") references "track" ("id") on delete cascade deferrable initially deferred,
+  constraint "fk_track_cluster_key2" foreign key ("cluster_id") references "cluster" ("id") on delete cascade deferrable initially deferred
+);
+
+create index "track_cluster_track" on "track_cluster" ("track_id");
+create index "track_cluster_cluster" on "track_cluster" ("cluster_id");
+
+CREATE INDEX IF NOT EXISTS track_path_idx ON track(file_path);
+CREATE INDEX IF NOT EXISTS track_name_idx ON track(name);
+CREATE INDEX IF NOT EXISTS artist_name_idx ON artist(name);
+CREATE INDEX IF NOT EXISTS release_name_idx ON release(name);
+CREATE INDEX IF NOT EXISTS track_release_idx ON track(release_id);
+CREATE INDEX IF NOT EXISTS cluster_name_idx ON cluster(name);
+CREATE INDEX IF NOT EXISTS cluster_type_name_idx ON cluster_type(name);
+CREATE INDEX IF NOT EXISTS tracklist_name_idx ON tracklist(name);
+CREATE INDEX IF NOT EXISTS track_features_track_idx ON track_features(track_id);
+CREATE INDEX IF NOT EXISTS track_mbid_idx ON track(mbid);
+CREATE INDEX IF NOT EXISTS track_file_added_idx ON track(file_added);
+CREATE INDEX IF NOT EXISTS track_checksum_idx ON track(checksum);
+CREATE INDEX IF NOT EXISTS release_mbid_idx ON release(mbid);
+CREATE INDEX IF NOT EXISTS artist_mbid_idx ON artist(mbid);
+CREATE INDEX IF NOT EXISTS track_artist_link_artist_track_type_idx ON track_artist_link(artist_id, track_id, type);
+CREATE INDEX IF NOT EXISTS track_artist_link_track_type_idx ON track_artist_link(track_id, type);
+CREATE INDEX IF NOT EXISTS track_cluster_cluster_track_idx ON track_cluster(cluster_id, track_id);
+CREATE INDEX IF NOT EXISTS cluster_cluster_type_name_idx ON cluster(cluster_type_id, name);
+CREATE INDEX IF NOT EXISTS tracklist_user_type_idx ON tracklist(user_id, type);
+CREATE INDEX IF NOT EXISTS tracklist_entry_tracklist_position_idx ON tracklist_entry(tracklist_id, position);
+CREATE INDEX IF NOT EXISTS tracklist_entry_track_idx ON tracklist_entry(track_id);
+CREATE TABLE IF NOT EXISTS play_stats_track (user_id INTEGER NOT NULL REFERENCES "user"(id) ON DELETE CASCADE,track_id INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE,day INTEGER NOT NULL,count INTEGER NOT NULL,PRIMARY KEY (user_id, track_id, day)) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS play_stats_track_track_id_idx ON play_stats_track(track_id);
+CREATE TABLE IF NOT EXISTS play_stats_release (user_id INTEGER NOT NULL REFERENCES "user"(id) ON DELETE CASCADE,release_id INTEGER NOT NULL REFERENCES release(id) ON DELETE CASCADE,day INTEGER NOT NULL,count INTEGER NOT NULL,PRIMARY KEY (user_id, release_id, day)) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS play_stats_release_release_id_idx ON play_stats_release(release_id);
+CREATE TABLE IF NOT EXISTS play_stats_artist (user_id INTEGER NOT NULL REFERENCES "user"(id) ON DELETE CASCADE,artist_id INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE,day INTEGER NOT NULL,count INTEGER NOT NULL,PRIMARY KEY (user_id, artist_id, day)) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS play_stats_artist_artist_id_idx ON play_stats_artist(artist_id);
+
+insert into "version_info" ("id", "version", "db_version") values (1, 0, 6);
+
+insert into "scan_settings" ("id", "version", "scan_version", "media_directory", "start_time", "update_period", "audio_file_extensions")
+  values (1, 0, 2, '/music', '00:00:00.000', 1, '.mp3 .ogg .flac');
+insert into "cluster_type" ("id", "version", "name", "scan_settings_id") values (1, 0, 'GENRE', 1);
+insert into "cluster_type" ("id", "version", "name", "scan_settings_id") values (2, 0, 'MOOD', 1);
+insert into "cluster" ("id", "version", "name", "cluster_type_id") values (1, 0, 'Rock', 1);
+insert into "cluster" ("id", "version", "name", "cluster_type_id") values (2, 0, 'Jazz', 1);
+insert into "cluster" ("id", "version", "name", "cluster_type_id") values (3, 0, 'Calm', 2);
+
+insert into "similarity_settings" ("id", "version", "settings_version", "engine_type") values (1, 0, 1, 1);
+insert into "similarity_settings_feature" ("id", "version", "name", "dimension_count", "weight", "similarity_settings_id")
+  values (1, 0, 'lowlevel.spectral_energyband_high.mean', 1, 1.0, 1);
+
+insert into "artist" ("id", "version", "name", "sort_name", "mbid") values (1, 0, 'Artist A', 'Artist A', '');
+insert into "artist" ("id", "version", "name", "sort_name", "mbid") values (2, 0, 'Artist B', 'Artist B', '9c9f1380-2516-4fc9-a3e6-f9f61941d090');
+
+insert into "release" ("id", "version", "name", "mbid", "total_disc_number", "total_track_number") values (1, 0, 'Release A', '', 1, 2);
+insert into "release" ("id", "version", "name", "mbid", "total_disc_number", "total_track_number") values (2, 0, 'Release B', '', 1, 1);
+
+insert into "track" ("id", "version", "scan_version", "track_number", "disc_number", "name", "duration", "year", "original_year", "file_path", "file_last_write", "file_added", "checksum", "has_cover", "mbid", "copyright", "copyright_url", "release_id")
+  values (1, 0, 2, 1, 1, 'Track A1', 180000, 1999, 1999, '/music/A/A1.mp3', '2019-01-01T10:00:00.000', '2019-01-02T10:00:00.000', X'0102', 0, '', '', '', 1);
+insert into "track" ("id", "version", "scan_version", "track_number", "disc_number", "name", "duration", "year", "original_year", "file_path", "file_last_write", "file_added", "checksum", "has_cover", "mbid", "copyright", "copyright_url", "release_id")
+  values (2, 0, 2, 2, 1, 'Track A2', 200000, 1999, 1999, '/music/A/A2.mp3', '2019-01-01T10:00:00.000', '2019-01-02T10:00:00.000', X'0304', 0, '', '', '', 1);
+insert into "track" ("id", "version", "scan_version", "track_number", "disc_number", "name", "duration", "year", "original_year", "file_path", "file_last_write", "file_added", "checksum", "has_cover", "mbid", "copyright", "copyright_url", "release_id")
+  values (3, 0, 2, 1, 1, 'Track B1', 240000, 2005, 2005, '/music/B/B1.mp3', '2019-01-01T10:00:00.000', '2019-01-02T10:00:00.000', X'0506', 1, 'd8f6e3a5-4bd4-4bc2-bc5e-d0dfa1b9e1c5', '', '', 2);
+
+insert into "track_artist_link" ("id", "version", "type", "name", "track_id", "artist_id") values (1, 0, 0, 0, 1, 1);
+insert into "track_artist_link" ("id", "version", "type", "name", "track_id", "artist_id") values (2, 0, 0, 0, 2, 1);
+insert into "track_artist_link" ("id", "version", "type", "name", "track_id", "artist_id") values (3, 0, 0, 0, 3, 2);
+
+insert into "track_cluster" ("track_id", "cluster_id") values (1, 1);
+insert into "track_cluster" ("track_id", "cluster_id") values (2, 1);
+insert into "track_cluster" ("track_id", "cluster_id") values (2, 3);
+insert into "track_cluster" ("track_id", "cluster_id") values (3, 2);
+
+insert into "track_features" ("id", "version", "data", "track_id", "vector") values (1, 0, '', 3, X'0000003F');
+
+insert into "user" ("id", "version", "type", "max_audio_bitrate", "audio_transcode_enable", "audio_transcode_bitrate", "audio_transcode_format", "cur_playing_track_pos", "repeat_all", "radio")
+  values (1, 0, 1, 320000, 1, 128000, 1, 1, 1, 0);
+insert into "auth_info" ("id", "version", "user_id", "password_hash", "password_method", "password_salt", "status", "failed_login_attempts", "last_login_attempt", "email", "unverified_email", "email_token", "email_token_expires", "email_token_role")
+  values (1, 0, 1, '$2y$08$TW9ja1NhbHRNb2NrU2FsdOa2k8ZlW3oYc0bq1XfJ5nH4p7rVd9sGy', 'bcrypt', 'MockSaltMockSalt', 1, 0, null, '', '', '', null, 0);
+insert into "auth_identity" ("id", "version", "auth_info_id", "provider", "identity") values (1, 0, 1, 'loginname', 'admin');
+
+insert into "tracklist" ("id", "version", "name", "type", "public", "user_id") values (1, 0, '__played_tracks__', 1, 0, 1);
+insert into "tracklist" ("id", "version", "name", "type", "public", "user_id") values (2, 0, '__queued_tracks__', 1, 0, 1);
+insert into "tracklist_entry" ("id", "version", "position", "track_id", "tracklist_id") values (1, 0, 1024, 1, 1);
+insert into "tracklist_entry" ("id", "version", "position", "track_id", "tracklist_id") values (2, 0, 2048, 3, 1);
+insert into "tracklist_entry" ("id", "version", "position", "track_id", "tracklist_id") values (3, 0, 3072, 1, 1);
+insert into "tracklist_entry" ("id", "version", "position", "track_id", "tracklist_id") values (4, 0, 4096, 2, 2);
+insert into "tracklist_entry" ("id", "version", "position", "track_id", "tracklist_id") values (5, 0, 5120, 3, 2);
+
+insert into play_stats_track (user_id, track_id, day, count) values (1, 1, 18000, 2);
+insert into play_stats_track (user_id, track_id, day, count) values (1, 3, 18000, 1);
+insert into play_stats_release (user_id, release_id, day, count) values (1, 1, 18000, 2);
+insert into play_stats_release (user_id, release_id, day, count) values (1, 2, 18000, 1);
+insert into play_stats_artist (user_id, artist_id, day, count) values (1, 1, 18000, 2);
+insert into play_stats_artist (user_id, artist_id, day, count) values (1, 2, 18000, 1);
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2019 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cassert>
+#include <cstdlib>
+
+#include "utils/Utils.hpp"
+
+static
+bool
+checkRange(const std::string& header, std::uintmax_t fileSize, std::uintmax_t first, std::uintmax_t last)
+{
+	ByteRange range {};
+	return parseRange(header, fileSize, range) == RangeStatus::Valid && range.first == first && range.last == last;
+}
+
+static
+RangeStatus
+getRangeStatus(const std::string& header, std::uintmax_t fileSize)
+{
+	ByteRange range {};
+	return parseRange(header, fileSize, range);
+}
+
+int main(int argc, char* argv[])
+{
+	// ETags
+	{
+		const std::string etag {"\"1234-5678\""};
+
+		assert(matchesETag(etag, etag));
+		assert(matchesETag("W/" + etag, etag));
+		assert(matchesETag("\"other\", " + etag, etag));
+		assert(matchesETag(" * ", etag));
+		assert(!matchesETag("", etag));
+		assert(!matchesETag("\"other\"", etag));
+		assert(!matchesETag("1234-5678", etag));
+	}
+
+	// Single ranges
+	assert(checkRange("bytes=0-99", 1000, 0, 99));
+	assert(checkRange("bytes=100-", 1000, 100, 999));
+	assert(checkRange("bytes=999-999", 1000, 999, 999));
+	assert(checkRange("bytes= 10 - 20 ", 1000, 10, 20));
+
+	// Ranges past the end are truncated, unless they start past the end
+	assert(checkRange("bytes=500-5000", 1000, 500, 999));
+	assert(getRangeStatus("bytes=1000-", 1000) == RangeStatus::Unsatisfiable);
+	assert(getRangeStatus("bytes=1000-2000", 1000) == RangeStatus::Unsatisfiable);
+	assert(getRangeStatus("bytes=0-", 0) == RangeStatus::Unsatisfiable);
+
+	// Suffix ranges
+	assert(checkRange("bytes=-100", 1000, 900, 999));
+	assert(checkRange("bytes=-1000", 1000, 0, 999));
+	assert(checkRange("bytes=-5000", 1000, 0, 999));
+	assert(getRangeStatus("bytes=-0", 1000) == RangeStatus::Unsatisfiable);
+	assert(getRangeStatus("bytes=-100", 0) == RangeStatus::Unsatisfiable);
+
+	// Invalid or unsupported ranges are ignored: the whole file is sent
+	assert(getRangeStatus("", 1000) == RangeStatus::None);
+	assert(getRangeStatus("items=0-99", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=0-99,200-299", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=20-10", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=-", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=100", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=abc-def", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=5x-10", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=--5", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=+5-10", 1000) == RangeStatus::None);
+	assert(getRangeStatus("bytes=99999999999999999999999-", 1000) == RangeStatus::None);
+
+	return EXIT_SUCCESS;
+}
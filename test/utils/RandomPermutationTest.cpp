@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Emeric Poupon
+ *
+ * This file is part of LMS.
+ *
+ * LMS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LMS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "utils/RandomPermutation.hpp"
+
+int main(int argc, char* argv[])
+{
+	// Each size must give a bijection
+	for (std::size_t size : {0, 1, 2, 3, 7, 64, 1000, 4097})
+	{
+		RandomPermutation permutation {size, 42};
+		assert(permutation.size() == size);
+
+		std::vector<bool> seen(size, false);
+		for (std::size_t i {}; i < size; ++i)
+		{
+			const std::size_t value {permutation[i]};
+			assert(value < size);
+			assert(!seen[value]);
+			seen[value] = true;
+		}
+	}
+
+	// Same seed, same order
+	{
+		RandomPermutation permutation1 {1000, 1234};
+		RandomPermutation permutation2 {1000, 1234};
+		for (std::size_t i {}; i < 1000; ++i)
+			assert(permutation1[i] == permutation2[i]);
+	}
+
+	// Different seeds, different orders
+	{
+		RandomPermutation permutation1 {1000, 1};
+		RandomPermutation permutation2 {1000, 2};
+		std::size_t nbDiffs {};
+		for (std::size_t i {}; i < 1000; ++i)
+			if (permutation1[i] != permutation2[i])
+				++nbDiffs;
+
+		assert(nbDiffs > 0);
+	}
+
+	return EXIT_SUCCESS;
+}
+
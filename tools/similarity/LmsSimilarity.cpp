@@ -35,29 +35,18 @@ std::ostream& operator<<(std::ostream& os, const Database::Track::pointer& track
 
 static
 bool
-getTrackFeatures(Wt::Dbo::Session &session, const Database::Track::pointer& track, const std::map<std::string, std::size_t>& featuresSettings, SOM::InputVector& res)
+getTrackFeatures(const Database::Track::pointer& track, SOM::InputVector& res)
 {
-	std::map<std::string, std::vector<double>> features;
-	for (const auto& featureSettings : featuresSettings)
-		features[featureSettings.first] = {};
-
-	if (!track->getTrackFeatures()->getFeatures(features))
+	const std::vector<float> vector {track->getTrackFeatures()->getVector()};
+	if (vector.size() != res.getNbDimensions())
 	{
-		std::cout << "Skipping track '" << track->getMBID() << "': missing item" << std::endl;
+		std::cout << "Skipping track '" << track->getMBID() << "': dimension mismatch" << std::endl;
 		return false;
-	};
-
-	std::size_t index {};
-	for (const auto& feature : features)
-	{
-		auto it = featuresSettings.find(feature.first);
-		if (it == featuresSettings.end() || (feature.second.size() != it->second))
-			return false;
-
-		for (double value : feature.second)
-			res[index++] = value;
 	}
 
+	for (std::size_t i {}; i < vector.size(); ++i)
+		res[i] = vector[i];
+
 	return true;
 }
 
@@ -95,6 +84,7 @@ int main(int argc, char *argv[])
 
 		Database::Handler::configureAuth();
 		auto connectionPool = Database::Handler::createConnectionPool(Config::instance().getPath("working-dir") / "lms.db");
+		Database::Handler::prepareTables(*connectionPool);
 		Database::Handler db(*connectionPool);
 
 		std::cout << "Getting all features..." << std::endl;
@@ -115,7 +105,7 @@ int main(int argc, char *argv[])
 				continue;
 
 			SOM::InputVector features {nbDims};
-			if (!getTrackFeatures(db.getSession(), track, featuresSettings, features))
+			if (!getTrackFeatures(track, features))
 				continue;
 
 			tracksFeatures.emplace_back(std::move(features));
@@ -174,7 +164,7 @@ int main(int argc, char *argv[])
 				continue;
 
 			SOM::InputVector features {nbDims};
-			if (!getTrackFeatures(db.getSession(), track, featuresSettings, features))
+			if (!getTrackFeatures(track, features))
 				continue;
 
 			normalizer.normalizeData(features);
@@ -209,7 +199,7 @@ int main(int argc, char *argv[])
 				continue;
 
 			SOM::InputVector features {nbDims};
-			if (!getTrackFeatures(db.getSession(), track, featuresSettings, features))
+			if (!getTrackFeatures(track, features))
 				continue;
 
 			normalizer.normalizeData(features);
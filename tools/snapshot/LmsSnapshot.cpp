@@ -0,0 +1,143 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "database/DatabaseHandler.hpp"
+#include "database/Snapshot.hpp"
+#include "utils/Config.hpp"
+
+// A snapshot is a directory containing a consistent copy of the database
+// and the similarity features cache, so that a new instance can serve the
+// same library without having to scan it
+
+static
+boost::filesystem::path
+getDatabaseFile()
+{
+	return Config::instance().getPath("working-dir") / "lms.db";
+}
+
+static
+std::vector<boost::filesystem::path>
+getCacheDirectories()
+{
+	return {Config::instance().getPath("working-dir") / "cache" / "features"};
+}
+
+static
+void
+rewriteMediaPrefixes(Wt::Dbo::Session& session, const std::vector<std::pair<std::string, std::string>>& mediaPrefixes)
+{
+	Wt::Dbo::Transaction transaction {session};
+
+	for (const auto& mediaPrefix : mediaPrefixes)
+	{
+		const std::string& oldPrefix {mediaPrefix.first};
+		const std::string& newPrefix {mediaPrefix.second};
+
+		const int nbTracks {session.query<int>("SELECT COUNT(*) FROM track WHERE SUBSTR(file_path, 1, LENGTH(?)) = ?")
+			.bind(oldPrefix).bind(oldPrefix)};
+
+		session.execute("UPDATE track SET file_path = ? || SUBSTR(file_path, LENGTH(?) + 1) WHERE SUBSTR(file_path, 1, LENGTH(?)) = ?")
+			.bind(newPrefix).bind(oldPrefix).bind(oldPrefix).bind(oldPrefix);
+
+		session.execute("UPDATE scan_settings SET media_directory = ? || SUBSTR(media_directory, LENGTH(?) + 1) WHERE SUBSTR(media_directory, 1, LENGTH(?)) = ?")
+			.bind(newPrefix).bind(oldPrefix).bind(oldPrefix).bind(oldPrefix);
+
+		std::cout << "Rewrote '" << oldPrefix << "' into '" << newPrefix << "' for " << nbTracks << " tracks" << std::endl;
+	}
+}
+
+static
+void
+importSnapshot(const boost::filesystem::path& snapshotDirectory, const std::vector<std::pair<std::string, std::string>>& mediaPrefixes, bool force)
+{
+	const boost::filesystem::path dbFile {getDatabaseFile()};
+	if (boost::filesystem::exists(dbFile) && !force)
+		throw std::runtime_error {"Database '" + dbFile.string() + "' already exists, use --force to overwrite it"};
+
+	Database::Snapshot::install(snapshotDirectory, dbFile, getCacheDirectories());
+
+	// Also migrates the snapshot if it comes from an older version
+	auto connectionPool {Database::Handler::createConnectionPool(dbFile)};
+	Database::Handler::prepareTables(*connectionPool);
+
+	Database::Handler db {*connectionPool};
+	rewriteMediaPrefixes(db.getSession(), mediaPrefixes);
+
+	std::cout << "Snapshot imported from '" << snapshotDirectory.string() << "'" << std::endl;
+}
+
+static
+void
+printUsage()
+{
+	std::cerr << "Usage:" << std::endl
+		<< "\tlms-snapshot [--config <file>] export <snapshot directory>" << std::endl
+		<< "\tlms-snapshot [--config <file>] import <snapshot directory> [--force] [--media-prefix <old prefix> <new prefix>]..." << std::endl
+		<< "The server must not be running on the instance a snapshot is imported into" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	boost::filesystem::path configFilePath {"/etc/lms.conf"};
+	std::string command;
+	boost::filesystem::path snapshotDirectory;
+	std::vector<std::pair<std::string, std::string>> mediaPrefixes;
+	bool force {};
+
+	for (int i {1}; i < argc; ++i)
+	{
+		const std::string arg {argv[i]};
+
+		if (arg == "--config" && i + 1 < argc)
+			configFilePath = argv[++i];
+		else if (arg == "--media-prefix" && i + 2 < argc)
+		{
+			mediaPrefixes.emplace_back(argv[i + 1], argv[i + 2]);
+			i += 2;
+		}
+		else if (arg == "--force")
+			force = true;
+		else if (command.empty())
+			command = arg;
+		else if (snapshotDirectory.empty())
+			snapshotDirectory = arg;
+		else
+		{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((command != "export" && command != "import") || snapshotDirectory.empty()
+			|| (command == "export" && (!mediaPrefixes.empty() || force)))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		Config::instance().setFile(configFilePath);
+
+		if (command == "export")
+			Database::Snapshot::create(getDatabaseFile(), getCacheDirectories(), snapshotDirectory);
+		else
+		{
+			Database::Handler::configureAuth();
+			importSnapshot(snapshotDirectory, mediaPrefixes, force);
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Caught exception: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}